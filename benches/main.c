@@ -0,0 +1,788 @@
+#include <str.h>
+#include <parse.h>
+#include <interpreter.h>
+#include <program.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <malloc.h>
+
+/// Shortest duration of one measured round
+uint64_t constexpr BENCH_ROUND_NS = 50000000;
+size_t constexpr BENCH_N_ROUNDS = 5;
+
+/// Runs `n_iterations` operations and returns the amount of work done in
+/// `unit`s, e.g. bytes
+typedef double (*BenchFunction)(void* context, size_t n_iterations);
+
+typedef struct Bench {
+    char const* name;
+    /// Unit of the throughput, `op` if an iteration is the unit itself
+    char const* unit;
+    BenchFunction run;
+} Bench;
+
+/// Stops the compiler from optimizing the result of a benchmark away
+static volatile size_t bench_sink;
+
+static uint64_t bench_now_ns() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (uint64_t) time.tv_sec * 1000000000 + (uint64_t) time.tv_nsec;
+}
+
+static int bench_compare_doubles(void const* a, void const* b) {
+    auto x = *(double const*) a;
+    auto y = *(double const*) b;
+
+    return (x > y) - (x < y);
+}
+
+/// Doubles the number of iterations until a round takes long enough, then
+/// measures `BENCH_N_ROUNDS` rounds. Writes one JSON object per line.
+static void bench_run(Bench bench, void* context, FILE* report) {
+    size_t n_iterations = 1;
+
+    while (true) {
+        auto start = bench_now_ns();
+        bench.run(context, n_iterations);
+
+        if (bench_now_ns() - start >= BENCH_ROUND_NS / 10) {
+            break;
+        }
+
+        n_iterations *= 2;
+    }
+
+    // Scale the calibration round up to the full round duration
+    auto start = bench_now_ns();
+    bench.run(context, n_iterations);
+    auto elapsed = (double) (bench_now_ns() - start);
+    n_iterations = (size_t) ((double) n_iterations * BENCH_ROUND_NS / elapsed);
+    n_iterations = 0 == n_iterations ? 1 : n_iterations;
+
+    double ns_per_iteration[BENCH_N_ROUNDS];
+    double work = 0.0;
+
+    for (size_t i = 0; i < BENCH_N_ROUNDS; ++i) {
+        start = bench_now_ns();
+        work = bench.run(context, n_iterations);
+        elapsed = (double) (bench_now_ns() - start);
+
+        ns_per_iteration[i] = elapsed / (double) n_iterations;
+    }
+
+    qsort(
+        ns_per_iteration, BENCH_N_ROUNDS, sizeof(double), bench_compare_doubles
+    );
+
+    auto median = ns_per_iteration[BENCH_N_ROUNDS / 2];
+    auto work_per_iteration = work / (double) n_iterations;
+
+    fprintf(
+        report,
+        "{\"name\": \"%s\", \"iterations\": %zu, \"rounds\": %zu, "
+        "\"ns_per_iter\": %.3f, \"min_ns_per_iter\": %.3f, "
+        "\"throughput\": %.1f, \"unit\": \"%s/s\"}\n",
+        bench.name, n_iterations, BENCH_N_ROUNDS, median, ns_per_iteration[0],
+        work_per_iteration * 1e9 / median, bench.unit
+    );
+    fflush(report);
+}
+
+/// Script the parsing benchmarks run over, typical commands and comments
+static char BENCH_SCRIPT[] =
+    "# Library comparison\n"
+    "use build/libtest1.so\n"
+    "use build/libtest2.so as second # aliased\n"
+    "call foo\n"
+    "call second.bar\n"
+    "\n"
+    "compare baz build/libtest1.so build/libtest2.so\n"
+    "call qux # only in the second library\n";
+
+typedef struct ReadlineContext {
+    String script;
+} ReadlineContext;
+
+static double bench_readline(void* context, size_t n_iterations) {
+    ReadlineContext* self = context;
+    auto line = STRING_EMPTY;
+    size_t n_lines = 0;
+
+    for (size_t i = 0; i < n_iterations; ++i) {
+        auto stream = fmemopen(self->script.str.ptr, self->script.str.len, "r");
+
+        while (READLINE_EOF != string_readline(&line, stream)) {
+            n_lines += line.str.len;
+            string_clear(&line);
+        }
+
+        fclose(stream);
+    }
+
+    bench_sink = n_lines;
+    string_free(&line);
+
+    return (double) (n_iterations * self->script.str.len);
+}
+
+static double bench_command_line_parse(void* context, size_t n_iterations) {
+    (void) context;
+
+    Str lines[16];
+    size_t n_lines = 0;
+    auto script = Str(BENCH_SCRIPT);
+
+    for (size_t start = 0, i = 0; i < script.len; ++i) {
+        if ('\n' == script.ptr[i]) {
+            lines[n_lines++] = str_slice(script, start, i);
+            start = i + 1;
+        }
+    }
+
+    size_t n_commands = 0;
+
+    for (size_t i = 0; i < n_iterations; ++i) {
+        auto result = command_line_parse(lines[i % n_lines]);
+        n_commands += result.value.has_command;
+    }
+
+    bench_sink = n_commands;
+
+    return (double) n_iterations;
+}
+
+static double bench_str_hash(void* context, size_t n_iterations) {
+    (void) context;
+
+    Str names[] = {
+        Str("foo"),
+        Str("second.bar"),
+        Str("compute_checksum"),
+        Str("library_function_with_a_long_name"),
+    };
+    size_t n_names = sizeof(names) / sizeof(*names);
+    size_t hash = 0;
+    size_t n_bytes = 0;
+
+    for (size_t i = 0; i < n_iterations; ++i) {
+        auto name = &names[i % n_names];
+        hash ^= str_hash(name);
+        n_bytes += name->len;
+    }
+
+    bench_sink = hash;
+
+    return (double) n_bytes;
+}
+
+static double bench_murmur_hash(void* context, size_t n_iterations) {
+    (void) context;
+
+    static uint8_t buffer[4096];
+    size_t hash = 0;
+
+    for (size_t i = 0; i < n_iterations; ++i) {
+        hash ^= murmur_hash(buffer, sizeof(buffer), i);
+    }
+
+    bench_sink = hash;
+
+    return (double) (n_iterations * sizeof(buffer));
+}
+
+static double bench_resolve(void* context, size_t n_iterations) {
+    Executor* executor = ((void**) context)[0];
+    Str* name = ((void**) context)[1];
+    size_t n_found = 0;
+
+    for (size_t i = 0; i < n_iterations; ++i) {
+        auto result = executor_resolve_function(executor, *name);
+        n_found += EXECUTOR_SUCCESS == result.result.status;
+    }
+
+    bench_sink = n_found;
+
+    return (double) n_iterations;
+}
+
+static double bench_load_library(void* context, size_t n_iterations) {
+    (void) context;
+
+    size_t n_loaded = 0;
+
+    for (size_t i = 0; i < n_iterations; ++i) {
+        auto executor = executor_new();
+        auto result =
+            executor_load_library(&executor, Str("build/libtest1.so"));
+        n_loaded += EXECUTOR_SUCCESS == result.status;
+        executor_free(&executor);
+    }
+
+    bench_sink = n_loaded;
+
+    return (double) n_iterations;
+}
+
+static double bench_call_function(void* context, size_t n_iterations) {
+    Executor* executor = context;
+    size_t n_called = 0;
+
+    for (size_t i = 0; i < n_iterations; ++i) {
+        auto result =
+            executor_call_function(executor, Str("__errno_location"));
+        n_called += EXECUTOR_SUCCESS == result.status;
+    }
+
+    bench_sink = n_called;
+
+    return (double) n_iterations;
+}
+
+/// Calls in the procedure of `bench_run_procedure`
+size_t constexpr BENCH_PROCEDURE_LEN = 4;
+
+static double bench_run_procedure(void* context, size_t n_iterations) {
+    Executor* executor = context;
+    size_t n_run = 0;
+
+    for (size_t i = 0; i < n_iterations; ++i) {
+        auto result = executor_run_procedure(executor, Str("workload"));
+        n_run += EXECUTOR_SUCCESS == result.status;
+    }
+
+    bench_sink = n_run;
+
+    return (double) (n_iterations * BENCH_PROCEDURE_LEN);
+}
+
+static double bench_program_repeat(void* context, size_t n_iterations) {
+    Executor* executor = context;
+    auto program = PROGRAM_EMPTY;
+    auto repeat = (Command) {
+        .type = COMMAND_TYPE_REPEAT,
+        .count = n_iterations,
+        .body = Str("call __errno_location"),
+    };
+
+    // Includes compiling the loop, which is amortized as in a script
+    program_add(&program, executor, &repeat);
+    program_run(&program);
+    program_free(&program);
+
+    return (double) n_iterations;
+}
+
+static double bench_program_repeat_typed(void* context, size_t n_iterations) {
+    Executor* executor = context;
+    auto program = PROGRAM_EMPTY;
+    auto repeat = (Command) {
+        .type = COMMAND_TYPE_REPEAT,
+        .count = n_iterations,
+        .body = Str("call add(i64 1, i64 2) -> i64"),
+    };
+
+    program_add(&program, executor, &repeat);
+    program_run(&program);
+    program_free(&program);
+
+    return (double) n_iterations;
+}
+
+#ifdef SYNTHETIC_SCRIPT
+// Built with `-DSOTEST_SYNTHETIC=ON`, measures how the same paths scale with
+// generated libraries and scripts
+
+// The allocator entry points below replace the ones of the whole process,
+// libc and the dynamic loader included, count the calls and forward them to
+// glibc. The bench is single-threaded.
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void* ptr);
+
+/// Allocator calls and heap in use since the start of the process
+typedef struct BenchHeap {
+    /// Calls of `malloc`, `calloc`, `realloc` and the aligned allocations
+    size_t n_allocations;
+    size_t n_frees;
+    /// Usable bytes of the blocks not yet freed
+    size_t bytes;
+    /// Highest `bytes` since the last `bench_heap_reset_peak`
+    size_t peak_bytes;
+} BenchHeap;
+
+static BenchHeap bench_heap;
+
+static void* bench_heap_add(void* ptr) {
+    if (nullptr == ptr) {
+        return ptr;
+    }
+
+    bench_heap.n_allocations += 1;
+    bench_heap.bytes += malloc_usable_size(ptr);
+
+    if (bench_heap.bytes > bench_heap.peak_bytes) {
+        bench_heap.peak_bytes = bench_heap.bytes;
+    }
+
+    return ptr;
+}
+
+static void bench_heap_remove(void* ptr) {
+    if (nullptr != ptr) {
+        bench_heap.bytes -= malloc_usable_size(ptr);
+    }
+}
+
+static void bench_heap_reset_peak() { bench_heap.peak_bytes = bench_heap.bytes; }
+
+void* malloc(size_t size) { return bench_heap_add(__libc_malloc(size)); }
+
+void* calloc(size_t n, size_t size) {
+    return bench_heap_add(__libc_calloc(n, size));
+}
+
+void* realloc(void* ptr, size_t size) {
+    bench_heap_remove(ptr);
+    auto result = __libc_realloc(ptr, size);
+
+    // A failed `realloc` keeps the old block
+    if (nullptr == result && 0 != size) {
+        return bench_heap_add(ptr);
+    }
+
+    return bench_heap_add(result);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    return bench_heap_add(__libc_memalign(alignment, size));
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) {
+    auto result = memalign(alignment, size);
+
+    if (nullptr == result) {
+        return ENOMEM;
+    }
+
+    *ptr = result;
+    return 0;
+}
+
+void free(void* ptr) {
+    if (nullptr != ptr) {
+        bench_heap.n_frees += 1;
+    }
+
+    bench_heap_remove(ptr);
+    __libc_free(ptr);
+}
+
+static double bench_synthetic_parse(void* context, size_t n_iterations) {
+    String* script = context;
+    auto line = STRING_EMPTY;
+    size_t n_lines = 0;
+    size_t n_commands = 0;
+
+    for (size_t i = 0; i < n_iterations; ++i) {
+        auto stream = fmemopen(script->str.ptr, script->str.len, "r");
+
+        while (READLINE_EOF != string_readline(&line, stream)) {
+            auto result = command_line_parse(line.str);
+            n_commands += result.value.has_command;
+            n_lines += 1;
+            string_clear(&line);
+        }
+
+        fclose(stream);
+    }
+
+    bench_sink = n_commands;
+    string_free(&line);
+
+    return (double) n_lines;
+}
+
+static void bench_synthetic_load_all(Executor* executor) {
+    char path[4096];
+
+    for (size_t i = 0; i < SYNTHETIC_LIBRARIES; ++i) {
+        snprintf(path, sizeof(path), SYNTHETIC_PREFIX "%zu.so", i);
+        executor_load_library(executor, str_from_ptr(path));
+    }
+}
+
+static double bench_synthetic_load(void* context, size_t n_iterations) {
+    (void) context;
+
+    for (size_t i = 0; i < n_iterations; ++i) {
+        auto executor = executor_new();
+        bench_synthetic_load_all(&executor);
+        executor_free(&executor);
+    }
+
+    return (double) (n_iterations * SYNTHETIC_LIBRARIES);
+}
+
+static double bench_synthetic_exports(void* context, size_t n_iterations) {
+    ElfImage* image = context;
+    char name[64];
+    size_t n_found = 0;
+    size_t n_shared = SYNTHETIC_SHARED;
+
+    for (size_t i = 0; i < n_iterations; ++i) {
+        // Hits on even, misses on odd iterations. Hits are named the way
+        // `tools/synthetic.c` names the exports of the first library.
+        auto function = i / 2 % SYNTHETIC_FUNCTIONS;
+        int len = 0;
+
+        if (0 != i % 2) {
+            len = snprintf(name, sizeof(name), "missing_%zu", i);
+        } else if (function < n_shared) {
+            len = snprintf(name, sizeof(name), "shared_%zu", function);
+        } else {
+            len = snprintf(name, sizeof(name), "lib0_%zu", function);
+        }
+
+        n_found += elf_image_exports(
+            image, (Str) {.ptr = name, .len = (size_t) len}
+        );
+    }
+
+    bench_sink = n_found;
+
+    return (double) n_iterations;
+}
+
+/// Resolves every exported function of the synthetic libraries once, the
+/// names a session of that many symbols interns. Writes the allocator calls,
+/// the heap it took at the end and at its peak, and the blocks of the
+/// executor's arena as one JSON object.
+static void bench_synthetic_session(FILE* report) {
+    auto before = bench_heap;
+    bench_heap_reset_peak();
+
+    auto executor = executor_new();
+    bench_synthetic_load_all(&executor);
+
+    char name[64];
+    size_t n_found = 0;
+    auto start = bench_now_ns();
+
+    for (size_t i = 0; i < SYNTHETIC_LIBRARIES; ++i) {
+        for (size_t j = SYNTHETIC_SHARED; j < SYNTHETIC_FUNCTIONS; ++j) {
+            auto len = snprintf(name, sizeof(name), "lib%zu_%zu", i, j);
+            auto result = executor_resolve_function(
+                &executor, (Str) {.ptr = name, .len = (size_t) len}
+            );
+            n_found += EXECUTOR_SUCCESS == result.result.status;
+        }
+    }
+
+    auto elapsed = bench_now_ns() - start;
+    auto after = bench_heap;
+
+    fprintf(
+        report,
+        "{\"name\": \"synthetic_resolve_session\", \"symbols\": %zu, "
+        "\"ns_per_symbol\": %.3f, \"allocations\": %zu, \"frees\": %zu, "
+        "\"heap_bytes\": %zu, \"peak_heap_bytes\": %zu, "
+        "\"arena_bytes\": %zu, \"arena_blocks\": %zu}\n",
+        n_found, (double) elapsed / (double) (0 == n_found ? 1 : n_found),
+        after.n_allocations - before.n_allocations,
+        after.n_frees - before.n_frees, after.bytes - before.bytes,
+        after.peak_bytes - before.bytes, executor.arena.n_bytes,
+        executor.arena.n_blocks
+    );
+    fflush(report);
+
+    executor_free(&executor);
+}
+
+static void bench_synthetic(FILE* report) {
+    auto script = STRING_EMPTY;
+    auto stream = fopen(SYNTHETIC_SCRIPT, "r");
+
+    if (nullptr != stream) {
+        for (int symbol; EOF != (symbol = fgetc(stream));) {
+            string_push(&script, (char) symbol);
+        }
+
+        fclose(stream);
+    }
+
+    bench_run(
+        (Bench) {
+            .name = "synthetic_script_parse",
+            .unit = "line",
+            .run = bench_synthetic_parse,
+        },
+        &script, report
+    );
+    string_free(&script);
+
+    bench_run(
+        (Bench) {
+            .name = "synthetic_load_library",
+            .unit = "library",
+            .run = bench_synthetic_load,
+        },
+        nullptr, report
+    );
+
+    // Misses go through `dlsym` of every loaded library
+    auto executor = executor_new();
+    bench_synthetic_load_all(&executor);
+
+    auto miss_name = Str("missing");
+    void* miss_context[] = {&executor, &miss_name};
+    bench_run(
+        (Bench) {
+            .name = "synthetic_resolve_miss",
+            .unit = "op",
+            .run = bench_resolve,
+        },
+        miss_context, report
+    );
+    executor_free(&executor);
+
+    bench_synthetic_session(report);
+
+    auto image = elf_image_open(Str(SYNTHETIC_PREFIX "0.so"));
+
+    if (ELF_SUCCESS == image.status) {
+        bench_run(
+            (Bench) {
+                .name = "synthetic_elf_exports",
+                .unit = "op",
+                .run = bench_synthetic_exports,
+            },
+            &image.value, report
+        );
+        elf_image_free(&image.value);
+    }
+}
+#endif
+
+int main() {
+    // Keep the report machine-readable if a library prints something
+    auto report = fdopen(dup(STDOUT_FILENO), "w");
+    freopen("/dev/null", "w", stdout);
+
+    auto readline_context = (ReadlineContext) {.script = STRING_EMPTY};
+
+    for (size_t i = 0; i < 1024; ++i) {
+        string_append(&readline_context.script, Str(BENCH_SCRIPT));
+    }
+
+    bench_run(
+        (Bench) {
+            .name = "string_readline",
+            .unit = "byte",
+            .run = bench_readline,
+        },
+        &readline_context, report
+    );
+    string_free(&readline_context.script);
+
+    bench_run(
+        (Bench) {
+            .name = "command_line_parse",
+            .unit = "line",
+            .run = bench_command_line_parse,
+        },
+        nullptr, report
+    );
+    bench_run(
+        (Bench) {
+            .name = "str_hash",
+            .unit = "byte",
+            .run = bench_str_hash,
+        },
+        nullptr, report
+    );
+    bench_run(
+        (Bench) {
+            .name = "murmur_hash",
+            .unit = "byte",
+            .run = bench_murmur_hash,
+        },
+        nullptr, report
+    );
+
+    // Before any other executor keeps the library open, so that `dlopen` maps
+    // and relocates it every time
+    bench_run(
+        (Bench) {
+            .name = "executor_load_library",
+            .unit = "op",
+            .run = bench_load_library,
+        },
+        nullptr, report
+    );
+
+    // Functions are cached by name after the first resolution, the hit is a
+    // single map lookup
+    auto executor = executor_new();
+    executor_load_library(&executor, Str("build/libtest1.so"));
+
+    auto hit_name = Str("foo");
+    void* hit_context[] = {&executor, &hit_name};
+    bench_run(
+        (Bench) {
+            .name = "function_map_hit",
+            .unit = "op",
+            .run = bench_resolve,
+        },
+        hit_context, report
+    );
+
+    // A lazy executor without libraries stops right after the map lookup
+    auto lazy_executor = executor_with_options((ExecutorOptions) {
+        .is_lazy = true,
+    });
+    auto miss_name = Str("missing");
+    void* miss_context[] = {&lazy_executor, &miss_name};
+    bench_run(
+        (Bench) {
+            .name = "function_map_miss",
+            .unit = "op",
+            .run = bench_resolve,
+        },
+        miss_context, report
+    );
+    executor_free(&lazy_executor);
+
+    // `dlsym` finds libc functions through the library's dependencies, this
+    // one does no work, so only the dispatch is measured
+    bench_run(
+        (Bench) {
+            .name = "executor_call_function",
+            .unit = "op",
+            .run = bench_call_function,
+        },
+        &executor, report
+    );
+
+    // The same calls resolved up front, a run is one map lookup for all.
+    // The calls are made by a compiled thunk, or in a loop without the JIT.
+    auto interpreted = executor_with_options((ExecutorOptions) {
+        .is_jit_disabled = true,
+    });
+    executor_load_library(&interpreted, Str("build/libtest1.so"));
+
+    Executor* procedure_executors[] = {&executor, &interpreted};
+    char const* procedure_names[] = {
+        "executor_run_procedure",
+        "executor_run_procedure_no_jit",
+    };
+
+    for (size_t i = 0; i < 2; ++i) {
+        auto procedure = executor_define_procedure(
+            procedure_executors[i], Str("workload")
+        );
+
+        for (size_t j = 0; j < BENCH_PROCEDURE_LEN; ++j) {
+            procedure_add_call(procedure, Str("__errno_location"), false);
+        }
+
+        bench_run(
+            (Bench) {
+                .name = procedure_names[i],
+                .unit = "call",
+                .run = bench_run_procedure,
+            },
+            procedure_executors[i], report
+        );
+    }
+
+    char const* repeat_names[] = {"program_repeat", "program_repeat_no_jit"};
+
+    for (size_t i = 0; i < 2; ++i) {
+        bench_run(
+            (Bench) {
+                .name = repeat_names[i],
+                .unit = "op",
+                .run = bench_program_repeat,
+            },
+            procedure_executors[i], report
+        );
+    }
+
+    // The arguments go through the cached stub of the signature, compare
+    // with `program_repeat`
+    bench_run(
+        (Bench) {
+            .name = "program_repeat_typed",
+            .unit = "op",
+            .run = bench_program_repeat_typed,
+        },
+        &executor, report
+    );
+
+    // Calls counted in the live stats segment, in chunks of `MONITOR_CHUNK`
+    auto monitor = (Monitor) {};
+
+    if (monitor_start(&monitor)) {
+        auto monitored = executor_with_options((ExecutorOptions) {
+            .monitor = &monitor,
+        });
+        executor_load_library(&monitored, Str("build/libtest1.so"));
+
+        bench_run(
+            (Bench) {
+                .name = "program_repeat_monitored",
+                .unit = "op",
+                .run = bench_program_repeat,
+            },
+            &monitored, report
+        );
+
+        executor_free(&monitored);
+        monitor_stop(&monitor);
+    }
+
+    // Calls sampled for the memory report, two samples per period
+    auto footprint = (Footprint) {};
+    footprint_start(&footprint, FOOTPRINT_DEFAULT_PERIOD, 0, nullptr);
+
+    auto measured = executor_with_options((ExecutorOptions) {
+        .footprint = &footprint,
+    });
+    executor_load_library(&measured, Str("build/libtest1.so"));
+
+    bench_run(
+        (Bench) {
+            .name = "program_repeat_measured",
+            .unit = "op",
+            .run = bench_program_repeat,
+        },
+        &measured, report
+    );
+
+    executor_free(&measured);
+    footprint_free(&footprint);
+
+    executor_free(&interpreted);
+    executor_free(&executor);
+
+#ifdef SYNTHETIC_SCRIPT
+    bench_synthetic(report);
+#endif
+
+    fclose(report);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,9 @@
+# Benchmark example
+# Run with `--history <PATH>` to record the results, add `--baseline` to fail
+# on regressions against the recorded ones
+
+use build/libtest1.so
+use build/libtest2.so as test2
+
+bench foo
+bench test2.qux # Qualified names work as with `call`
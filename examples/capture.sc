@@ -0,0 +1,11 @@
+# Output capture example
+# Run with `--capture`, `expect` compares the hash of the output printed by
+# the previous command
+
+use build/libtest1.so
+
+call foo
+expect 151ad5cc80cb7398
+
+call bar
+expect c072a3d2e7033bba # A mismatch prints the actual hash
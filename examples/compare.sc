@@ -0,0 +1,5 @@
+# Benchmark comparison example
+# Time the same function from two builds of a library against each other
+
+compare foo build/libtest1.so build/libtest2.so # Baseline first, candidate second
+compare bar build/libtest1.so build/libtest2.so
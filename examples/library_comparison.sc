@@ -7,4 +7,8 @@ call bar # Call bar from test1
 
 use build/libtest2.so # Load second library
 call foo # Call foo again (should still use test1's version)
-call bar # Call bar again (should still use test1's version)
\ No newline at end of file
+call bar # Call bar again (should still use test1's version)
+# Aliased libraries are reachable only through qualified calls
+use build/libtest2.so as test2 # Load second library under an alias
+call test2.foo # Call foo from test2
+call test2.bar # Call bar from test2
@@ -0,0 +1,9 @@
+# Namespaces example
+# Load the same-named functions from both libraries side by side
+
+use build/libtest1.so as test1 # Alias in the default namespace
+use build/libtest2.so in test2 # Alias in its own link-map namespace
+
+call test1.foo # foo() from test1
+call test2.foo # foo() from test2
+call test2.qux # Unique function of test2
@@ -0,0 +1,14 @@
+# Procedures example
+# The calls of a procedure are resolved on its first run, and again after a
+# `use` loads another library
+
+def workload {
+    call foo
+    call test2.qux
+}
+
+use build/libtest1.so
+use build/libtest2.so as test2
+
+run workload
+repeat 2 run workload
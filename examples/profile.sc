@@ -0,0 +1,7 @@
+# Profiling example
+# Run with `--profile out.folded`, every sample is rooted at its script line
+
+use build/libtest1.so
+
+call spin(u64 300000000) -> u64     # Calls `spin_step` through the PLT
+repeat 50000000 call spin_step(u64 3)
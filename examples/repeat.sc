@@ -0,0 +1,12 @@
+# Repeat example
+# The repeated commands are parsed and resolved once, then run in a loop
+
+use build/libtest1.so
+use build/libtest2.so as test2
+
+repeat 3 call foo
+
+repeat 2 {
+    call bar
+    repeat 2 call test2.qux # Qualified names and nesting work in blocks
+}
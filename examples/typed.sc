@@ -0,0 +1,12 @@
+# Typed calls example
+# Arguments are passed and results returned through a call stub compiled once
+# per signature
+
+use build/libtest1.so
+
+call add(i64 2, i64 3) -> i64                # Prints the result
+call add(i64 -1, i64 0x10) -> i64 = 15       # Checks the result
+call scale(f64 1.5) -> f64 = 3
+call mix(i32 1, f64 0.5, u32 4, f32 0.25) -> f32
+
+repeat 1000 call add(i64 1, i64 2) -> i64    # Results are not printed
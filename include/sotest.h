@@ -0,0 +1,143 @@
+#ifndef _SOTEST_SOTEST_H
+#define _SOTEST_SOTEST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Embeddable interpreter, built as `libsotest.a` and `libsotest.so`. There
+// is no global state: every `Sotest` has its own libraries, caches and
+// procedures, any number of them can run in one process, one thread each.
+//
+//     Sotest* sotest = sotest_new((SotestOptions) {
+//         .callbacks = {.on_result = on_result, .context = &results},
+//     });
+//     SotestScript* script = sotest_compile(source, strlen(source));
+//
+//     if (!sotest_execute(sotest, script)) {
+//         // `expect`, `compare` or a typed call check failed
+//     }
+//
+//     sotest_script_free(script);
+//     sotest_free(sotest);
+//
+// Output of called functions goes to the stdout of the process, it is not
+// captured per instance, so `expect` always fails.
+//
+// The header is plain C99, the library itself is built as C23. Only the
+// functions below are exported from `libsotest.so`.
+
+#if defined(__GNUC__)
+#define SOTEST_API __attribute__((visibility("default")))
+#else
+#define SOTEST_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum SotestStatus {
+    SOTEST_SUCCESS = 0,
+    SOTEST_LOAD_FAILED = 1,
+    SOTEST_LIBRARY_NOT_LOADED = 2,
+    SOTEST_FIND_SYMBOL_FAILED = 3,
+    SOTEST_ASSERTION_FAILED = 4,
+    /// No call stub for a typed call
+    SOTEST_STUB_FAILED = 5,
+    /// The line is not a valid command or does not fit where it is, e.g. a
+    /// `use` in a `def` block
+    SOTEST_PARSE_FAILED = 6,
+    /// The line is `exit`, the rest of the script is not run
+    SOTEST_EXIT = 7,
+} SotestStatus;
+
+/// Outcome of a command, the same as a record of `sotest --format jsonl`
+typedef struct SotestResult {
+    /// A `repeat` block is reported at its first line, once it is closed
+    size_t line_number;
+    /// Name of the command, e.g. `call`, `nullptr` if the line failed to
+    /// parse
+    char const* type;
+    /// Library path, function name and so on, or the whole line if it failed
+    /// to parse. Not nul-terminated.
+    char const* target;
+    size_t target_len;
+    SotestStatus status;
+    /// Nul-terminated description of the failure, `nullptr` on success
+    char const* error;
+    uint64_t duration_ns;
+} SotestResult;
+
+/// Every pointer passed to a callback is valid only during the call
+typedef struct SotestCallbacks {
+    /// Called after every command and for every line which fails to parse
+    void (*on_result)(void* context, SotestResult const* result);
+    /// Receives the output of the interpreter itself: results of typed calls,
+    /// `compare` and `bench` reports. It goes to stdout if not set.
+    void (*on_output)(void* context, char const* ptr, size_t len);
+    void* context;
+} SotestCallbacks;
+
+typedef struct SotestOptions {
+    /// Defer `dlopen` of each `use`d library until a called function is
+    /// found in its exported symbols
+    bool is_lazy;
+    /// Call procedures and repeated calls in a loop instead of through
+    /// compiled thunks
+    bool is_jit_disabled;
+    SotestCallbacks callbacks;
+} SotestOptions;
+
+/// Interpreter with its own libraries, function caches and procedures
+typedef struct Sotest Sotest;
+
+/// Script split into lines and parsed once, to be executed any number of
+/// times by any `Sotest`
+typedef struct SotestScript SotestScript;
+
+/// # Return
+///
+/// `nullptr` if the output stream for `on_output` can not be created
+SOTEST_API Sotest* sotest_new(SotestOptions options);
+
+/// Executes one line of a script. Lines of `repeat` and `def` blocks are
+/// collected until the block is closed, a `repeat` block runs then.
+///
+/// # Return
+///
+/// The status of the line's command, `SOTEST_SUCCESS` for comments, empty
+/// lines and lines of an open block
+SOTEST_API SotestStatus sotest_execute_line(Sotest* self, char const* line, size_t len);
+
+/// Reports the `repeat` and `def` blocks left open by `sotest_execute_line`
+/// and drops them
+SOTEST_API void sotest_finish(Sotest* self);
+
+/// Copies the source, so it can be freed right away. Lines which fail to
+/// parse are kept and reported when executed.
+SOTEST_API SotestScript* sotest_compile(char const* source, size_t len);
+
+/// Number of lines of the script, the last one need not end with a newline
+SOTEST_API size_t sotest_script_len(SotestScript const* self);
+
+/// Executes every line of the script up to `exit`, then reports the blocks
+/// left open like `sotest_finish`. Lines are numbered from 1 for every
+/// script, the libraries and procedures of earlier ones stay.
+///
+/// # Return
+///
+/// `false` if a check failed: `expect`, a `compare` or `bench` regression or
+/// the expected result of a typed call. Failed loads and lookups are only
+/// reported, the same as the exit status of `sotest`.
+SOTEST_API bool sotest_execute(Sotest* self, SotestScript const* script);
+
+SOTEST_API void sotest_script_free(SotestScript* self);
+
+SOTEST_API void sotest_free(Sotest* self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // !_SOTEST_SOTEST_H
@@ -0,0 +1,72 @@
+#include "arena.h"
+
+#include <stdlib.h>
+
+/// Rounds up to the alignment of `max_align_t`
+static size_t arena_align(size_t size) {
+    auto align = alignof(max_align_t);
+
+    return (size + align - 1) & ~(align - 1);
+}
+
+void* arena_alloc(Arena* self, size_t size) {
+    size = arena_align(0 == size ? 1 : size);
+
+    auto head = self->head;
+
+    if (nullptr == head || head->cap - head->len < size) {
+        auto cap = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        auto block = (ArenaBlock*) malloc(sizeof(ArenaBlock) + cap);
+
+        block->previous = head;
+        block->len = 0;
+        block->cap = cap;
+
+        self->head = block;
+        self->n_blocks += 1;
+        head = block;
+    }
+
+    auto ptr = head->data + head->len;
+    head->len += size;
+    self->n_bytes += size;
+
+    return ptr;
+}
+
+Str arena_copy(Arena* self, Str source) {
+    auto ptr = (char*) arena_alloc(self, source.len + 1);
+
+    if (0 != source.len) {
+        memcpy(ptr, source.ptr, source.len);
+    }
+
+    ptr[source.len] = '\0';
+
+    return (Str) {.ptr = ptr, .len = source.len};
+}
+
+void arena_rewind(Arena* self, ArenaMark mark) {
+    while (self->head != mark.block) {
+        auto previous = self->head->previous;
+        free(self->head);
+        self->head = previous;
+        self->n_blocks -= 1;
+    }
+
+    if (nullptr != self->head) {
+        self->head->len = mark.len;
+    }
+
+    self->n_bytes = mark.n_bytes;
+}
+
+void arena_free(Arena* self) {
+    while (nullptr != self->head) {
+        auto previous = self->head->previous;
+        free(self->head);
+        self->head = previous;
+    }
+
+    *self = ARENA_EMPTY;
+}
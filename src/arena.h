@@ -0,0 +1,65 @@
+#ifndef _SOTEST_ARENA_H
+#define _SOTEST_ARENA_H
+
+#include "str.h"
+
+#include <stddef.h>
+
+/// Size of a regular block, larger allocations get a block of their own
+size_t constexpr ARENA_BLOCK_SIZE = 64 * 1024;
+
+typedef struct ArenaBlock {
+    /// Block allocated before this one
+    struct ArenaBlock* previous;
+    size_t len;
+    size_t cap;
+    alignas(max_align_t) char data[];
+} ArenaBlock;
+
+/// Bump allocator for memory which lives as long as its owner, such as
+/// interned names and paths. Allocations are never freed on their own, all
+/// of them go at once with `arena_free`.
+typedef struct Arena {
+    /// Latest block, allocations are bumped in it
+    ArenaBlock* head;
+    size_t n_blocks;
+    /// Bytes handed out, padding included
+    size_t n_bytes;
+} Arena;
+
+Arena constexpr ARENA_EMPTY = {.head = nullptr, .n_blocks = 0, .n_bytes = 0};
+
+/// Position to go back to with `arena_rewind`
+typedef struct ArenaMark {
+    ArenaBlock* block;
+    size_t len;
+    size_t n_bytes;
+} ArenaMark;
+
+/// Allocates `size` bytes aligned for any type, uninitialized
+void* arena_alloc(Arena* self, size_t size);
+
+/// Copies the string with a nul terminator
+Str arena_copy(Arena* self, Str source);
+
+/// Copies the string as the key of a map, whose `free` must leave it to the
+/// arena
+inline static String arena_copy_string(Arena* self, Str source) {
+    return (String) {.str = arena_copy(self, source), .cap = 0};
+}
+
+inline static ArenaMark arena_mark(Arena const* self) {
+    return (ArenaMark) {
+        .block = self->head,
+        .len = nullptr == self->head ? 0 : self->head->len,
+        .n_bytes = self->n_bytes,
+    };
+}
+
+/// Drops every allocation made since the mark, for copies which turned out
+/// not to be needed
+void arena_rewind(Arena* self, ArenaMark mark);
+
+void arena_free(Arena* self);
+
+#endif  // !_SOTEST_ARENA_H
@@ -1,6 +1,7 @@
 #include "args.h"
 
 #include <ctype.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -18,19 +19,18 @@ static int local_string_compare(String a, String b) {
     return string_compare(&a, &b);
 }
 
-static void local_string_free(String string) { string_free(&string); }
-
 static size_t local_string_hash(String string) { return string_hash(&string); }
 
+// Keys and values are in the arena of `Args`, the map leaves them to
+// `arena_free`
+
 struct ArgumentMap_fkey ARGUMENT_MAP_FKEY = {
     .cmp = local_string_compare,
-    .free = local_string_free,
     .hash = local_string_hash,
 };
 
 struct ArgumentMap_fval ARGUMENT_MAP_FVAL = {
     .cmp = local_string_compare,
-    .free = local_string_free,
     .hash = local_string_hash,
 };
 
@@ -52,6 +52,8 @@ Args args_parse(size_t count, char** ptr) {
         argument_map_new(16, 0.5, &ARGUMENT_MAP_FKEY, &ARGUMENT_MAP_FVAL);
     assert(nullptr != values);
 
+    auto arena = ARENA_EMPTY;
+
     for (size_t i = 1; i < count; ++i) {
         auto arg = str_from_ptr(ptr[i]);
         auto flag_result = flag_parse(arg);
@@ -64,6 +66,7 @@ Args args_parse(size_t count, char** ptr) {
 
             if (INVALID_ENTRY_INDEX == entry_index) {
                 argument_map_free(values);
+                arena_free(&arena);
 
                 switch (flag_result.value.type) {
                 case FLAG_TYPE_LONG:
@@ -85,13 +88,18 @@ Args args_parse(size_t count, char** ptr) {
             if (0 != ARG_ENTRIES[entry_index].argument_name.len) {
                 flag_entry_index = entry_index;
                 is_flagged = true;
+            } else {  // Boolean flag, store it with an empty value
+                auto entry = &ARG_ENTRIES[entry_index];
+                auto name =
+                    0 != entry->long_name.len
+                        ? entry->long_name
+                        : (Str) {.ptr = (char*) &entry->short_name, .len = 1};
+
+                argument_map_insert(
+                    values, arena_copy_string(&arena, name), STRING_EMPTY
+                );
             }
         } else {  // The value is an argument
-            auto value = STRING_EMPTY;
-            auto key = STRING_EMPTY;
-
-            string_append(&value, arg);
-
             size_t entry_index = flag_entry_index;
 
             if (!is_flagged) {
@@ -103,24 +111,25 @@ Args args_parse(size_t count, char** ptr) {
             if (INVALID_ENTRY_INDEX == entry_index) {
                 fprintf(stderr, "unexpected argument '%s'\n", arg.ptr);
 
-                string_free(&key);
-                string_free(&value);
                 argument_map_free(values);
+                arena_free(&arena);
 
                 exit(EXIT_FAILURE);
             }
 
             auto entry = &ARG_ENTRIES[entry_index];
+            auto name = entry->argument_name;
 
             if (0 != entry->long_name.len) {
-                string_append(&key, entry->long_name);
+                name = entry->long_name;
             } else if (UNUSED_SHORT_NAME != entry->short_name) {
-                string_push(&key, entry->short_name);
-            } else {
-                string_append(&key, entry->argument_name);
+                name = (Str) {.ptr = (char*) &entry->short_name, .len = 1};
             }
 
-            argument_map_insert(values, key, value);
+            argument_map_insert(
+                values, arena_copy_string(&arena, name),
+                arena_copy_string(&arena, arg)
+            );
 
             is_flagged = false;
         }
@@ -128,6 +137,7 @@ Args args_parse(size_t count, char** ptr) {
 
     return (Args) {
         .values = values,
+        .arena = arena,
     };
 }
 
@@ -192,6 +202,26 @@ void print_help_message() {
             printf("Options:\n");
         }
 
+        // Descriptions are aligned after the widest flag
+        int column_width = 16;
+
+        for (size_t i = 0; i < N_ARG_ENTRIES; ++i) {
+            auto arg = &ARG_ENTRIES[i];
+            int width = 1;
+
+            if (0 != arg->long_name.len) {
+                width += 4 + (int) arg->long_name.len;
+            }
+
+            if (nullptr != arg->argument_name.ptr) {
+                width += 3 + (int) arg->argument_name.len;
+            }
+
+            if (!arg_entry_is_positional(arg) && width > column_width) {
+                column_width = width;
+            }
+        }
+
         for (size_t i = 0; i < N_ARG_ENTRIES; ++i) {
             auto arg = &ARG_ENTRIES[i];
 
@@ -208,7 +238,7 @@ void print_help_message() {
             }
 
             auto separator = has_short_name ? ',' : ' ';
-            int offset = 16;
+            int offset = column_width;
 
             if (0 != arg->long_name.len) {
                 printf("%c --%s", separator, arg->long_name.ptr);
@@ -340,8 +370,58 @@ void args_free(Args* self) {
         argument_map_free(self->values);
         self->values = nullptr;
     }
+
+    arena_free(&self->arena);
 }
 
 Str args_get(Args const* self, Str long_flag) {
     return argument_map_get(self->values, (String) {.str = long_flag}).str;
 }
+
+bool args_has(Args const* self, Str long_flag) {
+    return argument_map_contains(self->values, (String) {.str = long_flag});
+}
+
+size_t args_get_size(Args const* self, Str long_flag, size_t default_value) {
+    auto value = args_get(self, long_flag);
+
+    if (0 == value.len) {
+        return default_value;
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    auto result = strtoull(value.ptr, &end, 10);
+
+    if (0 != errno || '\0' != *end || '-' == value.ptr[0]) {
+        fprintf(
+            stderr, "error: invalid value '%s' for '--%s'\n", value.ptr,
+            long_flag.ptr
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    return (size_t) result;
+}
+
+double args_get_double(Args const* self, Str long_flag, double default_value) {
+    auto value = args_get(self, long_flag);
+
+    if (0 == value.len) {
+        return default_value;
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    auto result = strtod(value.ptr, &end);
+
+    if (0 != errno || '\0' != *end) {
+        fprintf(
+            stderr, "error: invalid value '%s' for '--%s'\n", value.ptr,
+            long_flag.ptr
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    return result;
+}
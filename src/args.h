@@ -2,6 +2,7 @@
 #define _SOTEST_ARGS_H
 
 #include "str.h"
+#include "arena.h"
 
 #include <stddef.h>
 
@@ -50,6 +51,114 @@ ArgEntry constexpr ARG_ENTRIES[] = {
         .description = Str("print version"),
         .immediate_callback = print_version,
     },
+    (ArgEntry) {
+        .long_name = Str("no-prefetch"),
+        .description = Str("do not read ahead libraries from upcoming `use`s"),
+    },
+    (ArgEntry) {
+        .long_name = Str("lazy"),
+        .description = Str("open libraries only when their function is called"),
+    },
+    (ArgEntry) {
+        .long_name = Str("no-jit"),
+        .description = Str("do not compile repeated calls to machine code"),
+    },
+    (ArgEntry) {
+        .long_name = Str("check"),
+        .description = Str("validate the script without loading libraries"),
+    },
+    (ArgEntry) {
+        .long_name = Str("compare-samples"),
+        .description = Str("timed calls per function in `compare` and `bench`"),
+        .argument_name = Str("N"),
+    },
+    (ArgEntry) {
+        .long_name = Str("max-regression"),
+        .description = Str("fail if `compare` finds a larger slowdown"),
+        .argument_name = Str("PERCENT"),
+    },
+    (ArgEntry) {
+        .long_name = Str("format"),
+        .description =
+            Str("report every command to stderr as `text` or `jsonl`"),
+        .argument_name = Str("FORMAT"),
+    },
+    (ArgEntry) {
+        .long_name = Str("capture"),
+        .description = Str("buffer the output of called functions in memory"),
+    },
+    (ArgEntry) {
+        .long_name = Str("capture-map"),
+        .description =
+            Str("capture and write which line printed which output to PATH"),
+        .argument_name = Str("PATH"),
+    },
+    (ArgEntry) {
+        .long_name = Str("profile"),
+        .description =
+            Str("sample called functions, write folded stacks to PATH"),
+        .argument_name = Str("PATH"),
+    },
+    (ArgEntry) {
+        .long_name = Str("profile-rate"),
+        .description = Str("samples per second of CPU time for `--profile`"),
+        .argument_name = Str("HZ"),
+    },
+    (ArgEntry) {
+        .long_name = Str("monitor"),
+        .description = Str("keep live counters in /dev/shm for `sotest-top`"),
+    },
+    (ArgEntry) {
+        .long_name = Str("call-stats"),
+        .description = Str("print call counts and times to stderr at exit"),
+    },
+    (ArgEntry) {
+        .long_name = Str("mem-report"),
+        .description =
+            Str("print memory growth of libraries and calls to stderr at exit"),
+    },
+    (ArgEntry) {
+        .long_name = Str("mem-series"),
+        .description = Str("write every memory sample to PATH"),
+        .argument_name = Str("PATH"),
+    },
+    (ArgEntry) {
+        .long_name = Str("mem-period"),
+        .description = Str("calls of a function per memory sample"),
+        .argument_name = Str("N"),
+    },
+    (ArgEntry) {
+        .long_name = Str("mem-max-growth"),
+        .description = Str("fail if a function grows the heap more per period"),
+        .argument_name = Str("BYTES"),
+    },
+    (ArgEntry) {
+        .long_name = Str("history"),
+        .description = Str("append `bench` results to the history at PATH"),
+        .argument_name = Str("PATH"),
+    },
+    (ArgEntry) {
+        .long_name = Str("baseline"),
+        .description = Str("fail if `bench` regressed against the history"),
+    },
+    (ArgEntry) {
+        .long_name = Str("cpus"),
+        .description = Str("pin the interpreter to CPUs, e.g. `2` or `2,4-5`"),
+        .argument_name = Str("LIST"),
+    },
+    (ArgEntry) {
+        .long_name = Str("lock-memory"),
+        .description = Str("lock memory and pre-fault loaded library code"),
+    },
+    (ArgEntry) {
+        .long_name = Str("high-priority"),
+        .description = Str("raise the scheduling priority if permitted"),
+    },
+    (ArgEntry) {
+        .long_name = Str("warmup"),
+        .description = Str("spin until CPU timings settle, at most MS"),
+        .argument_name = Str("MS"),
+    },
     (ArgEntry) {
         .description =
             Str("optional: `.sc` input file, will enter interactive mode if "
@@ -63,12 +172,25 @@ size_t constexpr INVALID_ENTRY_INDEX = N_ARG_ENTRIES;
 
 typedef struct Args {
     struct ArgumentMap* values;
+    /// Holds the keys and values of `values`
+    Arena arena;
 } Args;
 
 Args args_parse(size_t count, char** ptr);
 
 Str args_get(Args const* self, Str long_flag);
 
+/// Checks if the flag was provided, useful for flags without an argument
+bool args_has(Args const* self, Str long_flag);
+
+/// Parses the flag argument as a non-negative integer, exits with an error
+/// message if it is malformed
+size_t args_get_size(Args const* self, Str long_flag, size_t default_value);
+
+/// Parses the flag argument as a floating point number, exits with an error
+/// message if it is malformed
+double args_get_double(Args const* self, Str long_flag, double default_value);
+
 void args_free(Args* self);
 
 typedef enum FlagType : uint8_t {
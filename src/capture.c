@@ -0,0 +1,254 @@
+#define _GNU_SOURCE
+
+#include "capture.h"
+
+#include <errno.h>
+#include <stdio_ext.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+
+/// Buffer of stdout while capturing, written to the `memfd` when full
+size_t constexpr CAPTURE_BUFFER_SIZE = 1 << 16;
+
+/// Logical output position: what reached the `memfd` plus what is still
+/// buffered in stdout. Unlike `fflush` it costs no write per command.
+static size_t capture_position(Capture const* self) {
+    auto offset = lseek(self->memfd, 0, SEEK_CUR);
+
+    return (offset < 0 ? 0 : (size_t) offset) + __fpending(stdout);
+}
+
+bool capture_start(Capture* self, FILE* map) {
+    *self = (Capture) {
+        .memfd = -1,
+        .destination_fd = -1,
+        .last_command = STRING_EMPTY,
+        .map = map,
+    };
+
+    fflush(stdout);
+
+    self->memfd = memfd_create("sotest-capture", MFD_CLOEXEC);
+
+    if (self->memfd < 0) {
+        return false;
+    }
+
+    self->destination_fd = dup(STDOUT_FILENO);
+
+    if (self->destination_fd < 0 || dup2(self->memfd, STDOUT_FILENO) < 0) {
+        auto error = errno;
+
+        if (self->destination_fd >= 0) {
+            close(self->destination_fd);
+        }
+
+        close(self->memfd);
+        errno = error;
+
+        return false;
+    }
+
+    setvbuf(stdout, nullptr, _IOFBF, CAPTURE_BUFFER_SIZE);
+    self->is_active = true;
+
+    return true;
+}
+
+/// The end of a command's output is known once anything else happens
+static void capture_close_last(Capture* self) {
+    if (!self->is_last_open) {
+        return;
+    }
+
+    self->is_last_open = false;
+    self->last_len = capture_position(self) - self->last_start;
+
+    if (nullptr != self->map && 0 != self->last_len) {
+        fprintf(
+            self->map, "%llu\t%zu\t%zu\t%.*s\n",
+            (unsigned long long) (self->n_flushed + self->last_start),
+            self->last_len, self->last_line_number,
+            (int) self->last_command.str.len, self->last_command.str.ptr
+        );
+    }
+}
+
+/// Fallback for destinations `sendfile` refuses, e.g. files opened with
+/// `O_APPEND`: writes straight from a mapping of the `memfd`
+static void capture_write_mapped(Capture* self, size_t offset, size_t len) {
+    void* data = mmap(nullptr, len, PROT_READ, MAP_SHARED, self->memfd, 0);
+
+    if (MAP_FAILED == data) {
+        return;
+    }
+
+    while (offset < len) {
+        auto n_written = write(
+            self->destination_fd, (char const*) data + offset, len - offset
+        );
+
+        if (n_written < 0 && EINTR == errno) {
+            continue;
+        }
+
+        if (n_written <= 0) {
+            break;
+        }
+
+        offset += (size_t) n_written;
+    }
+
+    munmap(data, len);
+}
+
+void capture_flush(Capture* self) {
+    if (!self->is_active) {
+        return;
+    }
+
+    capture_close_last(self);
+    fflush(stdout);
+
+    auto len = capture_position(self);
+    off_t offset = 0;
+
+    while ((size_t) offset < len) {
+        auto n_sent = sendfile(
+            self->destination_fd, self->memfd, &offset, len - (size_t) offset
+        );
+
+        if (n_sent < 0 && EINTR == errno) {
+            continue;
+        }
+
+        if (n_sent < 0 && (EINVAL == errno || ENOSYS == errno)) {
+            capture_write_mapped(self, (size_t) offset, len);
+            break;
+        }
+
+        if (n_sent <= 0) {
+            break;
+        }
+    }
+
+    // The memfd is reused from the start, fd 1 shares its file offset
+    ftruncate(self->memfd, 0);
+    lseek(self->memfd, 0, SEEK_SET);
+
+    self->n_flushed += len;
+    self->last_start = 0;
+    self->last_len = 0;
+}
+
+void capture_begin(Capture* self) {
+    if (!self->is_active) {
+        return;
+    }
+
+    capture_close_last(self);
+
+    auto position = capture_position(self);
+
+    // The last command's output is not needed anymore once another command
+    // starts, only `expect` looks at it
+    if (position >= CAPTURE_FLUSH_THRESHOLD) {
+        capture_flush(self);
+        position = 0;
+    }
+
+    self->last_start = position;
+    self->last_len = 0;
+    self->is_last_open = true;
+}
+
+void capture_end(Capture* self, size_t line_number, Str command) {
+    if (!self->is_active) {
+        return;
+    }
+
+    self->last_line_number = line_number;
+
+    // The line is only needed for the map, spare the copy otherwise
+    if (nullptr != self->map) {
+        string_clear(&self->last_command);
+        string_append(&self->last_command, command);
+    }
+}
+
+ExecutorResult capture_expect(Capture* self, uint64_t expected) {
+    if (!self->is_active) {
+        return (ExecutorResult) {
+            .status = EXECUTOR_ASSERTION_FAILED,
+            .dl_error = Str("output is not captured, run with `--capture`"),
+        };
+    }
+
+    capture_close_last(self);
+
+    uint64_t hash = 0;
+
+    if (0 == self->last_len) {
+        hash = murmur_hash("", 0, 0);
+    } else {
+        fflush(stdout);
+
+        auto page_size = (size_t) sysconf(_SC_PAGESIZE);
+        auto map_start = self->last_start & ~(page_size - 1);
+        auto map_len = self->last_start + self->last_len - map_start;
+
+        void* data = mmap(
+            nullptr, map_len, PROT_READ, MAP_SHARED, self->memfd,
+            (off_t) map_start
+        );
+
+        if (MAP_FAILED == data) {
+            snprintf(
+                self->error, sizeof(self->error),
+                "failed to map the captured output: %s", strerror(errno)
+            );
+
+            return (ExecutorResult) {
+                .status = EXECUTOR_ASSERTION_FAILED,
+                .dl_error = str_from_ptr(self->error),
+            };
+        }
+
+        hash = murmur_hash(
+            (char const*) data + (self->last_start - map_start),
+            self->last_len, 0
+        );
+        munmap(data, map_len);
+    }
+
+    if (hash == expected) {
+        return (ExecutorResult) {.status = EXECUTOR_SUCCESS};
+    }
+
+    snprintf(
+        self->error, sizeof(self->error),
+        "output of line %zu (%zu bytes) hashes to %016llx",
+        self->last_line_number, self->last_len, (unsigned long long) hash
+    );
+
+    return (ExecutorResult) {
+        .status = EXECUTOR_ASSERTION_FAILED,
+        .dl_error = str_from_ptr(self->error),
+    };
+}
+
+void capture_stop(Capture* self) {
+    if (!self->is_active) {
+        return;
+    }
+
+    capture_flush(self);
+
+    dup2(self->destination_fd, STDOUT_FILENO);
+    close(self->destination_fd);
+    close(self->memfd);
+    string_free(&self->last_command);
+
+    self->is_active = false;
+}
@@ -0,0 +1,72 @@
+#ifndef _SOTEST_CAPTURE_H
+#define _SOTEST_CAPTURE_H
+
+#include "str.h"
+#include "interpreter.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/// Captured output is sent to the real stdout once it grows beyond this
+size_t constexpr CAPTURE_FLUSH_THRESHOLD = 1 << 20;
+
+/// Redirects stdout (fd 1) into a `memfd`, so that output of called functions
+/// costs no terminal or pipe writes per call. The output is attributed to the
+/// command which produced it and sent to the real stdout in bulk.
+typedef struct Capture {
+    bool is_active;
+    int memfd;
+    /// Duplicate of the original stdout
+    int destination_fd;
+    /// Bytes sent to the destination so far, `memfd` offsets are relative to
+    /// this
+    uint64_t n_flushed;
+    /// Output of the last command, in `memfd` offsets. Its end is set when
+    /// the next command starts, see `is_last_open`.
+    size_t last_start;
+    size_t last_len;
+    size_t last_line_number;
+    /// The last command may still be producing output
+    bool is_last_open;
+    /// Text of the last command, kept only for the map
+    String last_command;
+    /// Attribution records are written here if not `nullptr`
+    FILE* map;
+    /// Holds the nul-terminated error descriptions
+    char error[128];
+} Capture;
+
+/// Starts capturing. With a `map`, one tab-separated line `<offset> <length>
+/// <line> <command>` is written for every command which produced output,
+/// offsets count from the start of the output.
+///
+/// # Error
+///
+/// Returns `false` and sets `errno` if the `memfd` can not be set up
+bool capture_start(Capture* self, FILE* map);
+
+/// Marks the start of a command's output, flushing old output if there is a
+/// lot of it
+void capture_begin(Capture* self);
+
+/// Attributes the output since `capture_begin` to the command. Output still
+/// buffered in stdout counts as well, nothing is flushed per command.
+void capture_end(Capture* self, size_t line_number, Str command);
+
+/// Compares the hash (`murmur_hash`, seed 0) of the last command's output
+/// with `expected`. The output is hashed in place, through a mapping of the
+/// `memfd`.
+///
+/// # Error
+///
+/// Returns `.status = EXECUTOR_ASSERTION_FAILED` with a nul-terminated
+/// description in `.dl_error` if the hash differs or capturing is not active
+ExecutorResult capture_expect(Capture* self, uint64_t expected);
+
+/// Sends all captured output to the real stdout
+void capture_flush(Capture* self);
+
+/// Flushes and restores stdout
+void capture_stop(Capture* self);
+
+#endif  // !_SOTEST_CAPTURE_H
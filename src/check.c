@@ -0,0 +1,545 @@
+#include "check.h"
+#include "elf_image.h"
+#include "interpreter.h"
+#include "parse.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define K String
+#define V size_t
+#define SNAME CheckLibraryMap
+#define PFX check_library_map
+
+#include <cmc/hashmap.h>
+
+static int local_string_compare(String a, String b) {
+    return string_compare(&a, &b);
+}
+
+static size_t local_string_hash(String string) { return string_hash(&string); }
+
+/// Keys are borrowed from `CheckLine`s
+struct CheckLibraryMap_fkey CHECK_LIBRARY_MAP_FKEY = {
+    .cmp = local_string_compare,
+    .hash = local_string_hash,
+};
+
+struct CheckLibraryMap_fval CHECK_LIBRARY_MAP_FVAL = {};
+
+size_t constexpr CHECK_MAX_THREADS = 16;
+
+typedef struct CheckLine {
+    String text;
+    size_t line_number;
+    bool is_valid;
+    /// Available only if `is_valid == true`
+    CommandLine value;
+} CheckLine;
+
+typedef struct CheckLibrary {
+    Str path;
+    ElfOpenResult image;
+} CheckLibrary;
+
+typedef struct CheckState {
+    CheckLine* lines;
+    size_t n_lines;
+    CheckLibrary* libraries;
+    size_t n_libraries;
+    /// Next library to be opened by a worker
+    atomic_size_t next;
+} CheckState;
+
+static void* check_open_libraries(void* argument) {
+    CheckState* state = argument;
+
+    while (true) {
+        auto index =
+            atomic_fetch_add_explicit(&state->next, 1, memory_order_relaxed);
+
+        if (index >= state->n_libraries) {
+            return nullptr;
+        }
+
+        auto library = &state->libraries[index];
+        library->image = elf_image_open(library->path);
+    }
+}
+
+static void check_report(
+    FILE* report, Str name, size_t line_number, Command const* command,
+    ExecutorResult result
+) {
+    str_write(name, report);
+    fprintf(report, ":%zu: ", line_number);
+    str_write(executor_result_name(result), report);
+    fputs(": ", report);
+    str_write(command->content, report);
+    fputs(": ", report);
+    str_write(result.dl_error, report);
+    fputc('\n', report);
+}
+
+static void check_read_lines(FILE* input, CheckState* state) {
+    size_t cap = 0;
+    size_t line_number = 0;
+
+    while (true) {
+        auto text = STRING_EMPTY;
+        line_number += 1;
+
+        if (READLINE_EOF == string_readline(&text, input)) {
+            string_free(&text);
+            break;
+        }
+
+        auto line = str_trim(text.str);
+
+        if (str_starts_with(line, Str("exit"))) {
+            string_free(&text);
+            break;
+        }
+
+        auto result = command_line_parse(line);
+
+        if (state->n_lines == cap) {
+            cap = 0 == cap ? 64 : cap + cap / 2;
+            state->lines = realloc(state->lines, sizeof(*state->lines) * cap);
+        }
+
+        state->lines[state->n_lines] = (CheckLine) {
+            .text = text,
+            .line_number = line_number,
+            .is_valid = result.has_value && 0 == str_trim_end(result.tail).len,
+            .value = result.value,
+        };
+        state->n_lines += 1;
+    }
+}
+
+static void check_add_library(
+    CheckState* state, struct CheckLibraryMap* indices, Str path
+) {
+    auto key = (String) {.str = path};
+
+    if (check_library_map_insert(indices, key, state->n_libraries)) {
+        state->libraries[state->n_libraries].path = path;
+        state->n_libraries += 1;
+    }
+}
+
+static ExecutorResult check_in_library(
+    CheckState const* state, struct CheckLibraryMap* indices, Str path,
+    Str function_name
+) {
+    auto index = check_library_map_get(indices, (String) {.str = path});
+    auto library = &state->libraries[index];
+
+    if (ELF_SUCCESS != library->image.status) {
+        return (ExecutorResult) {
+            .dl_error = library->image.error,
+            .status = EXECUTOR_LOAD_FAILED,
+        };
+    }
+
+    if (!elf_image_exports(&library->image.value, function_name)) {
+        return (ExecutorResult) {
+            .dl_error = Str("the library does not export the symbol"),
+            .status = EXECUTOR_FIND_SYMBOL_FAILED,
+        };
+    }
+
+    return (ExecutorResult) {};
+}
+
+static ExecutorResult check_qualified_call(
+    CheckState const* state, struct CheckLibraryMap* aliases,
+    Command const* command
+) {
+    auto alias = (String) {.str = command->alias};
+
+    if (!check_library_map_contains(aliases, alias)) {
+        return (ExecutorResult) {
+            .dl_error = Str("no library loaded with this alias"),
+            .status = EXECUTOR_LIBRARY_NOT_LOADED,
+        };
+    }
+
+    auto index = check_library_map_get(aliases, alias);
+    auto image = &state->libraries[index].image.value;
+    auto name = str_slice(
+        command->content, command->alias.len + 1, command->content.len
+    );
+
+    if (!elf_image_exports(image, name)) {
+        return (ExecutorResult) {
+            .dl_error = Str("the aliased library does not export the symbol"),
+            .status = EXECUTOR_FIND_SYMBOL_FAILED,
+        };
+    }
+
+    return (ExecutorResult) {};
+}
+
+/// Checks a `call` or `bench` against the libraries `loaded` so far, in `use`
+/// order
+static ExecutorResult check_call(
+    CheckState const* state, struct CheckLibraryMap* aliases,
+    size_t const* loaded, size_t n_loaded, Command const* command
+) {
+    if (0 != command->alias.len) {
+        return check_qualified_call(state, aliases, command);
+    }
+
+    if (0 == n_loaded) {
+        return (ExecutorResult) {
+            .dl_error = Str("no library loaded"),
+            .status = EXECUTOR_LIBRARY_NOT_LOADED,
+        };
+    }
+
+    for (size_t i = 0; i < n_loaded; ++i) {
+        auto image = &state->libraries[loaded[i]].image.value;
+
+        if (elf_image_exports(image, command->content)) {
+            return (ExecutorResult) {};
+        }
+    }
+
+    return (ExecutorResult) {
+        .dl_error = Str("no loaded library exports the symbol"),
+        .status = EXECUTOR_FIND_SYMBOL_FAILED,
+    };
+}
+
+size_t check_script(FILE* input, Str name, FILE* report) {
+    auto state = (CheckState) {};
+    check_read_lines(input, &state);
+
+    auto indices = check_library_map_new(
+        32, 0.5, &CHECK_LIBRARY_MAP_FKEY, &CHECK_LIBRARY_MAP_FVAL
+    );
+
+    // Each line names at most two libraries
+    state.libraries =
+        calloc(2 * state.n_lines + 1, sizeof(*state.libraries));
+
+    for (size_t i = 0; i < state.n_lines; ++i) {
+        auto line = &state.lines[i];
+
+        if (!line->is_valid || !line->value.has_command) {
+            continue;
+        }
+
+        auto command = &line->value.command;
+
+        switch (command->type) {
+        case COMMAND_TYPE_USE:
+            check_add_library(&state, indices, command->content);
+            break;
+        case COMMAND_TYPE_CALL:
+        case COMMAND_TYPE_BENCH:
+        case COMMAND_TYPE_EXPECT:
+        case COMMAND_TYPE_REPEAT:
+        case COMMAND_TYPE_END:
+        case COMMAND_TYPE_DEF:
+        case COMMAND_TYPE_RUN:
+            break;
+        case COMMAND_TYPE_COMPARE:
+            check_add_library(&state, indices, command->baseline_path);
+            check_add_library(&state, indices, command->candidate_path);
+            break;
+        }
+    }
+
+    auto n_threads = (size_t) sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (n_threads > CHECK_MAX_THREADS) {
+        n_threads = CHECK_MAX_THREADS;
+    }
+
+    if (n_threads > state.n_libraries) {
+        n_threads = state.n_libraries;
+    }
+
+    pthread_t threads[CHECK_MAX_THREADS];
+    size_t n_spawned = 0;
+
+    // The calling thread works as well, so spawn one less
+    for (; n_spawned + 1 < n_threads; ++n_spawned) {
+        if (0 != pthread_create(
+                     &threads[n_spawned], nullptr, check_open_libraries, &state
+                 ))
+        {
+            break;
+        }
+    }
+
+    check_open_libraries(&state);
+
+    for (size_t i = 0; i < n_spawned; ++i) {
+        pthread_join(threads[i], nullptr);
+    }
+
+    // Aliases of successfully opened libraries
+    auto aliases = check_library_map_new(
+        16, 0.5, &CHECK_LIBRARY_MAP_FKEY, &CHECK_LIBRARY_MAP_FVAL
+    );
+
+    // Indices of successfully opened libraries in `use` order
+    auto loaded = (size_t*) calloc(state.n_libraries + 1, sizeof(size_t));
+    auto is_loaded = (bool*) calloc(state.n_libraries + 1, sizeof(bool));
+    size_t n_loaded = 0;
+    size_t n_problems = 0;
+    // Number of open `repeat` blocks and the line of the outermost one
+    size_t n_open_blocks = 0;
+    size_t block_line_number = 0;
+    // Line index of each procedure's `def`, `SIZE_MAX` once its calls were
+    // checked
+    auto procedures = check_library_map_new(
+        16, 0.5, &CHECK_LIBRARY_MAP_FKEY, &CHECK_LIBRARY_MAP_FVAL
+    );
+    // Line of the `def` block being read, 0 outside of one
+    size_t definition_line_number = 0;
+
+    for (size_t i = 0; i < state.n_lines; ++i) {
+        auto line = &state.lines[i];
+
+        if (!line->is_valid) {
+            fprintf(
+                report, "%.*s:%zu: syntax error: failed to parse '%s'\n",
+                (int) name.len, name.ptr, line->line_number,
+                str_trim(line->text.str).ptr
+            );
+            n_problems += 1;
+            continue;
+        }
+
+        if (!line->value.has_command) {
+            continue;
+        }
+
+        auto command = &line->value.command;
+
+        if (0 != definition_line_number && COMMAND_TYPE_END == command->type) {
+            definition_line_number = 0;
+            continue;
+        }
+
+        // Calls are checked when the procedure runs
+        if (0 != definition_line_number && COMMAND_TYPE_CALL == command->type &&
+            0 == command->signature.len)
+        {
+            continue;
+        }
+
+        if (0 != definition_line_number) {
+            fprintf(
+                report, "%.*s:%zu: syntax error: %s\n", (int) name.len,
+                name.ptr, line->line_number,
+                COMMAND_TYPE_CALL == command->type
+                    ? "typed calls can not be used in a `def` block"
+                    : "only `call` can be used in a `def` block"
+            );
+            n_problems += 1;
+            continue;
+        }
+
+        auto result = (ExecutorResult) {};
+        auto is_repeated = 0 != n_open_blocks;
+        auto repeated = *command;
+
+        // The parser already validated the repeated command
+        while (COMMAND_TYPE_REPEAT == repeated.type && 0 != repeated.body.len) {
+            repeated = command_parse(repeated.body).value;
+            command = &repeated;
+            is_repeated = true;
+        }
+
+        char const* syntax_error = nullptr;
+        auto typed_call = (TypedCall) {};
+
+        // The parser already validated the signature
+        if (COMMAND_TYPE_CALL == command->type) {
+            parse_typed_call(command->signature, &typed_call);
+        }
+
+        if (COMMAND_TYPE_REPEAT == command->type) {
+            block_line_number =
+                0 == n_open_blocks ? line->line_number : block_line_number;
+            n_open_blocks += 1;
+        } else if (COMMAND_TYPE_END == command->type && 0 == n_open_blocks) {
+            syntax_error = "`}` without an open `repeat` block";
+        } else if (COMMAND_TYPE_END == command->type) {
+            n_open_blocks -= 1;
+        } else if (is_repeated && COMMAND_TYPE_CALL != command->type &&
+                   COMMAND_TYPE_RUN != command->type)
+        {
+            syntax_error = "only `call`, `run` and `repeat` can be repeated";
+        } else if (is_repeated && typed_call.has_expected) {
+            syntax_error =
+                "typed calls with an expected result can not be repeated";
+        } else if (COMMAND_TYPE_DEF == command->type) {
+            auto key = (String) {.str = command->content};
+
+            if (!check_library_map_insert(procedures, key, i)) {
+                *check_library_map_get_ref(procedures, key) = i;
+            }
+
+            definition_line_number = line->line_number;
+        }
+
+        if (nullptr != syntax_error) {
+            fprintf(
+                report, "%.*s:%zu: syntax error: %s\n", (int) name.len,
+                name.ptr, line->line_number, syntax_error
+            );
+            n_problems += 1;
+            continue;
+        }
+
+        switch (command->type) {
+        case COMMAND_TYPE_USE: {
+            auto index = check_library_map_get(
+                indices, (String) {.str = command->content}
+            );
+            auto library = &state.libraries[index];
+
+            if (ELF_SUCCESS != library->image.status) {
+                result.status = EXECUTOR_LOAD_FAILED;
+                result.dl_error = library->image.error;
+            } else if (0 != command->alias.len) {
+                auto alias = (String) {.str = command->alias};
+
+                if (!check_library_map_insert(aliases, alias, index) &&
+                    index != check_library_map_get(aliases, alias))
+                {
+                    result.status = EXECUTOR_LOAD_FAILED;
+                    result.dl_error =
+                        Str("alias is already taken by another library");
+                }
+            } else if (!is_loaded[index]) {
+                is_loaded[index] = true;
+                loaded[n_loaded] = index;
+                n_loaded += 1;
+            }
+        } break;
+        case COMMAND_TYPE_CALL:
+        case COMMAND_TYPE_BENCH:
+            result = check_call(&state, aliases, loaded, n_loaded, command);
+            break;
+        case COMMAND_TYPE_RUN: {
+            auto key = (String) {.str = command->content};
+
+            if (!check_library_map_contains(procedures, key)) {
+                result.status = EXECUTOR_FIND_SYMBOL_FAILED;
+                result.dl_error = Str("no procedure defined with this name");
+                break;
+            }
+
+            auto definition = check_library_map_get_ref(procedures, key);
+            auto index = *definition;
+
+            // Calls of a procedure resolve when it runs, check them against
+            // the libraries of its first run
+            if (SIZE_MAX == index) {
+                break;
+            }
+
+            *definition = SIZE_MAX;
+
+            for (size_t j = index + 1; j < state.n_lines; ++j) {
+                auto body_line = &state.lines[j];
+                auto body = &body_line->value.command;
+
+                if (!body_line->is_valid || !body_line->value.has_command ||
+                    COMMAND_TYPE_CALL != body->type)
+                {
+                    if (body_line->value.has_command &&
+                        COMMAND_TYPE_END == body->type)
+                    {
+                        break;
+                    }
+
+                    continue;
+                }
+
+                auto call_result =
+                    check_call(&state, aliases, loaded, n_loaded, body);
+
+                if (EXECUTOR_SUCCESS != call_result.status) {
+                    check_report(
+                        report, name, body_line->line_number, body,
+                        call_result
+                    );
+                    n_problems += 1;
+                }
+            }
+        } break;
+        case COMMAND_TYPE_COMPARE: {
+            result = check_in_library(
+                &state, indices, command->baseline_path, command->content
+            );
+
+            if (EXECUTOR_SUCCESS == result.status) {
+                result = check_in_library(
+                    &state, indices, command->candidate_path, command->content
+                );
+            }
+        } break;
+        case COMMAND_TYPE_EXPECT:
+            // Depends on the output, only known when running
+            break;
+        case COMMAND_TYPE_REPEAT:
+        case COMMAND_TYPE_END:
+        case COMMAND_TYPE_DEF:
+            break;
+        }
+
+        if (EXECUTOR_SUCCESS != result.status) {
+            check_report(report, name, line->line_number, command, result);
+            n_problems += 1;
+        }
+    }
+
+    if (0 != definition_line_number) {
+        fprintf(
+            report,
+            "%.*s:%zu: syntax error: `def` block is not closed by `}`\n",
+            (int) name.len, name.ptr, definition_line_number
+        );
+        n_problems += 1;
+    }
+
+    if (0 != n_open_blocks) {
+        fprintf(
+            report,
+            "%.*s:%zu: syntax error: `repeat` block is not closed by `}`\n",
+            (int) name.len, name.ptr, block_line_number
+        );
+        n_problems += 1;
+    }
+
+    for (size_t i = 0; i < state.n_libraries; ++i) {
+        if (ELF_SUCCESS == state.libraries[i].image.status) {
+            elf_image_free(&state.libraries[i].image.value);
+        }
+    }
+
+    for (size_t i = 0; i < state.n_lines; ++i) {
+        string_free(&state.lines[i].text);
+    }
+
+    free(loaded);
+    free(is_loaded);
+    free(state.libraries);
+    free(state.lines);
+    check_library_map_free(procedures);
+    check_library_map_free(aliases);
+    check_library_map_free(indices);
+
+    return n_problems;
+}
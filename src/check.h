@@ -0,0 +1,21 @@
+#ifndef _SOTEST_CHECK_H
+#define _SOTEST_CHECK_H
+
+#include "str.h"
+
+#include <stdio.h>
+
+/// Validates a script without running it: every `use` target should be a
+/// loadable ELF shared object and every `call` should resolve against the
+/// `.dynsym` tables of the libraries `use`d before it. Libraries are only
+/// mapped read-only and checked in parallel, no library code is executed.
+///
+/// Each problem is written to `report` as `<name>:<line>: <STATUS>: <error>`
+/// where `<STATUS>` is an `ExecutorResult` status name.
+///
+/// # Return
+///
+/// The number of problems found
+size_t check_script(FILE* input, Str name, FILE* report);
+
+#endif  // !_SOTEST_CHECK_H
@@ -0,0 +1,141 @@
+#include "compare.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+/// Fraction of samples to run untimed before measuring
+size_t constexpr COMPARE_WARMUP_DIVISOR = 10;
+size_t constexpr COMPARE_BOOTSTRAP_RESAMPLES = 1000;
+
+static uint64_t compare_now_ns() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (uint64_t) time.tv_sec * 1000000000 + (uint64_t) time.tv_nsec;
+}
+
+static double compare_time_call(ExecutorFunction function) {
+    auto start = compare_now_ns();
+    function();
+    auto end = compare_now_ns();
+
+    return (double) (end - start);
+}
+
+static CompareSummary compare_summarize(double* samples, size_t len) {
+    stats_sort(samples, len);
+
+    return (CompareSummary) {
+        .median = stats_median(samples, len),
+        .p90 = stats_percentile(samples, len, 90.0),
+        .p99 = stats_percentile(samples, len, 99.0),
+        .mean = stats_mean(samples, len),
+    };
+}
+
+CompareResult compare_functions(
+    ExecutorFunction baseline, ExecutorFunction candidate,
+    CompareOptions options
+) {
+    auto n_samples = 0 == options.n_samples ? 1 : options.n_samples;
+    auto random = stats_random_new(options.seed);
+
+    for (size_t i = 0; i < n_samples / COMPARE_WARMUP_DIVISOR; ++i) {
+        baseline();
+        candidate();
+    }
+
+    auto baseline_samples = (double*) malloc(sizeof(double) * n_samples);
+    auto candidate_samples = (double*) malloc(sizeof(double) * n_samples);
+
+    for (size_t i = 0; i < n_samples; ++i) {
+        if (0 == (stats_random_next(&random) & 1)) {
+            baseline_samples[i] = compare_time_call(baseline);
+            candidate_samples[i] = compare_time_call(candidate);
+        } else {
+            candidate_samples[i] = compare_time_call(candidate);
+            baseline_samples[i] = compare_time_call(baseline);
+        }
+    }
+
+    auto result = (CompareResult) {
+        .n_samples = n_samples,
+        .test = stats_mann_whitney(
+            baseline_samples, n_samples, candidate_samples, n_samples
+        ),
+        .baseline = compare_summarize(baseline_samples, n_samples),
+        .candidate = compare_summarize(candidate_samples, n_samples),
+    };
+
+    result.speedup = result.baseline.median / result.candidate.median;
+    result.speedup_interval = stats_bootstrap_median_ratio(
+        baseline_samples, n_samples, candidate_samples, n_samples, 0.95,
+        COMPARE_BOOTSTRAP_RESAMPLES, &random
+    );
+    result.regression =
+        (result.candidate.median / result.baseline.median - 1.0) * 100.0;
+    result.is_regression = result.regression > options.max_regression &&
+                           result.test.p_value < COMPARE_SIGNIFICANCE;
+
+    free(candidate_samples);
+    free(baseline_samples);
+
+    return result;
+}
+
+CompareSummary compare_benchmark(
+    ExecutorFunction function, CompareOptions options
+) {
+    auto n_samples = 0 == options.n_samples ? 1 : options.n_samples;
+
+    for (size_t i = 0; i < n_samples / COMPARE_WARMUP_DIVISOR; ++i) {
+        function();
+    }
+
+    auto samples = (double*) malloc(sizeof(double) * n_samples);
+
+    for (size_t i = 0; i < n_samples; ++i) {
+        samples[i] = compare_time_call(function);
+    }
+
+    auto summary = compare_summarize(samples, n_samples);
+    free(samples);
+
+    return summary;
+}
+
+void compare_summary_write(
+    CompareSummary const* self, char const* name, Str path, FILE* stream
+) {
+    fprintf(
+        stream,
+        "  %-9s median %10.1f ns, p90 %10.1f ns, p99 %10.1f ns, mean "
+        "%10.1f ns  (%.*s)\n",
+        name, self->median, self->p90, self->p99, self->mean, (int) path.len,
+        path.ptr
+    );
+}
+
+void compare_result_write(
+    CompareResult const* self, Command const* command, FILE* stream
+) {
+    fprintf(
+        stream, "compare %.*s: %zu samples each\n", (int) command->content.len,
+        command->content.ptr, self->n_samples
+    );
+
+    compare_summary_write(
+        &self->baseline, "baseline", command->baseline_path, stream
+    );
+    compare_summary_write(
+        &self->candidate, "candidate", command->candidate_path, stream
+    );
+
+    fprintf(
+        stream,
+        "  speedup %.3fx (95%% CI %.3fx .. %.3fx), Mann-Whitney U = %.0f, "
+        "p = %.3g\n",
+        self->speedup, self->speedup_interval.low,
+        self->speedup_interval.high, self->test.u, self->test.p_value
+    );
+}
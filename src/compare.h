@@ -0,0 +1,66 @@
+#ifndef _SOTEST_COMPARE_H
+#define _SOTEST_COMPARE_H
+
+#include "interpreter.h"
+#include "stats.h"
+
+#include <stdio.h>
+
+typedef struct CompareOptions {
+    /// Number of timed calls of each implementation
+    size_t n_samples;
+    /// Largest allowed slowdown of the candidate in percent
+    double max_regression;
+    uint64_t seed;
+} CompareOptions;
+
+size_t constexpr COMPARE_DEFAULT_SAMPLES = 1000;
+double constexpr COMPARE_DEFAULT_MAX_REGRESSION = 10.0;
+/// Significance level of the Mann-Whitney test
+double constexpr COMPARE_SIGNIFICANCE = 0.05;
+
+typedef struct CompareSummary {
+    double median;
+    double p90;
+    double p99;
+    double mean;
+} CompareSummary;
+
+typedef struct CompareResult {
+    CompareSummary baseline;
+    CompareSummary candidate;
+    size_t n_samples;
+    /// `baseline.median / candidate.median`, more than 1 if the candidate is
+    /// faster
+    double speedup;
+    /// 95% bootstrap confidence interval of `speedup`
+    StatsInterval speedup_interval;
+    MannWhitneyResult test;
+    /// Slowdown of the candidate in percent, negative if it is faster
+    double regression;
+    /// The candidate is significantly slower than `max_regression` allows
+    bool is_regression;
+} CompareResult;
+
+/// Times both functions with calls alternated in a random order, so that
+/// drift (frequency scaling, cache state, other load) hits both equally
+CompareResult compare_functions(
+    ExecutorFunction baseline, ExecutorFunction candidate,
+    CompareOptions options
+);
+
+/// Times a single function the same way as `compare_functions` does, for
+/// `bench`. Only `options.n_samples` is used.
+CompareSummary compare_benchmark(
+    ExecutorFunction function, CompareOptions options
+);
+
+void compare_summary_write(
+    CompareSummary const* self, char const* name, Str path, FILE* stream
+);
+
+void compare_result_write(
+    CompareResult const* self, Command const* command, FILE* stream
+);
+
+#endif  // !_SOTEST_COMPARE_H
@@ -0,0 +1,66 @@
+#ifndef _SOTEST_CYCLES_H
+#define _SOTEST_CYCLES_H
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/// Reads the time stamp counter, a few nanoseconds and no system call. Other
+/// platforms count the virtual timer, or nanoseconds as a last resort.
+inline static uint64_t cycles_now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t value;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(value));
+
+    return value;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (uint64_t) time.tv_sec * 1000000000 + (uint64_t) time.tv_nsec;
+#endif
+}
+
+/// Pairs a counter reading with the monotonic clock, the rate of the counter
+/// is measured over everything between the start and a conversion
+typedef struct CycleClock {
+    uint64_t start_cycles;
+    uint64_t start_ns;
+} CycleClock;
+
+inline static uint64_t cycle_clock_now_ns() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (uint64_t) time.tv_sec * 1000000000 + (uint64_t) time.tv_nsec;
+}
+
+inline static CycleClock cycle_clock_start() {
+    return (CycleClock) {
+        .start_cycles = cycles_now(),
+        .start_ns = cycle_clock_now_ns(),
+    };
+}
+
+/// Shortest span the rate is measured over, waited for if needed
+uint64_t constexpr CYCLE_CLOCK_MIN_NS = 1000000;
+
+/// Counter ticks per nanosecond since the start
+inline static double cycle_clock_rate(CycleClock const* self) {
+    auto elapsed_ns = cycle_clock_now_ns() - self->start_ns;
+
+    while (elapsed_ns < CYCLE_CLOCK_MIN_NS) {
+        elapsed_ns = cycle_clock_now_ns() - self->start_ns;
+    }
+
+    auto elapsed_cycles = cycles_now() - self->start_cycles;
+
+    return (double) elapsed_cycles / (double) elapsed_ns;
+}
+
+#endif  // !_SOTEST_CYCLES_H
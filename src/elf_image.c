@@ -0,0 +1,394 @@
+#include "elf_image.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__)
+#define HOST_MACHINE EM_X86_64
+#elif defined(__aarch64__)
+#define HOST_MACHINE EM_AARCH64
+#else
+#define HOST_MACHINE EM_NONE
+#endif
+
+static ElfOpenResult elf_open_error(uint8_t status, Str error) {
+    return (ElfOpenResult) {
+        .status = status,
+        .error = error,
+    };
+}
+
+/// Checks that `[offset, offset + len)` lies inside of the image
+static bool elf_contains(ElfImage const* self, size_t offset, size_t len) {
+    return offset <= self->size && len <= self->size - offset;
+}
+
+static size_t elf_note_align(size_t len) { return (len + 3) & ~(size_t) 3; }
+
+/// Note type of USDT probes, owned by `stapsdt`
+uint32_t constexpr ELF_NT_STAPSDT = 3;
+
+/// Looks for the `NT_GNU_BUILD_ID` note in a bounds-checked note section, and
+/// remembers the section if it holds USDT probe notes
+static void elf_find_notes(ElfImage* self, Elf64_Shdr const* section) {
+    size_t offset = 0;
+
+    while (offset + sizeof(Elf64_Nhdr) <= section->sh_size) {
+        auto note =
+            (Elf64_Nhdr const*) (self->data + section->sh_offset + offset);
+        auto name_offset = offset + sizeof(Elf64_Nhdr);
+        auto desc_offset = name_offset + elf_note_align(note->n_namesz);
+        auto next_offset = desc_offset + elf_note_align(note->n_descsz);
+
+        if (next_offset > section->sh_size || next_offset <= offset) {
+            return;
+        }
+
+        auto name = self->data + section->sh_offset + name_offset;
+
+        if (ELF_NT_STAPSDT == note->n_type &&
+            sizeof("stapsdt") == note->n_namesz &&
+            0 == memcmp(name, "stapsdt", sizeof("stapsdt")))
+        {
+            self->probes = self->data + section->sh_offset;
+            self->probes_size = section->sh_size;
+        } else if (nullptr == self->build_id &&
+                   NT_GNU_BUILD_ID == note->n_type &&
+            sizeof("GNU") == note->n_namesz &&
+            0 == memcmp(name, "GNU", sizeof("GNU")))
+        {
+            self->build_id = self->data + section->sh_offset + desc_offset;
+            self->build_id_len = note->n_descsz;
+        }
+
+        offset = next_offset;
+    }
+}
+
+static ElfOpenResult elf_image_index(ElfImage image) {
+    if (image.size < sizeof(Elf64_Ehdr) ||
+        0 != memcmp(image.data, ELFMAG, SELFMAG))
+    {
+        return elf_open_error(ELF_INVALID, Str("not an ELF file"));
+    }
+
+    auto header = (Elf64_Ehdr const*) image.data;
+
+    if (ELFCLASS64 != header->e_ident[EI_CLASS] ||
+        ELFDATA2LSB != header->e_ident[EI_DATA] ||
+        (EM_NONE != HOST_MACHINE && HOST_MACHINE != header->e_machine))
+    {
+        return elf_open_error(
+            ELF_WRONG_ARCHITECTURE, Str("ELF file is built for another machine")
+        );
+    }
+
+    if (ET_DYN != header->e_type) {
+        return elf_open_error(
+            ELF_NOT_SHARED_OBJECT, Str("ELF file is not a shared object")
+        );
+    }
+
+    if (sizeof(Elf64_Shdr) != header->e_shentsize ||
+        !elf_contains(
+            &image, header->e_shoff, header->e_shnum * sizeof(Elf64_Shdr)
+        ))
+    {
+        return elf_open_error(ELF_INVALID, Str("malformed section headers"));
+    }
+
+    auto sections = (Elf64_Shdr const*) (image.data + header->e_shoff);
+    size_t dynsym_index = header->e_shnum;
+
+    for (size_t i = 0; i < header->e_shnum; ++i) {
+        if (SHT_DYNSYM == sections[i].sh_type) {
+            dynsym_index = i;
+            break;
+        }
+    }
+
+    if (dynsym_index == header->e_shnum) {
+        return elf_open_error(ELF_INVALID, Str("no dynamic symbol table"));
+    }
+
+    auto dynsym = &sections[dynsym_index];
+
+    if (dynsym->sh_link >= header->e_shnum ||
+        sizeof(Elf64_Sym) != dynsym->sh_entsize ||
+        !elf_contains(&image, dynsym->sh_offset, dynsym->sh_size))
+    {
+        return elf_open_error(
+            ELF_INVALID, Str("malformed dynamic symbol table")
+        );
+    }
+
+    auto dynstr = &sections[dynsym->sh_link];
+
+    if (0 == dynstr->sh_size ||
+        !elf_contains(&image, dynstr->sh_offset, dynstr->sh_size) ||
+        '\0' != image.data[dynstr->sh_offset + dynstr->sh_size - 1])
+    {
+        return elf_open_error(
+            ELF_INVALID, Str("malformed dynamic string table")
+        );
+    }
+
+    image.symbols = (Elf64_Sym const*) (image.data + dynsym->sh_offset);
+    image.n_symbols = dynsym->sh_size / sizeof(Elf64_Sym);
+    image.strings = (char const*) (image.data + dynstr->sh_offset);
+    image.strings_size = dynstr->sh_size;
+
+    for (size_t i = 0; i < header->e_shnum; ++i) {
+        auto section = &sections[i];
+
+        if (SHT_GNU_HASH == section->sh_type &&
+            dynsym_index == section->sh_link &&
+            0 == section->sh_offset % sizeof(uint32_t) &&
+            elf_contains(&image, section->sh_offset, section->sh_size))
+        {
+            image.gnu_hash =
+                (uint32_t const*) (image.data + section->sh_offset);
+            image.gnu_hash_len = section->sh_size / sizeof(uint32_t);
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < header->e_shnum; ++i) {
+        if (SHT_NOTE == sections[i].sh_type &&
+            elf_contains(&image, sections[i].sh_offset, sections[i].sh_size))
+        {
+            elf_find_notes(&image, &sections[i]);
+        }
+    }
+
+    return (ElfOpenResult) {
+        .status = ELF_SUCCESS,
+        .value = image,
+    };
+}
+
+ElfOpenResult elf_image_open(Str path) {
+    auto path_copy = STRING_EMPTY;
+    string_append(&path_copy, path);
+
+    int fd = open(path_copy.str.ptr, O_RDONLY | O_CLOEXEC);
+    string_free(&path_copy);
+
+    if (fd < 0) {
+        return elf_open_error(ELF_OPEN_FAILED, str_from_ptr(strerror(errno)));
+    }
+
+    struct stat status;
+
+    if (0 != fstat(fd, &status)) {
+        auto result =
+            elf_open_error(ELF_OPEN_FAILED, str_from_ptr(strerror(errno)));
+        close(fd);
+        return result;
+    }
+
+    if (!S_ISREG(status.st_mode) || 0 == status.st_size) {
+        close(fd);
+        return elf_open_error(ELF_INVALID, Str("not a regular ELF file"));
+    }
+
+    auto image = ELF_IMAGE_EMPTY;
+    image.size = (size_t) status.st_size;
+
+    void* data = mmap(nullptr, image.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (MAP_FAILED == data) {
+        return elf_open_error(ELF_OPEN_FAILED, str_from_ptr(strerror(errno)));
+    }
+
+    image.data = data;
+
+    auto result = elf_image_index(image);
+
+    if (ELF_SUCCESS != result.status) {
+        elf_image_free(&image);
+    }
+
+    return result;
+}
+
+static bool elf_symbol_matches(ElfImage const* self, size_t index, Str name) {
+    auto symbol = &self->symbols[index];
+    auto binding = ELF64_ST_BIND(symbol->st_info);
+    auto type = ELF64_ST_TYPE(symbol->st_info);
+
+    if (SHN_UNDEF == symbol->st_shndx ||
+        (STB_GLOBAL != binding && STB_WEAK != binding &&
+         STB_GNU_UNIQUE != binding) ||
+        STT_SECTION == type || STT_FILE == type)
+    {
+        return false;
+    }
+
+    size_t offset = symbol->st_name;
+
+    return offset < self->strings_size &&
+           name.len < self->strings_size - offset &&
+           0 == memcmp(self->strings + offset, name.ptr, name.len) &&
+           '\0' == self->strings[offset + name.len];
+}
+
+static uint32_t elf_gnu_hash(Str name) {
+    uint32_t hash = 5381;
+
+    for (size_t i = 0; i < name.len; ++i) {
+        hash = hash * 33 + (uint8_t) name.ptr[i];
+    }
+
+    return hash;
+}
+
+/// Lookup through `.gnu.hash`: bloom filter, then a single hash chain
+static bool elf_gnu_hash_exports(ElfImage const* self, Str name) {
+    auto table = self->gnu_hash;
+
+    if (self->gnu_hash_len < 4) {
+        return false;
+    }
+
+    uint32_t n_buckets = table[0];
+    uint32_t symbol_offset = table[1];
+    uint32_t bloom_size = table[2];
+    uint32_t bloom_shift = table[3];
+
+    // Header, 64-bit bloom words and buckets should be in bounds
+    size_t chain_start = 4 + 2 * (size_t) bloom_size + n_buckets;
+
+    if (0 == n_buckets || 0 == bloom_size || chain_start > self->gnu_hash_len) {
+        return false;
+    }
+
+    auto hash = elf_gnu_hash(name);
+    uint64_t word;
+    memcpy(&word, &table[4 + 2 * ((hash / 64) % bloom_size)], sizeof(word));
+
+    uint64_t mask = ((uint64_t) 1 << (hash % 64)) |
+                    ((uint64_t) 1 << ((hash >> bloom_shift) % 64));
+
+    if ((word & mask) != mask) {
+        return false;
+    }
+
+    size_t index = table[4 + 2 * (size_t) bloom_size + hash % n_buckets];
+
+    if (index < symbol_offset) {
+        return false;
+    }
+
+    for (; index < self->n_symbols; ++index) {
+        size_t chain_index = chain_start + index - symbol_offset;
+
+        if (chain_index >= self->gnu_hash_len) {
+            return false;
+        }
+
+        uint32_t chain_hash = table[chain_index];
+
+        if ((hash | 1) == (chain_hash | 1) &&
+            elf_symbol_matches(self, index, name))
+        {
+            return true;
+        }
+
+        // The lowest bit marks the end of the chain
+        if (0 != (chain_hash & 1)) {
+            break;
+        }
+    }
+
+    return false;
+}
+
+bool elf_image_exports(ElfImage const* self, Str name) {
+    if (nullptr != self->gnu_hash) {
+        return elf_gnu_hash_exports(self, name);
+    }
+
+    for (size_t i = 0; i < self->n_symbols; ++i) {
+        if (elf_symbol_matches(self, i, name)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// Reads a nul-terminated string of a probe note, advancing `offset`
+static Str elf_note_string(
+    uint8_t const* desc, size_t desc_len, size_t* offset
+) {
+    auto start = (char const*) desc + *offset;
+    auto end = memchr(start, '\0', desc_len - *offset);
+
+    if (nullptr == end) {
+        *offset = desc_len;
+        return STR_NULL;
+    }
+
+    auto len = (size_t) ((char const*) end - start);
+    *offset += len + 1;
+
+    return (Str) {.ptr = (char*) start, .len = len};
+}
+
+bool elf_image_has_probe(ElfImage const* self, Str provider, Str name) {
+    size_t offset = 0;
+
+    while (offset + sizeof(Elf64_Nhdr) <= self->probes_size) {
+        auto note = (Elf64_Nhdr const*) (self->probes + offset);
+        auto desc_offset =
+            offset + sizeof(Elf64_Nhdr) + elf_note_align(note->n_namesz);
+        auto next_offset = desc_offset + elf_note_align(note->n_descsz);
+
+        if (next_offset > self->probes_size || next_offset <= offset) {
+            return false;
+        }
+
+        // The probe address, the base and the semaphore come first
+        size_t string_offset = 3 * sizeof(uint64_t);
+
+        if (ELF_NT_STAPSDT == note->n_type &&
+            string_offset < note->n_descsz)
+        {
+            auto desc = self->probes + desc_offset;
+            auto note_provider =
+                elf_note_string(desc, note->n_descsz, &string_offset);
+            auto note_name =
+                elf_note_string(desc, note->n_descsz, &string_offset);
+
+            if (str_eq(note_provider, provider) && str_eq(note_name, name)) {
+                return true;
+            }
+        }
+
+        offset = next_offset;
+    }
+
+    return false;
+}
+
+void elf_image_build_id_hex(ElfImage const* self, String* out) {
+    static char const digits[] = "0123456789abcdef";
+
+    for (size_t i = 0; i < self->build_id_len; ++i) {
+        string_push(out, digits[self->build_id[i] >> 4]);
+        string_push(out, digits[self->build_id[i] & 0xf]);
+    }
+}
+
+void elf_image_free(ElfImage* self) {
+    if (nullptr != self->data) {
+        munmap((void*) self->data, self->size);
+    }
+
+    *self = ELF_IMAGE_EMPTY;
+}
@@ -0,0 +1,69 @@
+#ifndef _SOTEST_ELF_IMAGE_H
+#define _SOTEST_ELF_IMAGE_H
+
+#include "str.h"
+
+#include <elf.h>
+#include <stdint.h>
+
+/// Read-only memory mapped shared object with its dynamic symbol table.
+/// Reading symbols this way runs no code from the library, unlike `dlopen`.
+typedef struct ElfImage {
+    uint8_t const* data;
+    size_t size;
+    Elf64_Sym const* symbols;
+    size_t n_symbols;
+    char const* strings;
+    size_t strings_size;
+    /// `.gnu.hash` section words, `nullptr` if the image has none
+    uint32_t const* gnu_hash;
+    size_t gnu_hash_len;
+    /// `NT_GNU_BUILD_ID` note bytes, `nullptr` if the image has none
+    uint8_t const* build_id;
+    size_t build_id_len;
+    /// `.note.stapsdt` section of USDT probe notes, `nullptr` if the image
+    /// has none
+    uint8_t const* probes;
+    size_t probes_size;
+} ElfImage;
+
+ElfImage constexpr ELF_IMAGE_EMPTY = {};
+
+typedef struct ElfOpenResult {
+    enum : uint8_t {
+        ELF_SUCCESS = 0,
+        ELF_OPEN_FAILED = 1,
+        ELF_INVALID = 2,
+        ELF_NOT_SHARED_OBJECT = 3,
+        ELF_WRONG_ARCHITECTURE = 4,
+    } status;
+
+    /// Available only if `status != ELF_SUCCESS`, nul-terminated
+    Str error;
+    /// Available only if `status == ELF_SUCCESS`
+    ElfImage value;
+} ElfOpenResult;
+
+/// Maps the file at `path` and locates its `.dynsym` table
+///
+/// # Error
+///
+/// Returns `.status = ELF_OPEN_FAILED` if the file can not be opened or mapped,
+/// `.status = ELF_INVALID` for malformed files and the other statuses if the
+/// file is a well-formed ELF which still can not be loaded by this process
+ElfOpenResult elf_image_open(Str path);
+
+/// Checks if the image defines a global symbol named `name`, the same
+/// symbols `dlsym` could find in this library itself
+bool elf_image_exports(ElfImage const* self, Str name);
+
+/// Checks if the image has a USDT probe note (`<sys/sdt.h>` format) for
+/// `<provider>:<name>`
+bool elf_image_has_probe(ElfImage const* self, Str provider, Str name);
+
+/// Appends the build-id as lowercase hex, nothing if the image has none
+void elf_image_build_id_hex(ElfImage const* self, String* out);
+
+void elf_image_free(ElfImage* self);
+
+#endif  // !_SOTEST_ELF_IMAGE_H
@@ -0,0 +1,401 @@
+#define _GNU_SOURCE
+
+#include "environment.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <link.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+/// Relative difference of consecutive warm-up rounds considered stable
+double constexpr ENVIRONMENT_WARMUP_TOLERANCE = 0.01;
+size_t constexpr ENVIRONMENT_WARMUP_STABLE_ROUNDS = 3;
+uint64_t constexpr ENVIRONMENT_WARMUP_ROUND_NS = 1000000;
+
+static void environment_add_noise(Environment* self, char const* format, ...) {
+    char line[256];
+
+    va_list arguments;
+    va_start(arguments, format);
+    vsnprintf(line, sizeof(line), format, arguments);
+    va_end(arguments);
+
+    string_append(&self->noise, Str("noise: "));
+    string_append(&self->noise, str_from_ptr(line));
+    string_push(&self->noise, '\n');
+}
+
+/// Reads the first line of a small (e.g. `/sys`) file
+static bool environment_read_line(char const* path, char* buffer, size_t size) {
+    auto file = fopen(path, "r");
+
+    if (nullptr == file) {
+        return false;
+    }
+
+    auto success = nullptr != fgets(buffer, (int) size, file);
+    fclose(file);
+
+    if (success) {
+        buffer[strcspn(buffer, "\n")] = '\0';
+    }
+
+    return success;
+}
+
+/// Parses a CPU list like `0,2-3` as printed by the kernel
+static bool environment_parse_cpus(Str source, cpu_set_t* set) {
+    CPU_ZERO(set);
+
+    size_t i = 0;
+
+    while (i < source.len) {
+        size_t first = 0;
+        size_t start = i;
+
+        for (; i < source.len && isdigit(source.ptr[i]); ++i) {
+            first = 10 * first + (size_t) (source.ptr[i] - '0');
+        }
+
+        if (start == i) {
+            return false;
+        }
+
+        auto last = first;
+
+        if (i < source.len && '-' == source.ptr[i]) {
+            last = 0;
+            start = ++i;
+
+            for (; i < source.len && isdigit(source.ptr[i]); ++i) {
+                last = 10 * last + (size_t) (source.ptr[i] - '0');
+            }
+
+            if (start == i || last < first) {
+                return false;
+            }
+        }
+
+        if (last >= CPU_SETSIZE) {
+            return false;
+        }
+
+        for (auto cpu = first; cpu <= last; ++cpu) {
+            CPU_SET(cpu, set);
+        }
+
+        if (i < source.len && ',' != source.ptr[i++]) {
+            return false;
+        }
+    }
+
+    return 0 != CPU_COUNT(set);
+}
+
+static void environment_pin(Environment* self) {
+    cpu_set_t set;
+
+    if (!environment_parse_cpus(self->options.cpus, &set)) {
+        fprintf(
+            stderr, "error: invalid CPU list '%.*s'\n",
+            (int) self->options.cpus.len, self->options.cpus.ptr
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    if (0 != sched_setaffinity(0, sizeof(set), &set)) {
+        environment_add_noise(self, "could not pin: %s", strerror(errno));
+    }
+}
+
+static void environment_lock_memory(Environment* self) {
+    if (0 != mlockall(MCL_CURRENT | MCL_FUTURE)) {
+        environment_add_noise(
+            self, "could not lock memory: %s, pre-faulting only",
+            strerror(errno)
+        );
+    }
+}
+
+static void environment_raise_priority(Environment* self) {
+    if (0 != setpriority(PRIO_PROCESS, 0, -20)) {
+        environment_add_noise(
+            self, "could not raise priority: %s", strerror(errno)
+        );
+    }
+}
+
+static uint64_t environment_now_ns() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (uint64_t) time.tv_sec * 1000000000 + (uint64_t) time.tv_nsec;
+}
+
+static uint64_t environment_spin(size_t n_iterations) {
+    volatile uint64_t value = 1;
+
+    for (size_t i = 0; i < n_iterations; ++i) {
+        value = value * 6364136223846793005ull + 1442695040888963407ull;
+    }
+
+    return value;
+}
+
+/// Spins with a fixed amount of work per round until round times stop
+/// changing, i.e. the CPU left its idle state and the frequency settled
+static void environment_warm_up(Environment* self) {
+    auto deadline =
+        environment_now_ns() + self->options.warmup_ms * 1000000ull;
+
+    // Calibrate the amount of work per round to take about a millisecond
+    size_t n_iterations = 1024;
+
+    while (true) {
+        auto start = environment_now_ns();
+        environment_spin(n_iterations);
+
+        if (environment_now_ns() - start >= ENVIRONMENT_WARMUP_ROUND_NS) {
+            break;
+        }
+
+        n_iterations *= 2;
+    }
+
+    size_t n_stable = 0;
+    double previous = 0.0;
+
+    while (environment_now_ns() < deadline) {
+        auto start = environment_now_ns();
+        environment_spin(n_iterations);
+        auto elapsed = (double) (environment_now_ns() - start);
+
+        auto change = previous > 0.0 ? (elapsed - previous) / previous : 1.0;
+        previous = elapsed;
+
+        n_stable = change < ENVIRONMENT_WARMUP_TOLERANCE &&
+                           change > -ENVIRONMENT_WARMUP_TOLERANCE
+                       ? n_stable + 1
+                       : 0;
+
+        if (n_stable >= ENVIRONMENT_WARMUP_STABLE_ROUNDS) {
+            return;
+        }
+    }
+
+    environment_add_noise(
+        self, "timings did not settle within %zu ms of warm-up",
+        self->options.warmup_ms
+    );
+}
+
+static void environment_detect_noise(Environment* self) {
+    cpu_set_t set;
+
+    if (0 != sched_getaffinity(0, sizeof(set), &set)) {
+        return;
+    }
+
+    char path[128];
+    char line[128];
+    size_t n_reported_governors = 0;
+
+    // Hosts with SMT have siblings on every core, one line says it all
+    size_t n_smt_cpus = 0;
+    size_t first_smt_cpu = 0;
+    char first_siblings[128];
+
+    for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &set)) {
+            continue;
+        }
+
+        snprintf(
+            path, sizeof(path),
+            "/sys/devices/system/cpu/cpu%zu/cpufreq/scaling_governor", cpu
+        );
+
+        if (environment_read_line(path, line, sizeof(line)) &&
+            0 != strcmp(line, "performance") && 0 == n_reported_governors++)
+        {
+            environment_add_noise(
+                self, "cpu %zu frequency governor is '%s', not 'performance'",
+                cpu, line
+            );
+        }
+
+        snprintf(
+            path, sizeof(path),
+            "/sys/devices/system/cpu/cpu%zu/topology/thread_siblings_list",
+            cpu
+        );
+
+        cpu_set_t siblings;
+
+        if (environment_read_line(path, line, sizeof(line)) &&
+            environment_parse_cpus(str_from_ptr(line), &siblings) &&
+            CPU_COUNT(&siblings) > 1 && 0 == n_smt_cpus++)
+        {
+            first_smt_cpu = cpu;
+            snprintf(first_siblings, sizeof(first_siblings), "%s", line);
+        }
+    }
+
+    if (1 == n_smt_cpus) {
+        environment_add_noise(
+            self, "cpu %zu shares its core with SMT siblings %s",
+            first_smt_cpu, first_siblings
+        );
+    } else if (1 < n_smt_cpus) {
+        environment_add_noise(
+            self,
+            "%zu cpus share their cores with SMT siblings, e.g. cpu %zu "
+            "with %s",
+            n_smt_cpus, first_smt_cpu, first_siblings
+        );
+    }
+
+    if ((environment_read_line(
+             "/sys/devices/system/cpu/intel_pstate/no_turbo", line,
+             sizeof(line)
+         ) &&
+         0 == strcmp(line, "0")) ||
+        (environment_read_line(
+             "/sys/devices/system/cpu/cpufreq/boost", line, sizeof(line)
+         ) &&
+         0 == strcmp(line, "1")))
+    {
+        environment_add_noise(self, "turbo boost is enabled");
+    }
+
+    if (environment_read_line("/proc/loadavg", line, sizeof(line))) {
+        auto load = strtod(line, nullptr);
+        auto n_online = (double) sysconf(_SC_NPROCESSORS_ONLN);
+
+        // This process accounts for about one
+        if (load - 1.0 > 0.25 * n_online) {
+            environment_add_noise(
+                self, "load average is %.2f on %.0f cpus", load, n_online
+            );
+        }
+    }
+}
+
+Environment environment_setup(EnvironmentOptions options) {
+    auto self = (Environment) {
+        .options = options,
+        .noise = STRING_EMPTY,
+    };
+
+    if (0 != options.cpus.len) {
+        environment_pin(&self);
+    }
+
+    if (options.lock_memory) {
+        environment_lock_memory(&self);
+    }
+
+    if (options.high_priority) {
+        environment_raise_priority(&self);
+    }
+
+    if (0 != options.warmup_ms) {
+        environment_warm_up(&self);
+    }
+
+    environment_detect_noise(&self);
+
+    return self;
+}
+
+static int environment_prefault_object(
+    struct dl_phdr_info* info, size_t size, void* argument
+) {
+    Environment* self = argument;
+    auto page_size = (uintptr_t) sysconf(_SC_PAGESIZE);
+
+    if (size >= offsetof(struct dl_phdr_info, dlpi_subs) &&
+        info->dlpi_adds > self->prefaulted_adds)
+    {
+        self->prefaulted_adds = info->dlpi_adds;
+    }
+
+    for (size_t i = 0; i < info->dlpi_phnum; ++i) {
+        auto header = &info->dlpi_phdr[i];
+
+        if (PT_LOAD != header->p_type || 0 == (header->p_flags & PF_X)) {
+            continue;
+        }
+
+        auto start = info->dlpi_addr + header->p_vaddr;
+        auto end = start + header->p_memsz;
+        start &= ~(page_size - 1);
+
+#ifdef MADV_POPULATE_READ
+        if (0 == madvise((void*) start, end - start, MADV_POPULATE_READ)) {
+            continue;
+        }
+#endif
+
+        madvise((void*) start, end - start, MADV_WILLNEED);
+
+        // Touch every page in case the kernel ignores the advice
+        for (auto page = start; page < end; page += page_size) {
+            (void) *(uint8_t volatile const*) page;
+        }
+    }
+
+    return 0;
+}
+
+static int environment_read_adds(
+    struct dl_phdr_info* info, size_t size, void* argument
+) {
+    if (size >= offsetof(struct dl_phdr_info, dlpi_subs)) {
+        *(unsigned long long*) argument = info->dlpi_adds;
+    }
+
+    // The counter is the same for every object, stop after the first
+    return 1;
+}
+
+void environment_prefault_libraries(Environment* self) {
+    if (!self->options.lock_memory) {
+        return;
+    }
+
+    unsigned long long adds = 0;
+    dl_iterate_phdr(environment_read_adds, &adds);
+
+    if (0 != adds && adds == self->prefaulted_adds) {
+        return;
+    }
+
+    dl_iterate_phdr(environment_prefault_object, self);
+}
+
+void environment_write_noise(
+    Environment const* self, char const* indent, FILE* stream
+) {
+    auto noise = self->noise.str;
+
+    while (0 != noise.len) {
+        size_t end = 0;
+
+        while (end < noise.len && '\n' != noise.ptr[end]) {
+            end += 1;
+        }
+
+        fputs(indent, stream);
+        str_write(str_slice(noise, 0, end + 1), stream);
+        noise = str_slice(noise, end + 1, noise.len);
+    }
+}
+
+void environment_free(Environment* self) { string_free(&self->noise); }
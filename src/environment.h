@@ -0,0 +1,51 @@
+#ifndef _SOTEST_ENVIRONMENT_H
+#define _SOTEST_ENVIRONMENT_H
+
+#include "str.h"
+
+#include <stdio.h>
+
+typedef struct EnvironmentOptions {
+    /// CPU list like `2,4-5` to pin the interpreter to, empty to keep
+    Str cpus;
+    /// Lock all memory with `mlockall` and pre-fault library text
+    bool lock_memory;
+    /// Try to raise the scheduling priority
+    bool high_priority;
+    /// Budget of the warm-up phase in milliseconds, zero disables it
+    size_t warmup_ms;
+} EnvironmentOptions;
+
+/// Benchmarking environment of the interpreter process itself
+typedef struct Environment {
+    EnvironmentOptions options;
+    /// Noise sources found, one `noise: ...` line each
+    String noise;
+    /// `dlpi_adds` of the last pre-fault pass, to skip it if nothing new was
+    /// loaded since
+    unsigned long long prefaulted_adds;
+} Environment;
+
+/// Applies the options and looks for noise sources: frequency scaling, SMT
+/// siblings and other load. Failures to apply an option are reported as noise
+/// as well, the interpreter runs anyway.
+///
+/// # Error
+///
+/// Exits with an error message if `options.cpus` is malformed
+Environment environment_setup(EnvironmentOptions options);
+
+/// Pre-faults executable segments of all loaded libraries, so the first
+/// timed calls do not pay for page faults. Does nothing unless
+/// `options.lock_memory` is set or if no library was loaded since the last
+/// call.
+void environment_prefault_libraries(Environment* self);
+
+/// Writes the noise report with each line prefixed by `indent`
+void environment_write_noise(
+    Environment const* self, char const* indent, FILE* stream
+);
+
+void environment_free(Environment* self);
+
+#endif  // !_SOTEST_ENVIRONMENT_H
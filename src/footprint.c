@@ -0,0 +1,275 @@
+#define _GNU_SOURCE
+
+#include "footprint.h"
+#include "monitor.h"
+
+#include <fcntl.h>
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/// Finds `<field>: <value> kB` in the contents of `smaps_rollup`
+static bool footprint_parse_field(
+    char const* source, char const* field, int64_t* bytes
+) {
+    auto line = strstr(source, field);
+
+    if (nullptr == line) {
+        return false;
+    }
+
+    char* end = nullptr;
+    auto kilobytes = strtoll(line + strlen(field), &end, 10);
+
+    if (end == line + strlen(field)) {
+        return false;
+    }
+
+    *bytes = kilobytes * 1024;
+    return true;
+}
+
+bool footprint_sample(FootprintSample* out) {
+    *out = (FootprintSample) {};
+
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    auto info = mallinfo2();
+    out->heap = (int64_t) (info.uordblks + info.hblkhd);
+#endif
+
+    // Read at once without `stdio`, whose buffer would show in the heap
+    char buffer[4096];
+    auto fd = open("/proc/self/smaps_rollup", O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    auto len = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+
+    if (len <= 0) {
+        return false;
+    }
+
+    buffer[len] = '\0';
+
+    if (!footprint_parse_field(buffer, "\nRss:", &out->rss) ||
+        !footprint_parse_field(buffer, "\nAnonymous:", &out->anonymous))
+    {
+        return false;
+    }
+
+    out->file = out->rss - out->anonymous;
+    return true;
+}
+
+static FootprintSample footprint_sample_sub(
+    FootprintSample a, FootprintSample b
+) {
+    return (FootprintSample) {
+        .rss = a.rss - b.rss,
+        .anonymous = a.anonymous - b.anonymous,
+        .file = a.file - b.file,
+        .heap = a.heap - b.heap,
+    };
+}
+
+static FootprintSample footprint_sample_add(
+    FootprintSample a, FootprintSample b
+) {
+    return (FootprintSample) {
+        .rss = a.rss + b.rss,
+        .anonymous = a.anonymous + b.anonymous,
+        .file = a.file + b.file,
+        .heap = a.heap + b.heap,
+    };
+}
+
+void footprint_start(
+    Footprint* self, size_t period, uint64_t max_growth, FILE* series
+) {
+    *self = (Footprint) {
+        .period = 0 == period ? FOOTPRINT_DEFAULT_PERIOD : period,
+        .max_growth = max_growth,
+        .series = series,
+        .exceeded = STRING_EMPTY,
+    };
+
+    if (nullptr != series) {
+        fprintf(
+            series, "# time_ms\tkind\tname\tcalls\trss\tanonymous\tfile\theap"
+                    "\trss_delta\tanonymous_delta\tfile_delta\theap_delta\n"
+        );
+        fflush(series);
+    }
+
+    self->start_ns = monitor_now_ns();
+    footprint_sample(&self->start);
+}
+
+/// Attributes a sample to the usage and writes it to the series
+static void footprint_add(
+    Footprint* self, FootprintUsage* usage, char const* kind,
+    uint64_t n_calls, FootprintSample const* before
+) {
+    FootprintSample after;
+    footprint_sample(&after);
+
+    auto delta = footprint_sample_sub(after, *before);
+
+    if (0 == usage->n_samples) {
+        usage->first = delta;
+    } else {
+        usage->n_calls += n_calls;
+        usage->growth = footprint_sample_add(usage->growth, delta);
+    }
+
+    usage->n_samples += 1;
+
+    if (nullptr == self->series) {
+        return;
+    }
+
+    fprintf(
+        self->series,
+        "%.3f\t%s\t%.*s\t%llu\t%lld\t%lld\t%lld\t%lld\t%lld\t%lld\t%lld"
+        "\t%lld\n",
+        (double) (monitor_now_ns() - self->start_ns) / 1e6, kind,
+        (int) usage->name.len, usage->name.ptr, (unsigned long long) n_calls,
+        (long long) after.rss, (long long) after.anonymous,
+        (long long) after.file, (long long) after.heap, (long long) delta.rss,
+        (long long) delta.anonymous, (long long) delta.file,
+        (long long) delta.heap
+    );
+}
+
+void footprint_add_calls(
+    Footprint* self, FootprintUsage* usage, uint64_t n_calls,
+    FootprintSample const* before
+) {
+    footprint_add(self, usage, "call", n_calls, before);
+
+    int64_t growth = 0;
+
+    if (0 == self->max_growth || 0 != self->exceeded.str.len ||
+        !footprint_usage_rate(self, usage, &growth) ||
+        growth <= (int64_t) self->max_growth)
+    {
+        return;
+    }
+
+    string_append(&self->exceeded, usage->name);
+    self->exceeded_growth = growth;
+}
+
+void footprint_add_library(
+    Footprint* self, Str path, FootprintSample const* before
+) {
+    auto libraries = &self->libraries;
+    FootprintLibrary* library = nullptr;
+
+    for (size_t i = 0; i < libraries->len; ++i) {
+        if (str_eq(libraries->ptr[i].path.str, path)) {
+            library = &libraries->ptr[i];
+            break;
+        }
+    }
+
+    if (nullptr == library) {
+        if (0 == libraries->cap) {
+            libraries->cap = 8;
+            libraries->ptr = malloc(sizeof(*libraries->ptr) * libraries->cap);
+        } else if (libraries->len == libraries->cap) {
+            libraries->cap += libraries->cap / 2;
+            libraries->ptr = realloc(
+                libraries->ptr, sizeof(*libraries->ptr) * libraries->cap
+            );
+        }
+
+        library = &libraries->ptr[libraries->len];
+        libraries->len += 1;
+
+        *library = (FootprintLibrary) {.path = STRING_EMPTY};
+        string_append(&library->path, path);
+        library->usage.name = library->path.str;
+    }
+
+    footprint_add(self, &library->usage, "use", 1, before);
+}
+
+bool footprint_usage_rate(
+    Footprint const* self, FootprintUsage const* usage, int64_t* growth
+) {
+    if (0 == usage->n_calls) {
+        return false;
+    }
+
+    *growth = (int64_t) ((double) usage->growth.heap /
+                         (double) usage->n_calls * (double) self->period);
+    return true;
+}
+
+void footprint_write_header(Footprint const* self, FILE* output) {
+    FootprintSample now;
+    footprint_sample(&now);
+
+    auto delta = footprint_sample_sub(now, self->start);
+
+    fprintf(
+        output,
+        "memory: rss %lld (%+lld), anonymous %lld (%+lld), file %lld (%+lld), "
+        "heap %lld (%+lld) bytes\n",
+        (long long) now.rss, (long long) delta.rss, (long long) now.anonymous,
+        (long long) delta.anonymous, (long long) now.file,
+        (long long) delta.file, (long long) now.heap, (long long) delta.heap
+    );
+
+    char rate[32];
+    snprintf(rate, sizeof(rate), "heap/%zu", self->period);
+
+    fprintf(
+        output, "  %-32s %12s %8s %12s %12s %12s %12s %12s\n", "name",
+        "calls", "samples", "heap", rate, "rss", "anonymous", "file"
+    );
+
+    for (size_t i = 0; i < self->libraries.len; ++i) {
+        auto usage = &self->libraries.ptr[i].usage;
+        footprint_write_usage(self, usage, usage->n_samples, output);
+    }
+}
+
+void footprint_write_usage(
+    Footprint const* self, FootprintUsage const* usage, uint64_t n_calls,
+    FILE* output
+) {
+    auto total = footprint_sample_add(usage->first, usage->growth);
+    int64_t growth = 0;
+    char rate[32] = "-";
+
+    if (footprint_usage_rate(self, usage, &growth)) {
+        snprintf(rate, sizeof(rate), "%+lld", (long long) growth);
+    }
+
+    fprintf(
+        output,
+        "  %-32.*s %12llu %8llu %+12lld %12s %+12lld %+12lld %+12lld\n",
+        (int) usage->name.len, usage->name.ptr, (unsigned long long) n_calls,
+        (unsigned long long) usage->n_samples, (long long) total.heap, rate,
+        (long long) total.rss, (long long) total.anonymous,
+        (long long) total.file
+    );
+}
+
+void footprint_free(Footprint* self) {
+    for (size_t i = 0; i < self->libraries.len; ++i) {
+        string_free(&self->libraries.ptr[i].path);
+    }
+
+    free(self->libraries.ptr);
+    string_free(&self->exceeded);
+
+    *self = (Footprint) {};
+}
@@ -0,0 +1,139 @@
+#ifndef _SOTEST_FOOTPRINT_H
+#define _SOTEST_FOOTPRINT_H
+
+#include "str.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/// Calls of a function per sample, and the calls the growth limit is per.
+/// A sample reads `/proc/self/smaps_rollup`, some 15 us, so it is kept rare
+/// next to calls of a few nanoseconds.
+size_t constexpr FOOTPRINT_DEFAULT_PERIOD = 10000;
+
+/// Memory of the process in bytes, or the difference of two samples
+typedef struct FootprintSample {
+    /// Resident set size
+    int64_t rss;
+    /// Resident anonymous memory: heap, stacks and private mappings
+    int64_t anonymous;
+    /// Resident file-backed memory: library code and data, mapped files
+    int64_t file;
+    /// Bytes `malloc`ed and not yet freed, from `mallinfo2`
+    int64_t heap;
+} FootprintSample;
+
+/// Growth attributed to a library or a function
+typedef struct FootprintUsage {
+    /// Path of the library or name of the function, owned elsewhere
+    Str name;
+    uint64_t n_samples;
+    /// Growth of the first sample, one-off allocations of a library's
+    /// initialization or a function's first call
+    FootprintSample first;
+    /// Calls covered by the samples after the first
+    uint64_t n_calls;
+    /// Growth of the samples after the first
+    FootprintSample growth;
+} FootprintUsage;
+
+typedef struct FootprintLibrary {
+    String path;
+    /// Named by `path`, each `use` of the library is counted as a call
+    FootprintUsage usage;
+} FootprintLibrary;
+
+/// Libraries in load order
+typedef struct FootprintLibraries {
+    FootprintLibrary* ptr;
+    size_t len;
+    size_t cap;
+} FootprintLibraries;
+
+/// Memory accounting of `--mem-report`. Library loads are measured each,
+/// calls of a function one in `period`, see `footprint_begin`.
+typedef struct Footprint {
+    size_t period;
+    /// Heap growth per `period` calls a function may show, 0 for no limit
+    uint64_t max_growth;
+    /// Tab-separated time series of the samples, `nullptr` if not written
+    FILE* series;
+    uint64_t start_ns;
+    FootprintSample start;
+    FootprintLibraries libraries;
+    /// Function which grew beyond `max_growth` first, empty if none
+    String exceeded;
+    /// Heap growth per `period` calls of `exceeded`
+    int64_t exceeded_growth;
+} Footprint;
+
+/// Reads the resident memory from `/proc/self/smaps_rollup` and the heap
+/// from `mallinfo2`. Neither allocates, the heap is not disturbed.
+///
+/// # Error
+///
+/// Returns `false` if the resident memory can not be read, only `heap` is
+/// set then
+bool footprint_sample(FootprintSample* out);
+
+/// Takes the start sample and writes the header of the time series
+void footprint_start(
+    Footprint* self, size_t period, uint64_t max_growth, FILE* series
+);
+
+/// Samples the memory before a call if its turn has come, the first call of
+/// a function included
+///
+/// # Return
+///
+/// `true` if sampled, `footprint_add_calls` is to follow the calls
+inline static bool footprint_begin(
+    Footprint* self, uint64_t n_calls, FootprintSample* before
+) {
+    if (nullptr == self || 0 != n_calls % self->period) {
+        return false;
+    }
+
+    footprint_sample(before);
+    return true;
+}
+
+/// Samples the memory after `n_calls` calls and attributes the growth since
+/// `before` to the function. Notes the function in `exceeded` once its heap
+/// growth per `period` calls is beyond `max_growth`.
+void footprint_add_calls(
+    Footprint* self, FootprintUsage* usage, uint64_t n_calls,
+    FootprintSample const* before
+);
+
+/// Samples the memory after a library load and attributes the growth since
+/// `before` to the library
+void footprint_add_library(
+    Footprint* self, Str path, FootprintSample const* before
+);
+
+/// Heap growth per `period` calls from the samples after the first
+///
+/// # Return
+///
+/// `false` if there are no such samples
+bool footprint_usage_rate(
+    Footprint const* self, FootprintUsage const* usage, int64_t* growth
+);
+
+/// Writes the growth since the start, the libraries and the header of the
+/// function rows
+void footprint_write_header(Footprint const* self, FILE* output);
+
+/// Writes a row of a library or function in the table of
+/// `footprint_write_header`. The heap, resident and file columns add up all
+/// samples, the rate leaves out the first.
+void footprint_write_usage(
+    Footprint const* self, FootprintUsage const* usage, uint64_t n_calls,
+    FILE* output
+);
+
+/// Leaves the series open, it is owned by the caller
+void footprint_free(Footprint* self);
+
+#endif  // !_SOTEST_FOOTPRINT_H
@@ -0,0 +1,186 @@
+#define _GNU_SOURCE
+
+#include "history.h"
+#include "stats.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+
+/// Turns a MAD into a standard deviation estimate for normal distributions
+double constexpr HISTORY_MAD_SCALE = 1.4826;
+size_t constexpr HISTORY_N_FIELDS = 10;
+
+void history_host_fingerprint(String* out) {
+    auto identity = STRING_EMPTY;
+    struct utsname name;
+
+    if (0 == uname(&name)) {
+        string_append(&identity, str_from_ptr(name.machine));
+        string_append(&identity, str_from_ptr(name.release));
+    }
+
+    auto cpuinfo = fopen("/proc/cpuinfo", "r");
+
+    if (nullptr != cpuinfo) {
+        auto line = STRING_EMPTY;
+
+        while (READLINE_EOF != string_readline(&line, cpuinfo)) {
+            if (str_starts_with(line.str, Str("model name"))) {
+                string_append(&identity, line.str);
+                break;
+            }
+
+            string_clear(&line);
+        }
+
+        string_free(&line);
+        fclose(cpuinfo);
+    }
+
+    char count[32];
+    snprintf(count, sizeof(count), "%ld", sysconf(_SC_NPROCESSORS_ONLN));
+    string_append(&identity, str_from_ptr(count));
+
+    char hash[17];
+    snprintf(
+        hash, sizeof(hash), "%016llx",
+        (unsigned long long) murmur_hash(identity.str.ptr, identity.str.len, 0)
+    );
+    string_append(out, str_from_ptr(hash));
+
+    string_free(&identity);
+}
+
+bool history_append(Str path, HistoryRecord const* record) {
+    auto path_copy = STRING_EMPTY;
+    string_append(&path_copy, path);
+
+    char* line = nullptr;
+    auto len = asprintf(
+        &line, "%lld\t%.*s\t%.*s\t%.*s\t%.*s\t%zu\t%.1f\t%.1f\t%.1f\t%.1f\n",
+        (long long) record->time, (int) record->function.len,
+        record->function.ptr, (int) record->library.len, record->library.ptr,
+        (int) record->build_id.len, record->build_id.ptr,
+        (int) record->host.len, record->host.ptr, record->n_samples,
+        record->summary.median, record->summary.p90, record->summary.p99,
+        record->summary.mean
+    );
+
+    if (len < 0) {
+        string_free(&path_copy);
+        return false;
+    }
+
+    // A single small `O_APPEND` write keeps lines whole when parallel CI jobs
+    // share the file
+    int fd = open(
+        path_copy.str.ptr, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644
+    );
+    string_free(&path_copy);
+
+    auto success = fd >= 0 && len == write(fd, line, (size_t) len);
+    auto error = errno;
+
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    free(line);
+    errno = error;
+
+    return success;
+}
+
+/// Splits a history line into its fields
+static bool history_split(Str line, Str fields[HISTORY_N_FIELDS]) {
+    size_t n_fields = 0;
+    size_t start = 0;
+
+    for (size_t i = 0; i <= line.len; ++i) {
+        if (i != line.len && '\t' != line.ptr[i]) {
+            continue;
+        }
+
+        if (n_fields == HISTORY_N_FIELDS) {
+            return false;
+        }
+
+        fields[n_fields++] = str_slice(line, start, i);
+        start = i + 1;
+    }
+
+    return HISTORY_N_FIELDS == n_fields;
+}
+
+HistoryBaseline history_baseline(
+    Str path, HistoryRecord const* record, double max_regression
+) {
+    auto path_copy = STRING_EMPTY;
+    string_append(&path_copy, path);
+
+    auto file = fopen(path_copy.str.ptr, "r");
+    string_free(&path_copy);
+
+    if (nullptr == file) {
+        return (HistoryBaseline) {};
+    }
+
+    // Ring of the latest matching medians
+    double medians[HISTORY_WINDOW];
+    size_t n_matching = 0;
+    auto line = STRING_EMPTY;
+
+    while (READLINE_EOF != string_readline(&line, file)) {
+        Str fields[HISTORY_N_FIELDS];
+
+        if (history_split(line.str, fields) &&
+            str_eq(fields[1], record->function) &&
+            str_eq(fields[2], record->library) &&
+            str_eq(fields[4], record->host))
+        {
+            auto median_copy = STRING_EMPTY;
+            string_append(&median_copy, fields[6]);
+
+            char* end = nullptr;
+            auto median = strtod(median_copy.str.ptr, &end);
+
+            if (end != median_copy.str.ptr && '\0' == *end && median >= 0.0) {
+                medians[n_matching % HISTORY_WINDOW] = median;
+                n_matching += 1;
+            }
+
+            string_free(&median_copy);
+        }
+
+        string_clear(&line);
+    }
+
+    string_free(&line);
+    fclose(file);
+
+    auto n_records = n_matching < HISTORY_WINDOW ? n_matching : HISTORY_WINDOW;
+
+    if (0 == n_records) {
+        return (HistoryBaseline) {};
+    }
+
+    stats_sort(medians, n_records);
+
+    auto baseline = (HistoryBaseline) {
+        .n_records = n_records,
+        .median = stats_median(medians, n_records),
+        .mad = HISTORY_MAD_SCALE * stats_mad(medians, n_records),
+    };
+
+    // Both a statistically and a practically significant slowdown is needed
+    baseline.threshold = fmax(
+        baseline.median + HISTORY_MAD_FACTOR * baseline.mad,
+        baseline.median * (1.0 + max_regression / 100.0)
+    );
+
+    return baseline;
+}
@@ -0,0 +1,64 @@
+#ifndef _SOTEST_HISTORY_H
+#define _SOTEST_HISTORY_H
+
+#include "str.h"
+#include "compare.h"
+
+#include <stdio.h>
+
+/// Number of latest matching records the baseline is computed from
+size_t constexpr HISTORY_WINDOW = 20;
+/// Fewer matching records are not enough for a baseline
+size_t constexpr HISTORY_MIN_RECORDS = 5;
+/// A regression must exceed the baseline median by this many (scaled) MADs
+double constexpr HISTORY_MAD_FACTOR = 3.0;
+
+/// One `bench` result, stored as a tab-separated line:
+/// `<time> <function> <library> <build-id> <host> <samples> <median> <p90>
+/// <p99> <mean>`
+typedef struct HistoryRecord {
+    /// Seconds since the epoch
+    int64_t time;
+    Str function;
+    Str library;
+    /// Hex build-id of the library, `-` if it has none
+    Str build_id;
+    Str host;
+    size_t n_samples;
+    CompareSummary summary;
+} HistoryRecord;
+
+/// Fingerprint of the hardware and kernel results are comparable on, as
+/// 16 hex digits. The host name is left out, so identical CI runners share
+/// their history.
+void history_host_fingerprint(String* out);
+
+/// Appends the record to the history file at `path`, creating it if needed
+///
+/// # Error
+///
+/// Returns `false` and sets `errno` if the file can not be written
+bool history_append(Str path, HistoryRecord const* record);
+
+typedef struct HistoryBaseline {
+    /// Number of records the baseline was computed from
+    size_t n_records;
+    /// Median of the records' medians
+    double median;
+    /// Scaled median absolute deviation of the records' medians
+    double mad;
+    /// Medians above this are regressions
+    double threshold;
+} HistoryBaseline;
+
+/// Computes the baseline of the latest records with the same function,
+/// library and host as `record`. Malformed lines are skipped.
+///
+/// # Return
+///
+/// `.n_records == 0` if the file does not exist or has no matching records
+HistoryBaseline history_baseline(
+    Str path, HistoryRecord const* record, double max_regression
+);
+
+#endif  // !_SOTEST_HISTORY_H
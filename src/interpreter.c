@@ -1,10 +1,29 @@
+#define _GNU_SOURCE
+
 #include "interpreter.h"
 #include "str.h"
+#include "probes.h"
 
 #include <dlfcn.h>
+#include <stdlib.h>
 
 typedef void* LibraryHandle;
 
+typedef struct AliasedLibrary {
+    /// Owned by the executor's arena
+    String path;
+    LibraryHandle handle;
+} AliasedLibrary;
+
+/// Value of the function caches, allocated in the executor's arena so that the
+/// stats stay in place when the cache grows
+typedef struct CachedFunction {
+    ExecutorFunction function;
+    CallStats stats;
+    /// `Monitor` slot of `function`, taken when it is cached
+    uint32_t slot;
+} CachedFunction;
+
 #define CMC_EXT_ITER
 
 #define K String
@@ -15,25 +34,83 @@ typedef void* LibraryHandle;
 #include <cmc/hashmap.h>
 
 #define K String
-#define V ExecutorFunction
+#define V AliasedLibrary
+#define SNAME AliasMap
+#define PFX alias_map
+
+#include <cmc/hashmap.h>
+
+#define K String
+#define V CachedFunction*
 #define SNAME FunctionMap
 #define PFX function_map
 
 #include <cmc/hashmap.h>
 
+#define K String
+#define V Procedure*
+#define SNAME ProcedureMap
+#define PFX procedure_map
+
+#include <cmc/hashmap.h>
+
+#define K String
+#define V JitCode
+#define SNAME StubMap
+#define PFX stub_map
+
+#include <cmc/hashmap.h>
+
 static int local_string_compare(String a, String b) {
     return string_compare(&a, &b);
 }
 
-static void local_string_free(String string) { string_free(&string); }
-
 static size_t local_string_hash(String string) { return string_hash(&string); }
 
 static void local_handle_free(LibraryHandle handle) { dlclose(handle); }
 
+static void local_aliased_library_free(AliasedLibrary library) {
+    // An isolated namespace has its own C library with its own `stdout`
+    // buffer, which is not flushed at exit of the process
+    auto flush = (int (*)(FILE*)) dlsym(library.handle, "fflush");
+
+    if (nullptr != flush) {
+        flush(nullptr);
+    }
+
+    dlclose(library.handle);
+}
+
+static void procedure_clear(Procedure* self) {
+    for (size_t i = 0; i < self->len; ++i) {
+        string_free(&self->calls[i].name);
+    }
+
+    self->len = 0;
+    self->n_functions = 0;
+    self->generation = 0;
+    jit_free(&self->jit);
+    self->result = (ExecutorResult) {.status = EXECUTOR_SUCCESS};
+    string_clear(&self->error);
+}
+
+static void local_procedure_free(Procedure* procedure) {
+    procedure_clear(procedure);
+    string_free(&procedure->error);
+    free(procedure->stats);
+    free(procedure->slots);
+    free(procedure->functions);
+    free(procedure->calls);
+    free(procedure);
+}
+
+static void local_stub_free(JitCode code) { jit_free(&code); }
+
+// Keys and cached functions are in the executor's arena, the maps leave them
+// to `arena_free`
+
 struct FunctionMap_fkey FUNCTION_MAP_FKEY = {
     .cmp = local_string_compare,
-    .free = local_string_free,
     .hash = local_string_hash,
 };
 
@@ -41,7 +118,6 @@ struct FunctionMap_fval FUNCTION_MAP_FVAL = {};
 
 struct LibraryMap_fkey LIBRARY_MAP_FKEY = {
     .cmp = local_string_compare,
-    .free = local_string_free,
     .hash = local_string_hash,
 };
 
@@ -49,35 +125,184 @@ struct LibraryMap_fval LIBRARY_MAP_FVAL = {
     .free = local_handle_free,
 };
 
-Executor executor_new() {
+struct AliasMap_fkey ALIAS_MAP_FKEY = {
+    .cmp = local_string_compare,
+    .hash = local_string_hash,
+};
+
+struct AliasMap_fval ALIAS_MAP_FVAL = {
+    .free = local_aliased_library_free,
+};
+
+struct ProcedureMap_fkey PROCEDURE_MAP_FKEY = {
+    .cmp = local_string_compare,
+    .hash = local_string_hash,
+};
+
+struct ProcedureMap_fval PROCEDURE_MAP_FVAL = {
+    .free = local_procedure_free,
+};
+
+struct StubMap_fkey STUB_MAP_FKEY = {
+    .cmp = local_string_compare,
+    .hash = local_string_hash,
+};
+
+struct StubMap_fval STUB_MAP_FVAL = {
+    .free = local_stub_free,
+};
+
+Executor executor_new() { return executor_with_options((ExecutorOptions) {}); }
+
+Executor executor_with_options(ExecutorOptions options) {
     return (Executor) {
+        .options = options,
         .functions =
             function_map_new(32, 0.5, &FUNCTION_MAP_FKEY, &FUNCTION_MAP_FVAL),
         .libraries =
             library_map_new(32, 0.5, &LIBRARY_MAP_FKEY, &LIBRARY_MAP_FVAL),
+        .aliases = alias_map_new(16, 0.5, &ALIAS_MAP_FKEY, &ALIAS_MAP_FVAL),
+        .qualified_functions =
+            function_map_new(32, 0.5, &FUNCTION_MAP_FKEY, &FUNCTION_MAP_FVAL),
+        .deferred = DEFERRED_LIBRARIES_EMPTY,
+        .procedures = procedure_map_new(
+            16, 0.5, &PROCEDURE_MAP_FKEY, &PROCEDURE_MAP_FVAL
+        ),
+        .generation = 1,
+        .stubs = stub_map_new(16, 0.5, &STUB_MAP_FKEY, &STUB_MAP_FVAL),
+        .clock = cycle_clock_start(),
+        .arena = ARENA_EMPTY,
     };
 }
 
-ExecutorResult executor_load_library(Executor* self, Str path) {
+Str executor_result_name(ExecutorResult self) {
+    switch (self.status) {
+    case EXECUTOR_SUCCESS:
+        return Str("EXECUTOR_SUCCESS");
+    case EXECUTOR_LOAD_FAILED:
+        return Str("EXECUTOR_LOAD_FAILED");
+    case EXECUTOR_LIBRARY_NOT_LOADED:
+        return Str("EXECUTOR_LIBRARY_NOT_LOADED");
+    case EXECUTOR_FIND_SYMBOL_FAILED:
+        return Str("EXECUTOR_FIND_SYMBOL_FAILED");
+    case EXECUTOR_ASSERTION_FAILED:
+        return Str("EXECUTOR_ASSERTION_FAILED");
+    case EXECUTOR_STUB_FAILED:
+        return Str("EXECUTOR_STUB_FAILED");
+    }
+
+    return Str("EXECUTOR_UNKNOWN");
+}
+
+/// Counts a library made available to calls in the live stats
+static void executor_count_library(Executor const* self) {
+    if (nullptr != self->options.monitor) {
+        monitor_add(&self->options.monitor->segment->n_libraries, 1);
+    }
+}
+
+/// Counts a lookup of the function caches in the live stats
+static void executor_count_lookup(Executor const* self, bool is_hit) {
+    auto monitor = self->options.monitor;
+
+    if (nullptr == monitor) {
+        return;
+    }
+
+    monitor_add(
+        is_hit ? &monitor->segment->n_cache_hits
+               : &monitor->segment->n_cache_misses,
+        1
+    );
+}
+
+static void deferred_libraries_add(
+    DeferredLibraries* self, DeferredLibrary library
+) {
+    if (0 == self->cap) {
+        self->cap = 8;
+        self->ptr = malloc(sizeof(*self->ptr) * self->cap);
+    } else if (self->len == self->cap) {
+        self->cap += self->cap / 2;
+        self->ptr = realloc(self->ptr, sizeof(*self->ptr) * self->cap);
+    }
+
+    self->ptr[self->len] = library;
+    self->len += 1;
+}
+
+static void deferred_libraries_free(DeferredLibraries* self) {
+    for (size_t i = 0; i < self->len; ++i) {
+        auto library = &self->ptr[i];
+
+        if (nullptr != library->handle) {
+            dlclose(library->handle);
+        }
+
+        elf_image_free(&library->image);
+    }
+
+    free(self->ptr);
+    *self = DEFERRED_LIBRARIES_EMPTY;
+}
+
+static ExecutorResult executor_defer_library(Executor* self, Str path) {
+    for (size_t i = 0; i < self->deferred.len; ++i) {
+        if (str_eq(self->deferred.ptr[i].path.str, path)) {
+            return (ExecutorResult) {
+                .status = EXECUTOR_SUCCESS,
+            };
+        }
+    }
+
+    auto image_result = elf_image_open(path);
+
+    if (ELF_SUCCESS != image_result.status) {
+        return (ExecutorResult) {
+            .dl_error = image_result.error,
+            .status = EXECUTOR_LOAD_FAILED,
+        };
+    }
+
+    auto library = (DeferredLibrary) {
+        .path = arena_copy_string(&self->arena, path),
+        .image = image_result.value,
+        .handle = nullptr,
+    };
+
+    deferred_libraries_add(&self->deferred, library);
+    self->generation += 1;
+    executor_count_library(self);
+
+    return (ExecutorResult) {
+        .status = EXECUTOR_SUCCESS,
+    };
+}
+
+static ExecutorResult executor_open_library(Executor* self, Str path) {
     if (0 == path.len) {
         return (ExecutorResult) {
             .status = EXECUTOR_LOAD_FAILED,
         };
     }
 
+    if (self->options.is_lazy) {
+        return executor_defer_library(self, path);
+    }
+
     if (library_map_contains(self->libraries, (String) {.str = path})) {
         return (ExecutorResult) {
             .status = EXECUTOR_SUCCESS,
         };
     }
 
-    auto path_copy = STRING_EMPTY;
-    string_append(&path_copy, path);
+    auto mark = arena_mark(&self->arena);
+    auto path_copy = arena_copy_string(&self->arena, path);
 
     auto handle = dlopen(path_copy.str.ptr, RTLD_LAZY);
 
     if (nullptr == handle) {
-        string_free(&path_copy);
+        arena_rewind(&self->arena, mark);
 
         return (ExecutorResult) {
             .dl_error = str_from_ptr(dlerror()),
@@ -86,28 +311,400 @@ ExecutorResult executor_load_library(Executor* self, Str path) {
     }
 
     library_map_insert(self->libraries, path_copy, handle);
+    self->generation += 1;
+    executor_count_library(self);
 
     return (ExecutorResult) {
         .status = EXECUTOR_SUCCESS,
     };
 }
 
-ExecutorResult executor_call_function(Executor* self, Str function_name) {
-    auto function =
-        function_map_get(self->functions, (String) {.str = function_name});
+/// Samples the memory before a library load if it is measured
+static void executor_load_begin(
+    Executor const* self, Str path, FootprintSample* before
+) {
+    PROBE2(library_load_start, path.ptr, path.len);
 
-    if (nullptr != function) {
-        function();
+    if (nullptr != self->options.footprint) {
+        footprint_sample(before);
+    }
+}
+
+/// Attributes the memory growth of a library load to the library
+static void executor_load_end(
+    Executor* self, Str path, ExecutorResult result, uint64_t start_ns,
+    FootprintSample const* before
+) {
+    if (PROBE_IS_ENABLED(library_load_end)) {
+        PROBE4(
+            library_load_end, path.ptr, path.len, result.status,
+            probe_now_ns() - start_ns
+        );
+    }
+
+    if (nullptr != self->options.footprint &&
+        EXECUTOR_SUCCESS == result.status)
+    {
+        footprint_add_library(self->options.footprint, path, before);
+    }
+}
+
+ExecutorResult executor_load_library(Executor* self, Str path) {
+    FootprintSample before;
+    executor_load_begin(self, path, &before);
+    auto start_ns = PROBE_IS_ENABLED(library_load_end) ? probe_now_ns() : 0;
 
+    auto result = executor_open_library(self, path);
+    executor_load_end(self, path, result, start_ns, &before);
+
+    return result;
+}
+
+static ExecutorResult executor_open_library_as(
+    Executor* self, Str path, Str alias, bool is_isolated
+) {
+    if (0 == path.len || 0 == alias.len) {
         return (ExecutorResult) {
-            .status = EXECUTOR_SUCCESS,
+            .status = EXECUTOR_LOAD_FAILED,
+        };
+    }
+
+    auto existing = alias_map_get_ref(self->aliases, (String) {.str = alias});
+
+    if (nullptr != existing) {
+        if (str_eq(existing->path.str, path)) {
+            return (ExecutorResult) {
+                .status = EXECUTOR_SUCCESS,
+            };
+        }
+
+        return (ExecutorResult) {
+            .dl_error = Str("alias is already taken by another library"),
+            .status = EXECUTOR_LOAD_FAILED,
         };
     }
 
-    auto name_copy = STRING_EMPTY;
-    string_append(&name_copy, function_name);
+    auto mark = arena_mark(&self->arena);
+    auto library = (AliasedLibrary) {
+        .path = arena_copy_string(&self->arena, path),
+    };
+
+    if (is_isolated) {
+        library.handle =
+            dlmopen(LM_ID_NEWLM, library.path.str.ptr, RTLD_LAZY | RTLD_LOCAL);
+    } else {
+        library.handle = dlopen(library.path.str.ptr, RTLD_LAZY | RTLD_LOCAL);
+    }
+
+    if (nullptr == library.handle) {
+        arena_rewind(&self->arena, mark);
+
+        return (ExecutorResult) {
+            .dl_error = str_from_ptr(dlerror()),
+            .status = EXECUTOR_LOAD_FAILED,
+        };
+    }
+
+    auto alias_copy = arena_copy_string(&self->arena, alias);
+    alias_map_insert(self->aliases, alias_copy, library);
+    self->generation += 1;
+    executor_count_library(self);
+
+    return (ExecutorResult) {
+        .status = EXECUTOR_SUCCESS,
+    };
+}
+
+static ExecutorResolveResult executor_resolve_error(
+    uint8_t status, Str dl_error
+) {
+    return (ExecutorResolveResult) {
+        .result =
+            (ExecutorResult) {
+                .dl_error = dl_error,
+                .status = status,
+            },
+    };
+}
+
+static ExecutorResolveResult executor_resolved(CachedFunction* cached) {
+    return (ExecutorResolveResult) {
+        .result = (ExecutorResult) {.status = EXECUTOR_SUCCESS},
+        .function = cached->function,
+        .stats = &cached->stats,
+        .slot = cached->slot,
+    };
+}
+
+/// Adds a resolved function to a cache, taking the name copied into the arena.
+/// Its live stats slot is looked up once here, calls only count in it.
+static CachedFunction* executor_cache_function(
+    Executor* self, struct FunctionMap* cache, String name,
+    ExecutorFunction function
+) {
+    auto monitor = self->options.monitor;
+    auto cached =
+        (CachedFunction*) arena_alloc(&self->arena, sizeof(CachedFunction));
+    *cached = (CachedFunction) {
+        .function = function,
+        .slot = nullptr == monitor ? MONITOR_NO_SLOT
+                                   : monitor_slot(monitor, name.str),
+    };
+    cached->stats.memory.name = name.str;
+    function_map_insert(cache, name, cached);
+
+    return cached;
+}
+
+ExecutorResult executor_load_library_as(
+    Executor* self, Str path, Str alias, bool is_isolated
+) {
+    FootprintSample before;
+    executor_load_begin(self, path, &before);
+    auto start_ns = PROBE_IS_ENABLED(library_load_end) ? probe_now_ns() : 0;
+
+    auto result = executor_open_library_as(self, path, alias, is_isolated);
+    executor_load_end(self, path, result, start_ns, &before);
+
+    return result;
+}
+
+/// Calls the function, timing it and measuring its memory growth if their
+/// turn has come
+static void executor_call_sampled(
+    Executor* self, ExecutorFunction function, CallStats* stats
+) {
+    FootprintSample before;
+    auto footprint = self->options.footprint;
+    auto is_measured = footprint_begin(footprint, stats->n_calls, &before);
+
+    if (!call_stats_is_sampled(stats)) {
+        function();
+        stats->n_calls += 1;
+    } else {
+        auto start_cycles = cycles_now();
+        function();
+        call_stats_add(stats, cycles_now() - start_cycles);
+    }
+
+    if (is_measured) {
+        footprint_add_calls(footprint, &stats->memory, 1, &before);
+    }
+}
+
+/// Fires the entry probe of a call
+///
+/// # Return
+///
+/// Start time of the call if it is timed, 0 otherwise
+static uint64_t executor_call_begin(Executor const* self, Str name) {
+    PROBE2(call_entry, name.ptr, name.len);
+
+    auto is_timed =
+        nullptr != self->options.monitor || PROBE_IS_ENABLED(call_exit);
+
+    return is_timed ? monitor_now_ns() : 0;
+}
+
+/// Fires the exit probe of a call and counts it in the live stats
+static void executor_call_end(
+    Executor* self, Str name, uint32_t slot, uint64_t start_ns
+) {
+    auto monitor = self->options.monitor;
+
+    if (nullptr == monitor && !PROBE_IS_ENABLED(call_exit)) {
+        return;
+    }
+
+    auto duration_ns = 0 == start_ns ? 0 : monitor_now_ns() - start_ns;
+
+    if (PROBE_IS_ENABLED(call_exit)) {
+        PROBE3(call_exit, name.ptr, name.len, duration_ns);
+    }
+
+    if (nullptr != monitor) {
+        monitor_count_calls(monitor, slot, 1, duration_ns);
+    }
+}
+
+ExecutorResolveResult executor_resolve_qualified_function(
+    Executor* self, Str qualified_name
+) {
+    auto cached = function_map_get(
+        self->qualified_functions, (String) {.str = qualified_name}
+    );
+
+    executor_count_lookup(self, nullptr != cached);
 
-    auto result = (ExecutorResult) {};
+    if (nullptr != cached) {
+        PROBE2(symbol_cache_hit, qualified_name.ptr, qualified_name.len);
+        return executor_resolved(cached);
+    }
+
+    PROBE2(symbol_cache_miss, qualified_name.ptr, qualified_name.len);
+
+    size_t dot = 0;
+
+    while (dot < qualified_name.len && '.' != qualified_name.ptr[dot]) {
+        dot += 1;
+    }
+
+    auto alias = str_slice(qualified_name, 0, dot);
+    auto library = alias_map_get_ref(self->aliases, (String) {.str = alias});
+
+    if (nullptr == library) {
+        return executor_resolve_error(
+            EXECUTOR_LIBRARY_NOT_LOADED,
+            Str("no library loaded with this alias")
+        );
+    }
+
+    auto mark = arena_mark(&self->arena);
+    auto name_copy = arena_copy_string(&self->arena, qualified_name);
+
+    // The name copy is nul-terminated, so is its function name suffix
+    auto function = (ExecutorFunction) dlsym(
+        library->handle, name_copy.str.ptr + dot + 1
+    );
+
+    if (nullptr == function) {
+        arena_rewind(&self->arena, mark);
+
+        return executor_resolve_error(
+            EXECUTOR_FIND_SYMBOL_FAILED, str_from_ptr(dlerror())
+        );
+    }
+
+    return executor_resolved(executor_cache_function(
+        self, self->qualified_functions, name_copy, function
+    ));
+}
+
+ExecutorResult executor_call_qualified_function(
+    Executor* self, Str qualified_name
+) {
+    auto resolved = executor_resolve_qualified_function(self, qualified_name);
+
+    if (EXECUTOR_SUCCESS != resolved.result.status) {
+        return resolved.result;
+    }
+
+    auto start_ns = executor_call_begin(self, qualified_name);
+    executor_call_sampled(self, resolved.function, resolved.stats);
+    executor_call_end(self, qualified_name, resolved.slot, start_ns);
+
+    return resolved.result;
+}
+
+ExecutorResolveResult executor_resolve_from(
+    Executor* self, Str path, Str function_name
+) {
+    // Paths are never valid aliases, so they can not clash with the user's
+    auto load_result = executor_load_library_as(self, path, path, false);
+
+    if (EXECUTOR_SUCCESS != load_result.status) {
+        return (ExecutorResolveResult) {
+            .result = load_result,
+        };
+    }
+
+    auto library = alias_map_get_ref(self->aliases, (String) {.str = path});
+
+    // Only needed for the nul terminator, it is not cached
+    auto mark = arena_mark(&self->arena);
+    auto name_copy = arena_copy(&self->arena, function_name);
+
+    auto function = (ExecutorFunction) dlsym(library->handle, name_copy.ptr);
+    arena_rewind(&self->arena, mark);
+
+    if (nullptr == function) {
+        return executor_resolve_error(
+            EXECUTOR_FIND_SYMBOL_FAILED, str_from_ptr(dlerror())
+        );
+    }
+
+    return (ExecutorResolveResult) {
+        .result = (ExecutorResult) {.status = EXECUTOR_SUCCESS},
+        .function = function,
+        .slot = MONITOR_NO_SLOT,
+    };
+}
+
+/// Finds the first library in `use` order exporting the function and opens it
+/// if it was not opened yet
+static ExecutorResolveResult executor_resolve_deferred(
+    Executor* self, Str function_name
+) {
+    if (0 == self->deferred.len) {
+        return executor_resolve_error(
+            EXECUTOR_LIBRARY_NOT_LOADED, Str("no library loaded")
+        );
+    }
+
+    for (size_t i = 0; i < self->deferred.len; ++i) {
+        auto library = &self->deferred.ptr[i];
+
+        if (!elf_image_exports(&library->image, function_name)) {
+            continue;
+        }
+
+        if (nullptr == library->handle) {
+            library->handle = dlopen(library->path.str.ptr, RTLD_LAZY);
+
+            if (nullptr == library->handle) {
+                return executor_resolve_error(
+                    EXECUTOR_LOAD_FAILED, str_from_ptr(dlerror())
+                );
+            }
+        }
+
+        auto mark = arena_mark(&self->arena);
+        auto name_copy = arena_copy_string(&self->arena, function_name);
+
+        auto function =
+            (ExecutorFunction) dlsym(library->handle, name_copy.str.ptr);
+
+        if (nullptr == function) {
+            arena_rewind(&self->arena, mark);
+
+            return executor_resolve_error(
+                EXECUTOR_FIND_SYMBOL_FAILED, str_from_ptr(dlerror())
+            );
+        }
+
+        return executor_resolved(executor_cache_function(
+            self, self->functions, name_copy, function
+        ));
+    }
+
+    return executor_resolve_error(
+        EXECUTOR_FIND_SYMBOL_FAILED, Str("no loaded library exports the symbol")
+    );
+}
+
+ExecutorResolveResult executor_resolve_function(
+    Executor* self, Str function_name
+) {
+    auto cached =
+        function_map_get(self->functions, (String) {.str = function_name});
+
+    executor_count_lookup(self, nullptr != cached);
+
+    if (nullptr != cached) {
+        PROBE2(symbol_cache_hit, function_name.ptr, function_name.len);
+        return executor_resolved(cached);
+    }
+
+    PROBE2(symbol_cache_miss, function_name.ptr, function_name.len);
+
+    if (self->options.is_lazy) {
+        return executor_resolve_deferred(self, function_name);
+    }
+
+    auto mark = arena_mark(&self->arena);
+    auto name_copy = arena_copy_string(&self->arena, function_name);
+
+    auto result = (ExecutorResolveResult) {};
 
     for (auto it = library_map_iter_start(self->libraries);
          !library_map_iter_at_end(&it); library_map_iter_next(&it))
@@ -116,30 +713,413 @@ ExecutorResult executor_call_function(Executor* self, Str function_name) {
         auto function = (ExecutorFunction) dlsym(handle, name_copy.str.ptr);
 
         if (nullptr == function) {
-            result.dl_error = str_from_ptr(dlerror());
-            result.status = EXECUTOR_FIND_SYMBOL_FAILED;
+            result = executor_resolve_error(
+                EXECUTOR_FIND_SYMBOL_FAILED, str_from_ptr(dlerror())
+            );
             continue;
         }
 
-        function();
-        function_map_insert(self->functions, name_copy, function);
+        return executor_resolved(executor_cache_function(
+            self, self->functions, name_copy, function
+        ));
+    }
+
+    arena_rewind(&self->arena, mark);
+
+    if (0 == library_map_count(self->libraries)) {
+        result = executor_resolve_error(
+            EXECUTOR_LIBRARY_NOT_LOADED, Str("no library loaded")
+        );
+    }
+
+    return result;
+}
+
+ExecutorResult executor_call_function(Executor* self, Str function_name) {
+    auto resolved = executor_resolve_function(self, function_name);
+
+    if (EXECUTOR_SUCCESS != resolved.result.status) {
+        return resolved.result;
+    }
+
+    auto start_ns = executor_call_begin(self, function_name);
+    executor_call_sampled(self, resolved.function, resolved.stats);
+    executor_call_end(self, function_name, resolved.slot, start_ns);
+
+    return resolved.result;
+}
+
+JitStub executor_resolve_stub(Executor* self, JitSignature const* signature) {
+    if (self->options.is_jit_disabled) {
+        return nullptr;
+    }
+
+    // One byte per type, the result last
+    char key[JIT_MAX_ARGUMENTS + 1];
 
+    for (size_t i = 0; i < signature->n_arguments; ++i) {
+        key[i] = (char) signature->arguments[i];
+    }
+
+    key[signature->n_arguments] = (char) signature->result;
+
+    auto key_str = (Str) {.ptr = key, .len = signature->n_arguments + 1};
+    auto code = stub_map_get_ref(self->stubs, (String) {.str = key_str});
+
+    if (nullptr != code) {
+        return (JitStub) code->entry;
+    }
+
+    auto stub = jit_compile_stub(signature);
+
+    if (nullptr == stub.entry) {
+        return nullptr;
+    }
+
+    auto key_copy = arena_copy_string(&self->arena, key_str);
+    stub_map_insert(self->stubs, key_copy, stub);
+
+    return (JitStub) stub.entry;
+}
+
+ExecutorResult executor_call_typed(
+    Executor* self, Str name, ExecutorResolveResult const* resolved,
+    TypedCall const* call, JitValue* result
+) {
+    auto stub = executor_resolve_stub(self, &call->signature);
+
+    if (nullptr == stub) {
         return (ExecutorResult) {
-            .status = EXECUTOR_SUCCESS,
+            .dl_error =
+                self->options.is_jit_disabled
+                    ? Str("typed calls need the JIT, which is disabled")
+                    : Str("can not compile a call stub for this signature"),
+            .status = EXECUTOR_STUB_FAILED,
         };
     }
 
-    string_free(&name_copy);
+    // Typed calls are rare enough to time each, `stats` is unset for
+    // functions from `executor_resolve_from`
+    auto stats = resolved->stats;
+    FootprintSample before;
+    auto is_measured =
+        nullptr != stats &&
+        footprint_begin(self->options.footprint, stats->n_calls, &before);
 
-    if (0 == library_map_count(self->libraries)) {
-        result.status = EXECUTOR_LIBRARY_NOT_LOADED;
-        result.dl_error = Str("no library loaded");
+    auto start_ns = executor_call_begin(self, name);
+    auto start_cycles = cycles_now();
+    stub(resolved->function, call->arguments, result);
+    auto cycles = cycles_now() - start_cycles;
+    executor_call_end(self, name, resolved->slot, start_ns);
+
+    if (nullptr != stats) {
+        call_stats_add(stats, cycles);
+    }
+
+    if (is_measured) {
+        footprint_add_calls(
+            self->options.footprint, &stats->memory, 1, &before
+        );
+    }
+
+    *result = typed_value_normalize(*result, call->signature.result);
+
+    return (ExecutorResult) {.status = EXECUTOR_SUCCESS};
+}
+
+Procedure* executor_define_procedure(Executor* self, Str name) {
+    auto procedure =
+        procedure_map_get(self->procedures, (String) {.str = name});
+
+    if (nullptr != procedure) {
+        procedure_clear(procedure);
+        return procedure;
+    }
+
+    procedure = calloc(1, sizeof(*procedure));
+
+    auto name_copy = arena_copy_string(&self->arena, name);
+    procedure_map_insert(self->procedures, name_copy, procedure);
+
+    return procedure;
+}
+
+void procedure_add_call(Procedure* self, Str name, bool is_qualified) {
+    // Every call may resolve, so `functions` grows along
+    if (0 == self->cap) {
+        self->cap = 8;
+        self->calls = malloc(sizeof(*self->calls) * self->cap);
+        self->functions = malloc(sizeof(*self->functions) * self->cap);
+        self->slots = malloc(sizeof(*self->slots) * self->cap);
+        self->stats = malloc(sizeof(*self->stats) * self->cap);
+    } else if (self->len == self->cap) {
+        self->cap += self->cap / 2;
+        self->calls = realloc(self->calls, sizeof(*self->calls) * self->cap);
+        self->functions =
+            realloc(self->functions, sizeof(*self->functions) * self->cap);
+        self->slots = realloc(self->slots, sizeof(*self->slots) * self->cap);
+        self->stats = realloc(self->stats, sizeof(*self->stats) * self->cap);
+    }
+
+    auto call = (ProcedureCall) {
+        .name = STRING_EMPTY,
+        .is_qualified = is_qualified,
+    };
+
+    string_append(&call.name, name);
+    self->calls[self->len] = call;
+    self->len += 1;
+
+    // The functions are resolved again on the next run
+    self->generation = 0;
+}
+
+Procedure* executor_find_procedure(Executor* self, Str name) {
+    return procedure_map_get(self->procedures, (String) {.str = name});
+}
+
+ExecutorResult executor_resolve_procedure(
+    Executor* self, Procedure* procedure
+) {
+    if (self->generation == procedure->generation) {
+        return procedure->result;
+    }
+
+    procedure->n_functions = 0;
+    procedure->generation = self->generation;
+    jit_free(&procedure->jit);
+    procedure->result = (ExecutorResult) {.status = EXECUTOR_SUCCESS};
+    string_clear(&procedure->error);
+
+    for (size_t i = 0; i < procedure->len; ++i) {
+        auto call = &procedure->calls[i];
+        auto resolved =
+            call->is_qualified
+                ? executor_resolve_qualified_function(self, call->name.str)
+                : executor_resolve_function(self, call->name.str);
+
+        if (EXECUTOR_SUCCESS == resolved.result.status) {
+            auto index = procedure->n_functions;
+            procedure->functions[index] = resolved.function;
+            procedure->stats[index] = resolved.stats;
+            procedure->n_functions += 1;
+
+            procedure->slots[index] = resolved.slot;
+
+            continue;
+        }
+
+        if (EXECUTOR_SUCCESS != procedure->result.status) {
+            continue;
+        }
+
+        // `dlerror` messages do not outlive the next `dl*` call
+        string_append(&procedure->error, call->name.str);
+        string_append(&procedure->error, Str(": "));
+        string_append(&procedure->error, resolved.result.dl_error);
+
+        procedure->result = (ExecutorResult) {
+            .status = resolved.result.status,
+            .dl_error = procedure->error.str,
+        };
+    }
+
+    // Monitored calls are timed one by one, measured ones sampled, a thunk
+    // would not be used
+    if (!self->options.is_jit_disabled && nullptr == self->options.monitor &&
+        nullptr == self->options.footprint)
+    {
+        procedure->jit =
+            jit_compile(procedure->functions, procedure->n_functions, 1);
+    }
+
+    return procedure->result;
+}
+
+void procedure_call_instrumented(
+    Procedure const* self, Monitor* monitor, Footprint* footprint
+) {
+    for (size_t i = 0; i < self->n_functions; ++i) {
+        auto stats = self->stats[i];
+        FootprintSample before;
+        auto is_measured = footprint_begin(footprint, stats->n_calls, &before);
+        auto start_ns = nullptr == monitor ? 0 : monitor_now_ns();
+
+        self->functions[i]();
+
+        if (nullptr != monitor) {
+            monitor_count_calls(
+                monitor, self->slots[i], 1, monitor_now_ns() - start_ns
+            );
+        }
+
+        stats->n_calls += 1;
+
+        if (is_measured) {
+            footprint_add_calls(footprint, &stats->memory, 1, &before);
+        }
+    }
+}
+
+ExecutorResult executor_run_procedure(Executor* self, Str name) {
+    auto procedure = executor_find_procedure(self, name);
+
+    if (nullptr == procedure) {
+        return (ExecutorResult) {
+            .dl_error = Str("no procedure defined with this name"),
+            .status = EXECUTOR_FIND_SYMBOL_FAILED,
+        };
+    }
+
+    auto result = executor_resolve_procedure(self, procedure);
+
+    if (nullptr != self->options.monitor ||
+        nullptr != self->options.footprint)
+    {
+        procedure_call_instrumented(
+            procedure, self->options.monitor, self->options.footprint
+        );
+    } else {
+        procedure_call(procedure);
     }
 
     return result;
 }
 
+/// Row of the call stats table
+typedef struct CallStatsRow {
+    Str name;
+    CallStats const* stats;
+    /// Mean of the timed calls times all calls
+    double total_cycles;
+} CallStatsRow;
+
+static int compare_call_stats_rows(void const* a, void const* b) {
+    auto x = ((CallStatsRow const*) a)->total_cycles;
+    auto y = ((CallStatsRow const*) b)->total_cycles;
+
+    return (x < y) - (x > y);
+}
+
+static size_t call_stats_rows_collect(
+    struct FunctionMap* cache, CallStatsRow* rows
+) {
+    size_t len = 0;
+
+    for (auto it = function_map_iter_start(cache);
+         !function_map_iter_at_end(&it); function_map_iter_next(&it))
+    {
+        auto stats = &function_map_iter_value(&it)->stats;
+
+        rows[len] = (CallStatsRow) {
+            .name = function_map_iter_key(&it).str,
+            .stats = stats,
+            .total_cycles =
+                0 == stats->n_timed ? 0.0
+                                    : (double) stats->total_cycles /
+                                          (double) stats->n_timed *
+                                          (double) stats->n_calls,
+        };
+        len += 1;
+    }
+
+    return len;
+}
+
+void executor_write_call_stats(Executor* self, FILE* output) {
+    auto n_cached = function_map_count(self->functions) +
+                    function_map_count(self->qualified_functions);
+    auto rows = (CallStatsRow*) malloc(sizeof(CallStatsRow) * (n_cached + 1));
+    size_t len = call_stats_rows_collect(self->functions, rows);
+    len += call_stats_rows_collect(self->qualified_functions, rows + len);
+
+    qsort(rows, len, sizeof(*rows), compare_call_stats_rows);
+
+    auto rate = cycle_clock_rate(&self->clock);
+
+    fprintf(
+        output, "call stats: %zu functions, %.3f cycles/ns\n", len, rate
+    );
+    fprintf(
+        output, "  %-32s %12s %12s %12s %10s %10s\n", "function", "calls",
+        "timed", "total ms", "mean ns", "max ns"
+    );
+
+    for (size_t i = 0; i < len; ++i) {
+        auto stats = rows[i].stats;
+        auto mean_ns =
+            0 == stats->n_timed ? 0.0
+                                : (double) stats->total_cycles / rate /
+                                      (double) stats->n_timed;
+
+        // Calls timed only as part of a loop have no maximum
+        char max_ns[32] = "-";
+
+        if (0 != stats->max_cycles) {
+            snprintf(
+                max_ns, sizeof(max_ns), "%.1f",
+                (double) stats->max_cycles / rate
+            );
+        }
+
+        fprintf(
+            output, "  %-32.*s %12llu %12llu %12.3f %10.1f %10s\n",
+            (int) rows[i].name.len, rows[i].name.ptr,
+            (unsigned long long) stats->n_calls,
+            (unsigned long long) stats->n_timed,
+            rows[i].total_cycles / rate / 1e6, mean_ns, max_ns
+        );
+    }
+
+    free(rows);
+}
+
+static int compare_memory_rows(void const* a, void const* b) {
+    auto x = ((CallStatsRow const*) a)->stats->memory;
+    auto y = ((CallStatsRow const*) b)->stats->memory;
+    auto x_heap = x.first.heap + x.growth.heap;
+    auto y_heap = y.first.heap + y.growth.heap;
+
+    return (x_heap < y_heap) - (x_heap > y_heap);
+}
+
+void executor_write_memory_report(Executor* self, FILE* output) {
+    auto footprint = self->options.footprint;
+
+    if (nullptr == footprint) {
+        return;
+    }
+
+    auto n_cached = function_map_count(self->functions) +
+                    function_map_count(self->qualified_functions);
+    auto rows = (CallStatsRow*) malloc(sizeof(CallStatsRow) * (n_cached + 1));
+    size_t len = call_stats_rows_collect(self->functions, rows);
+    len += call_stats_rows_collect(self->qualified_functions, rows + len);
+
+    qsort(rows, len, sizeof(*rows), compare_memory_rows);
+
+    footprint_write_header(footprint, output);
+
+    for (size_t i = 0; i < len; ++i) {
+        auto stats = rows[i].stats;
+
+        if (0 != stats->memory.n_samples) {
+            footprint_write_usage(
+                footprint, &stats->memory, stats->n_calls, output
+            );
+        }
+    }
+
+    free(rows);
+}
+
 void executor_free(Executor* self) {
+    stub_map_free(self->stubs);
+    procedure_map_free(self->procedures);
+    function_map_free(self->qualified_functions);
+    alias_map_free(self->aliases);
     library_map_free(self->libraries);
     function_map_free(self->functions);
+    deferred_libraries_free(&self->deferred);
+    arena_free(&self->arena);
 }
@@ -2,17 +2,57 @@
 #define _SOTEST_INTERPRETER_H
 
 #include "str.h"
+#include "arena.h"
+#include "cycles.h"
+#include "elf_image.h"
+#include "footprint.h"
+#include "jit.h"
+#include "monitor.h"
+#include "typed.h"
 
 #include <stdint.h>
+#include <stdio.h>
 
 typedef enum CommandType : uint8_t {
     COMMAND_TYPE_USE = 0,
     COMMAND_TYPE_CALL,
+    COMMAND_TYPE_COMPARE,
+    COMMAND_TYPE_BENCH,
+    COMMAND_TYPE_EXPECT,
+    COMMAND_TYPE_REPEAT,
+    /// `}` closing a `repeat` or `def` block
+    COMMAND_TYPE_END,
+    COMMAND_TYPE_DEF,
+    COMMAND_TYPE_RUN,
 } CommandType;
 
 typedef struct Command {
+    /// Library path for `use`, possibly qualified function name for `call`
+    /// and `bench`, function name for `compare`, hex hash for `expect`,
+    /// decimal count for `repeat`, procedure name for `def` and `run`
     Str content;
+    /// Alias from `use <path> as <alias>` or `use <path> in <alias>`, the
+    /// qualifier of `call <alias>.<function_name>` or `bench`. Empty if not
+    /// present
+    Str alias;
     CommandType type;
+    /// Set by `use <path> in <alias>`, loads into a separate link-map
+    /// namespace
+    bool is_isolated;
+    /// Available only if `type == COMMAND_TYPE_COMPARE`
+    Str baseline_path;
+    /// Available only if `type == COMMAND_TYPE_COMPARE`
+    Str candidate_path;
+    /// Available only if `type == COMMAND_TYPE_REPEAT`
+    size_t count;
+    /// The repeated command of `repeat <count> <command>`, empty for a block
+    /// `repeat <count> {` whose commands follow on the next lines up to `}`.
+    /// Available only if `type == COMMAND_TYPE_REPEAT`
+    Str body;
+    /// `(<type> <value>, ...) -> <type> = <value>` of a typed call, see
+    /// `parse_typed_call`. Empty for a plain call. Available only if `type ==
+    /// COMMAND_TYPE_CALL`
+    Str signature;
 } Command;
 
 typedef struct CommandParseResult {
@@ -40,14 +80,88 @@ typedef struct CommandLineParseResult {
 
 CommandLineParseResult command_line_parse(Str source);
 
-typedef struct Executor {
-    struct FunctionMap* functions;
-    struct LibraryMap* libraries;
-} Executor;
+typedef struct ExecutorOptions {
+    /// Defer `dlopen` of each `use`d library until a called function is
+    /// found in its exported symbols
+    bool is_lazy;
+    /// Call resolved procedures and repeated calls in a loop instead of
+    /// through compiled thunks, see `jit_compile`
+    bool is_jit_disabled;
+    /// Live counters of lookups, loads and calls, `nullptr` if not kept.
+    /// Repeated calls are timed instead of run through compiled thunks.
+    Monitor* monitor;
+    /// Memory growth of library loads and sampled calls, `nullptr` if not
+    /// measured. Repeated calls are sampled instead of run through compiled
+    /// thunks.
+    Footprint* footprint;
+} ExecutorOptions;
+
+/// Library recorded by `use` in lazy mode
+typedef struct DeferredLibrary {
+    /// Owned by the executor's arena
+    String path;
+    ElfImage image;
+    /// `nullptr` until a call resolves to this library
+    void* handle;
+} DeferredLibrary;
+
+/// Deferred libraries in `use` order, which is their lookup precedence
+typedef struct DeferredLibraries {
+    DeferredLibrary* ptr;
+    size_t len;
+    size_t cap;
+} DeferredLibraries;
+
+DeferredLibraries constexpr DEFERRED_LIBRARIES_EMPTY = {
+    .ptr = nullptr, .len = 0, .cap = 0
+};
 
 typedef void (*ExecutorFunction)();
 
-Executor executor_new();
+/// One in this many calls of a function made on their own is timed, the
+/// first one included. Reading the counter twice costs more than a call
+/// through the cache otherwise, sampling keeps the stats always on.
+uint64_t constexpr CALL_STATS_PERIOD = 8;
+
+/// Calls of a cached function, always counted. Time is in `cycles_now` ticks.
+typedef struct CallStats {
+    uint64_t n_calls;
+    /// Calls timed, on their own (see `CALL_STATS_PERIOD`) or in a loop
+    /// repeating only this function. Calls from compiled thunks, procedures
+    /// and mixed loops are counted but not timed.
+    uint64_t n_timed;
+    uint64_t total_cycles;
+    /// Longest call timed on its own
+    uint64_t max_cycles;
+    /// Memory growth of the sampled calls, named by the cache key. Kept only
+    /// if the executor has a `Footprint`.
+    FootprintUsage memory;
+} CallStats;
+
+/// The next call on its own is to be timed
+inline static bool call_stats_is_sampled(CallStats const* self) {
+    return 0 == self->n_calls % CALL_STATS_PERIOD;
+}
+
+/// Counts a call timed on its own
+inline static void call_stats_add(CallStats* self, uint64_t cycles) {
+    self->n_calls += 1;
+    self->n_timed += 1;
+    self->total_cycles += cycles;
+
+    if (cycles > self->max_cycles) {
+        self->max_cycles = cycles;
+    }
+}
+
+/// Counts calls which took `cycles` together
+inline static void call_stats_add_loop(
+    CallStats* self, uint64_t n_calls, uint64_t cycles
+) {
+    self->n_calls += n_calls;
+    self->n_timed += n_calls;
+    self->total_cycles += cycles;
+}
 
 typedef struct ExecutorResult {
     enum : uint8_t {
@@ -55,19 +169,103 @@ typedef struct ExecutorResult {
         EXECUTOR_LOAD_FAILED = 1,
         EXECUTOR_LIBRARY_NOT_LOADED = 2,
         EXECUTOR_FIND_SYMBOL_FAILED = 3,
+        EXECUTOR_ASSERTION_FAILED = 4,
+        /// No call stub for a typed call
+        EXECUTOR_STUB_FAILED = 5,
     } status;
 
-    /// Available only if `status` is `EXECUTOR_LOAD_FAILED` or
-    /// `EXECUTOR_FIND_SYMBOL_FAILED`
+    /// Available only if `status` is `EXECUTOR_LOAD_FAILED`,
+    /// `EXECUTOR_FIND_SYMBOL_FAILED` or `EXECUTOR_STUB_FAILED`
     Str dl_error;
 } ExecutorResult;
 
+/// Call of a procedure, kept by name to be resolved again
+typedef struct ProcedureCall {
+    /// Possibly qualified function name
+    String name;
+    bool is_qualified;
+} ProcedureCall;
+
+/// Named sequence of calls from `def <name> { ... }`. The calls are resolved
+/// on the first run and again whenever a library was loaded since, so that a
+/// run costs neither parsing nor hashing.
+typedef struct Procedure {
+    ProcedureCall* calls;
+    size_t len;
+    size_t cap;
+    /// Functions of the calls which resolved, in order
+    ExecutorFunction* functions;
+    /// `Monitor` slots of `functions`, `MONITOR_NO_SLOT` if the executor is
+    /// not monitored
+    uint32_t* slots;
+    /// Stats of `functions`, owned by the executor's caches
+    CallStats** stats;
+    size_t n_functions;
+    /// Thunk calling `functions`, `JIT_CODE_EMPTY` if not compiled
+    JitCode jit;
+    /// `Executor.generation` the calls were resolved at, 0 if never
+    uint64_t generation;
+    /// First failure of the last resolution, `EXECUTOR_SUCCESS` if none
+    ExecutorResult result;
+    /// Holds the nul-terminated `result.dl_error`, prefixed by the call
+    String error;
+} Procedure;
+
+typedef struct Executor {
+    ExecutorOptions options;
+    struct FunctionMap* functions;
+    struct LibraryMap* libraries;
+    /// Libraries `use`d with an alias, reachable only by qualified calls
+    struct AliasMap* aliases;
+    /// Cache of `<alias>.<function_name>` calls, separate from `functions`
+    struct FunctionMap* qualified_functions;
+    /// Used instead of `libraries` if `options.is_lazy` is set
+    DeferredLibraries deferred;
+    /// Procedures by name, stable pointers
+    struct ProcedureMap* procedures;
+    /// Bumped by every newly loaded library, procedures resolved at an older
+    /// generation are resolved again before they run
+    uint64_t generation;
+    /// Compiled `JitStub`s by signature, see `executor_call_typed`
+    struct StubMap* stubs;
+    /// Converts the `CallStats` cycles, started with the executor
+    CycleClock clock;
+    /// Holds the keys of the maps, the library paths and the cached
+    /// functions, all released at once by `executor_free`
+    Arena arena;
+} Executor;
+
+Executor executor_new();
+
+Executor executor_with_options(ExecutorOptions options);
+
+/// Name of the result status, e.g. `EXECUTOR_LOAD_FAILED`
+Str executor_result_name(ExecutorResult self);
+
+/// In lazy mode only reads the exported symbols of the library, the `dlopen`
+/// is postponed up to the first call of one of them.
+///
 /// # Error
 ///
 /// Returns `.status = EXECUTOR_LOAD_FAILED` with `.dl_error` containing the
 /// nul-terminated error description str when can not load library
 ExecutorResult executor_load_library(Executor* self, Str path);
 
+/// Loads the library under an alias for qualified calls. If `is_isolated` is
+/// set, the library gets its own link-map namespace with `dlmopen`, so its
+/// symbols and dependencies do not interpose with the other libraries.
+/// Aliased libraries are never deferred and take no part in unqualified
+/// calls.
+///
+/// # Error
+///
+/// Returns `.status = EXECUTOR_LOAD_FAILED` with `.dl_error` containing the
+/// nul-terminated error description str when can not load library or the
+/// alias is already taken by another library
+ExecutorResult executor_load_library_as(
+    Executor* self, Str path, Str alias, bool is_isolated
+);
+
 /// # Error
 ///
 /// Returns `.status = EXECUTOR_FIND_SYMBOL_FAILED` or `.status =
@@ -75,6 +273,147 @@ ExecutorResult executor_load_library(Executor* self, Str path);
 /// error description str when can not load library
 ExecutorResult executor_call_function(Executor* self, Str name);
 
+typedef struct ExecutorResolveResult {
+    ExecutorResult result;
+    /// Available only if `result.status == EXECUTOR_SUCCESS`
+    ExecutorFunction function;
+    /// Stats kept along the cached function, stable until `executor_free`.
+    /// Available only if `result.status == EXECUTOR_SUCCESS`, `nullptr` for
+    /// `executor_resolve_from`, which does not cache
+    CallStats* stats;
+    /// `Monitor` slot kept along the cached function, `MONITOR_NO_SLOT` if
+    /// the executor is not monitored or for `executor_resolve_from`.
+    /// Available only if `result.status == EXECUTOR_SUCCESS`
+    uint32_t slot;
+} ExecutorResolveResult;
+
+/// Finds a function the same way `executor_call_function` does, without
+/// calling it
+///
+/// # Error
+///
+/// Same as `executor_call_function`
+ExecutorResolveResult executor_resolve_function(Executor* self, Str name);
+
+/// Finds a function in the library at `path` without calling it. The library
+/// is loaded like an aliased one, so it takes no part in unqualified calls.
+///
+/// # Error
+///
+/// Returns `.result.status = EXECUTOR_LOAD_FAILED` or `.result.status =
+/// EXECUTOR_FIND_SYMBOL_FAILED` with `.result.dl_error` containing the
+/// nul-terminated error description str
+ExecutorResolveResult executor_resolve_from(
+    Executor* self, Str path, Str function_name
+);
+
+/// Calls `<alias>.<function_name>` directly from the aliased library
+///
+/// # Error
+///
+/// Returns `.status = EXECUTOR_FIND_SYMBOL_FAILED` or `.status =
+/// EXECUTOR_LIBRARY_NOT_LOADED` if there is no such alias, with `.dl_error`
+/// containing the nul-terminated error description str
+ExecutorResult executor_call_qualified_function(
+    Executor* self, Str qualified_name
+);
+
+/// Finds `<alias>.<function_name>` without calling it
+///
+/// # Error
+///
+/// Same as `executor_call_qualified_function`
+ExecutorResolveResult executor_resolve_qualified_function(
+    Executor* self, Str qualified_name
+);
+
+/// Calls the resolved function with the arguments of the typed call through
+/// the stub for its signature, compiled on the first call with that signature
+/// and cached. The result is normalized, see `typed_value_normalize`. The call
+/// is traced and counted under `name`.
+///
+/// # Error
+///
+/// Returns `.status = EXECUTOR_STUB_FAILED` with `.dl_error` containing the
+/// nul-terminated error description str if the stub can not be compiled, the
+/// function is not called then
+ExecutorResult executor_call_typed(
+    Executor* self, Str name, ExecutorResolveResult const* resolved,
+    TypedCall const* call, JitValue* result
+);
+
+/// Finds or compiles the stub for the signature
+///
+/// # Return
+///
+/// `nullptr` if the JIT is disabled or not supported on this platform
+JitStub executor_resolve_stub(Executor* self, JitSignature const* signature);
+
+/// Starts the definition of a procedure, an existing one with the same name
+/// loses its calls
+///
+/// # Return
+///
+/// The procedure to add the calls to, valid until `executor_free`
+Procedure* executor_define_procedure(Executor* self, Str name);
+
+/// Adds a call to the procedure, resolved when the procedure runs
+void procedure_add_call(Procedure* self, Str name, bool is_qualified);
+
+/// # Return
+///
+/// `nullptr` if there is no procedure with this name
+Procedure* executor_find_procedure(Executor* self, Str name);
+
+/// Resolves the calls of the procedure unless they are resolved already and
+/// no library was loaded since. Calls which do not resolve are left out.
+///
+/// # Error
+///
+/// Returns the failure of the first call which did not resolve, with
+/// `.dl_error` prefixed by its name
+ExecutorResult executor_resolve_procedure(Executor* self, Procedure* procedure);
+
+/// Calls the resolved functions of the procedure
+inline static void procedure_call(Procedure const* self) {
+    if (nullptr != self->jit.entry) {
+        self->jit.entry();
+    } else {
+        for (size_t i = 0; i < self->n_functions; ++i) {
+            self->functions[i]();
+        }
+    }
+
+    for (size_t i = 0; i < self->n_functions; ++i) {
+        self->stats[i]->n_calls += 1;
+    }
+}
+
+/// Calls the resolved functions of the procedure one by one, each timed and
+/// counted in its slot if `monitor` is set and sampled in turn if `footprint`
+/// is set
+void procedure_call_instrumented(
+    Procedure const* self, Monitor* monitor, Footprint* footprint
+);
+
+/// Resolves the procedure if needed and calls it
+///
+/// # Error
+///
+/// Returns `.status = EXECUTOR_FIND_SYMBOL_FAILED` if there is no such
+/// procedure, otherwise the same as `executor_resolve_procedure`. The calls
+/// which resolved are made anyway.
+ExecutorResult executor_run_procedure(Executor* self, Str name);
+
+/// Writes the `CallStats` of every cached function, the longest total time
+/// first, with cycles converted to nanoseconds
+void executor_write_call_stats(Executor* self, FILE* output);
+
+/// Writes the memory growth since the start, of every library and of every
+/// cached function with samples, the largest heap growth first. Writes
+/// nothing without a `Footprint`.
+void executor_write_memory_report(Executor* self, FILE* output);
+
 void executor_free(Executor* self);
 
 #endif  // !_SOTEST_INTERPRETER_H
@@ -0,0 +1,229 @@
+#include "jit.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__linux__)
+
+#include <sys/mman.h>
+
+/// `push rbx` + `movabs rbx, imm64` before, `dec rbx` + `jnz rel32` +
+/// `pop rbx` + `ret` after the calls
+size_t constexpr JIT_FRAME_SIZE = 1 + 10 + 3 + 6 + 1 + 1;
+/// `movabs rax, imm64` + `call rax`, the longest call encoding
+size_t constexpr JIT_CALL_SIZE = 10 + 2;
+
+typedef struct JitBuffer {
+    uint8_t* ptr;
+    size_t len;
+} JitBuffer;
+
+static void jit_emit(JitBuffer* self, void const* bytes, size_t len) {
+    memcpy(self->ptr + self->len, bytes, len);
+    self->len += len;
+}
+
+static void jit_emit_u32(JitBuffer* self, uint32_t value) {
+    jit_emit(self, &value, sizeof(value));
+}
+
+static void jit_emit_u64(JitBuffer* self, uint64_t value) {
+    jit_emit(self, &value, sizeof(value));
+}
+
+static void jit_emit_call(JitBuffer* self, JitFunction function) {
+    auto target = (intptr_t) function;
+    // `rel32` counts from the end of the 5-byte instruction
+    auto next = (intptr_t) (self->ptr + self->len + 5);
+    auto distance = target - next;
+
+    if (distance >= INT32_MIN && distance <= INT32_MAX) {
+        jit_emit(self, (uint8_t[]) {0xe8}, 1);
+        jit_emit_u32(self, (uint32_t) (int32_t) distance);
+        return;
+    }
+
+    // movabs rax, imm64; call rax
+    jit_emit(self, (uint8_t[]) {0x48, 0xb8}, 2);
+    jit_emit_u64(self, (uint64_t) target);
+    jit_emit(self, (uint8_t[]) {0xff, 0xd0}, 2);
+}
+
+JitCode jit_compile(JitFunction const* functions, size_t len, size_t count) {
+    if (0 == len || 0 == count) {
+        return JIT_CODE_EMPTY;
+    }
+
+    auto size = JIT_FRAME_SIZE + JIT_CALL_SIZE * len;
+    auto ptr = mmap(
+        nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+        -1, 0
+    );
+
+    if (MAP_FAILED == ptr) {
+        return JIT_CODE_EMPTY;
+    }
+
+    auto buffer = (JitBuffer) {.ptr = ptr};
+
+    // The pushed `rbx` also aligns the stack to 16 bytes for the calls.
+    // `rbx` is callee-saved, so it survives them as the loop counter.
+    // push rbx; movabs rbx, count
+    jit_emit(&buffer, (uint8_t[]) {0x53, 0x48, 0xbb}, 3);
+    jit_emit_u64(&buffer, count);
+
+    auto loop_start = buffer.len;
+
+    for (size_t i = 0; i < len; ++i) {
+        jit_emit_call(&buffer, functions[i]);
+    }
+
+    // dec rbx; jnz loop_start
+    jit_emit(&buffer, (uint8_t[]) {0x48, 0xff, 0xcb, 0x0f, 0x85}, 5);
+    auto loop_offset = (intptr_t) loop_start - (intptr_t) (buffer.len + 4);
+    jit_emit_u32(&buffer, (uint32_t) (int32_t) loop_offset);
+
+    // pop rbx; ret
+    jit_emit(&buffer, (uint8_t[]) {0x5b, 0xc3}, 2);
+
+    if (0 != mprotect(ptr, size, PROT_READ | PROT_EXEC)) {
+        munmap(ptr, size);
+        return JIT_CODE_EMPTY;
+    }
+
+    return (JitCode) {
+        .entry = (JitFunction) ptr,
+        .size = size,
+    };
+}
+
+/// `push rbx` + `mov rbx, rdx` + `mov r11, rdi` + `mov r10, rsi` +
+/// `mov eax, imm32` + `call r11` + the store of the result + `pop rbx` +
+/// `ret`
+size_t constexpr JIT_STUB_FRAME_SIZE = 1 + 3 + 3 + 3 + 5 + 3 + 4 + 1 + 1;
+/// Longest argument load, `movsd xmm, [r10 + disp8]`
+size_t constexpr JIT_LOAD_SIZE = 6;
+
+/// `rdi`, `rsi`, `rdx`, `rcx`, `r8`, `r9` in ModRM numbering
+static uint8_t const JIT_INTEGER_REGISTERS[] = {
+    7, 6, 2, 1, 8, 9,
+};
+
+static bool jit_is_float(JitType type) {
+    return JIT_TYPE_F32 == type || JIT_TYPE_F64 == type;
+}
+
+JitCode jit_compile_stub(JitSignature const* signature) {
+    auto size = JIT_STUB_FRAME_SIZE + JIT_LOAD_SIZE * signature->n_arguments;
+    auto ptr = mmap(
+        nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+        -1, 0
+    );
+
+    if (MAP_FAILED == ptr) {
+        return JIT_CODE_EMPTY;
+    }
+
+    auto buffer = (JitBuffer) {.ptr = ptr};
+
+    // `rbx` keeps the result pointer across the call and its push aligns
+    // the stack. `r10` and `r11` are free, no argument is passed in them.
+    // push rbx; mov rbx, rdx; mov r11, rdi; mov r10, rsi
+    jit_emit(&buffer, (uint8_t[]) {0x53, 0x48, 0x89, 0xd3}, 4);
+    jit_emit(&buffer, (uint8_t[]) {0x49, 0x89, 0xfb, 0x49, 0x89, 0xf2}, 6);
+
+    uint8_t n_integers = 0;
+    uint8_t n_floats = 0;
+
+    for (size_t i = 0; i < signature->n_arguments; ++i) {
+        auto type = signature->arguments[i];
+        // ModRM with a `disp8` from `r10`
+        auto displacement = (uint8_t) (i * sizeof(JitValue));
+
+        if (jit_is_float(type)) {
+            // movsd / movss xmm, [r10 + disp8]
+            auto prefix = (uint8_t) (JIT_TYPE_F64 == type ? 0xf2 : 0xf3);
+            auto modrm = (uint8_t) (0x42 | (n_floats << 3));
+            jit_emit(
+                &buffer,
+                (uint8_t[]) {prefix, 0x41, 0x0f, 0x10, modrm, displacement},
+                6
+            );
+            n_floats += 1;
+            continue;
+        }
+
+        // mov r64, [r10 + disp8]
+        auto reg = JIT_INTEGER_REGISTERS[n_integers];
+        auto rex = (uint8_t) (0x49 | ((reg >> 3) << 2));
+        auto modrm = (uint8_t) (0x42 | ((reg & 7) << 3));
+        jit_emit(&buffer, (uint8_t[]) {rex, 0x8b, modrm, displacement}, 4);
+        n_integers += 1;
+    }
+
+    // mov eax, n_floats; call r11
+    jit_emit(&buffer, (uint8_t[]) {0xb8}, 1);
+    jit_emit_u32(&buffer, n_floats);
+    jit_emit(&buffer, (uint8_t[]) {0x41, 0xff, 0xd3}, 3);
+
+    switch (signature->result) {
+    case JIT_TYPE_VOID:
+        break;
+    case JIT_TYPE_I32:
+    case JIT_TYPE_I64:
+    case JIT_TYPE_U32:
+    case JIT_TYPE_U64:
+        // mov [rbx], rax
+        jit_emit(&buffer, (uint8_t[]) {0x48, 0x89, 0x03}, 3);
+        break;
+    case JIT_TYPE_F32:
+        // movss [rbx], xmm0
+        jit_emit(&buffer, (uint8_t[]) {0xf3, 0x0f, 0x11, 0x03}, 4);
+        break;
+    case JIT_TYPE_F64:
+        // movsd [rbx], xmm0
+        jit_emit(&buffer, (uint8_t[]) {0xf2, 0x0f, 0x11, 0x03}, 4);
+        break;
+    }
+
+    // pop rbx; ret
+    jit_emit(&buffer, (uint8_t[]) {0x5b, 0xc3}, 2);
+
+    if (0 != mprotect(ptr, size, PROT_READ | PROT_EXEC)) {
+        munmap(ptr, size);
+        return JIT_CODE_EMPTY;
+    }
+
+    return (JitCode) {
+        .entry = (JitFunction) ptr,
+        .size = size,
+    };
+}
+
+void jit_free(JitCode* self) {
+    if (nullptr != self->entry) {
+        munmap((void*) self->entry, self->size);
+    }
+
+    *self = JIT_CODE_EMPTY;
+}
+
+#else
+
+JitCode jit_compile(JitFunction const* functions, size_t len, size_t count) {
+    (void) functions;
+    (void) len;
+    (void) count;
+
+    return JIT_CODE_EMPTY;
+}
+
+JitCode jit_compile_stub(JitSignature const* signature) {
+    (void) signature;
+
+    return JIT_CODE_EMPTY;
+}
+
+void jit_free(JitCode* self) { *self = JIT_CODE_EMPTY; }
+
+#endif
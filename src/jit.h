@@ -0,0 +1,89 @@
+#ifndef _SOTEST_JIT_H
+#define _SOTEST_JIT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef void (*JitFunction)();
+
+/// Argument and result types of typed calls
+typedef enum JitType : uint8_t {
+    JIT_TYPE_VOID = 0,
+    JIT_TYPE_I32,
+    JIT_TYPE_I64,
+    JIT_TYPE_U32,
+    JIT_TYPE_U64,
+    JIT_TYPE_F32,
+    JIT_TYPE_F64,
+} JitType;
+
+/// Integer arguments passed in registers by the SysV ABI
+size_t constexpr JIT_MAX_INTEGER_ARGUMENTS = 6;
+/// Floating-point arguments passed in registers by the SysV ABI
+size_t constexpr JIT_MAX_FLOAT_ARGUMENTS = 8;
+size_t constexpr JIT_MAX_ARGUMENTS =
+    JIT_MAX_INTEGER_ARGUMENTS + JIT_MAX_FLOAT_ARGUMENTS;
+
+/// Argument or result of a typed call. Integers are stored sign- or
+/// zero-extended to 64 bits, `f32` in the low 4 bytes.
+typedef union JitValue {
+    int64_t i64;
+    uint64_t u64;
+    float f32;
+    double f64;
+} JitValue;
+
+/// Types of a function taking every argument in a register
+typedef struct JitSignature {
+    JitType arguments[JIT_MAX_ARGUMENTS];
+    size_t n_arguments;
+    JitType result;
+} JitSignature;
+
+/// Calls `function` with the `arguments` of the stub's signature and stores
+/// its result, if any, into `result`
+typedef void (*JitStub)(
+    JitFunction function, JitValue const* arguments, JitValue* result
+);
+
+/// Machine code calling a fixed list of functions, see `jit_compile`
+typedef struct JitCode {
+    /// `nullptr` if nothing was compiled
+    JitFunction entry;
+    /// Size of the mapping `entry` points to
+    size_t size;
+} JitCode;
+
+JitCode constexpr JIT_CODE_EMPTY = {.entry = nullptr, .size = 0};
+
+/// Compiles a thunk which calls `functions` in order, `count` times over.
+/// The calls are direct `call rel32` when the function is within 2 GiB of
+/// the thunk, `call` through a register otherwise. The thunk is mapped
+/// executable but not writable.
+///
+/// Only available on x86-64 Linux.
+///
+/// # Return
+///
+/// `JIT_CODE_EMPTY` if the platform is not supported, `len` or `count` is 0,
+/// or the code can not be mapped. Callers fall back to calling the functions
+/// themselves.
+JitCode jit_compile(JitFunction const* functions, size_t len, size_t count);
+
+/// Compiles a `JitStub` for the signature. The stub loads every argument
+/// into its SysV register, sets `al` to the number of vector registers used
+/// (so variadic functions work too) and calls the function through a
+/// register. The signature must fit into registers, see
+/// `JIT_MAX_INTEGER_ARGUMENTS` and `JIT_MAX_FLOAT_ARGUMENTS`.
+///
+/// Only available on x86-64 Linux.
+///
+/// # Return
+///
+/// `JIT_CODE_EMPTY` if the platform is not supported or the code can not be
+/// mapped. `entry` is a `JitStub` otherwise.
+JitCode jit_compile_stub(JitSignature const* signature);
+
+void jit_free(JitCode* self);
+
+#endif  // !_SOTEST_JIT_H
@@ -1,18 +1,81 @@
+#define _GNU_SOURCE
+
 #include "str.h"
-#include "interpreter.h"
 #include "args.h"
+#include "session.h"
+#include "prefetch.h"
+#include "check.h"
+#include "monitor.h"
+#include "footprint.h"
 
 #include <stdio.h>
 #include <errno.h>
+#include <signal.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+/// Set by `SIGUSR1`, the call stats and the memory report are written before
+/// the next line is read
+static volatile sig_atomic_t IS_CALL_STATS_REQUESTED = 0;
+
+static void request_call_stats(int signal) {
+    (void) signal;
+    IS_CALL_STATS_REQUESTED = 1;
+}
+
 int main(int argc, char* argv[]) {
     auto args = args_parse((size_t) argc, argv);
 
     auto buf = STRING_EMPTY;
-    auto executor = executor_new();
+    auto session = session_new((ExecutorOptions) {
+        .is_lazy = args_has(&args, Str("lazy")),
+        .is_jit_disabled = args_has(&args, Str("no-jit")),
+    });
     auto input = stdin;
+    auto prefetcher = (Prefetcher) {};
+    int exit_status = EXIT_SUCCESS;
+
+    session.compare_options.n_samples = args_get_size(
+        &args, Str("compare-samples"), COMPARE_DEFAULT_SAMPLES
+    );
+    session.compare_options.max_regression = args_get_double(
+        &args, Str("max-regression"), COMPARE_DEFAULT_MAX_REGRESSION
+    );
+
+    session.bench_options = (BenchOptions) {
+        .compare = session.compare_options,
+        .history_path = args_get(&args, Str("history")),
+        .is_baseline = args_has(&args, Str("baseline")),
+    };
+
+    if (session.bench_options.is_baseline &&
+        0 == session.bench_options.history_path.len)
+    {
+        fprintf(stderr, "error: --baseline needs a --history file\n");
+
+        session_free(&session);
+        string_free(&buf);
+        args_free(&args);
+
+        exit(EXIT_FAILURE);
+    }
+
+    ReportFormat format = REPORT_FORMAT_TEXT;
+    auto format_name = args_get(&args, Str("format"));
+
+    if (0 != format_name.len && !report_format_parse(format_name, &format)) {
+        fprintf(
+            stderr, "error: unknown format '%s', expected `text` or `jsonl`\n",
+            format_name.ptr
+        );
+
+        session_free(&session);
+        string_free(&buf);
+        args_free(&args);
+
+        exit(EXIT_FAILURE);
+    }
 
     auto file_argument = args_get(&args, Str("FILE"));
     bool reading_from_file = 0 != file_argument.len;
@@ -26,7 +89,7 @@ int main(int argc, char* argv[]) {
                 strerror(errno)
             );
 
-            executor_free(&executor);
+            session_free(&session);
             string_free(&buf);
             args_free(&args);
 
@@ -34,78 +97,225 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    while (true) {
-        // Print arrows in terminal-mode only
-        if (isatty(STDIN_FILENO) && !reading_from_file) {
-            printf(" >>> ");
+    if (args_has(&args, Str("check"))) {
+        auto name = reading_from_file ? file_argument : Str("<stdin>");
+        auto n_problems = check_script(input, name, stderr);
+
+        if (reading_from_file) {
+            fclose(input);
         }
 
-        string_clear(&buf);
+        session_free(&session);
+        string_free(&buf);
+        args_free(&args);
 
-        if (READLINE_EOF == string_readline(&buf, input)) {
-            break;
-        }
+        exit(0 == n_problems ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
 
-        auto line = str_trim(buf.str);
+    session.environment = environment_setup((EnvironmentOptions) {
+        .cpus = args_get(&args, Str("cpus")),
+        .lock_memory = args_has(&args, Str("lock-memory")),
+        .high_priority = args_has(&args, Str("high-priority")),
+        .warmup_ms = args_get_size(&args, Str("warmup"), 0),
+    });
 
-        auto command_line_result = command_line_parse(str_trim(line));
+    // Scripts can be re-read from the start, so page in the libraries while
+    // earlier commands run
+    if (reading_from_file && !args_has(&args, Str("no-prefetch"))) {
+        prefetcher_start(&prefetcher, file_argument);
+    }
 
-        if (str_starts_with(line, Str("exit"))) {
-            break;
+    FILE* capture_map = nullptr;
+    auto capture_map_path = args_get(&args, Str("capture-map"));
+
+    if (0 != capture_map_path.len) {
+        capture_map = fopen(capture_map_path.ptr, "w");
+
+        if (nullptr == capture_map) {
+            fprintf(
+                stderr, "error: failed to open '%s': %s\n",
+                capture_map_path.ptr, strerror(errno)
+            );
+            exit_status = EXIT_FAILURE;
         }
+    }
+
+    if ((args_has(&args, Str("capture")) || nullptr != capture_map) &&
+        !capture_start(&session.capture, capture_map))
+    {
+        fprintf(
+            stderr, "error: failed to capture the output: %s\n",
+            strerror(errno)
+        );
+        exit_status = EXIT_FAILURE;
+    }
+
+    FILE* profile_output = nullptr;
+    auto profile_path = args_get(&args, Str("profile"));
 
-        auto tail = str_trim_end(command_line_result.tail);
+    if (0 != profile_path.len) {
+        profile_output = fopen(profile_path.ptr, "w");
 
-        if (!command_line_result.has_value || 0 != tail.len) {
+        if (nullptr == profile_output) {
             fprintf(
-                stderr, "error: failed to parse '%s' as `CommandLine`\n",
-                line.ptr
+                stderr, "error: failed to open '%s': %s\n", profile_path.ptr,
+                strerror(errno)
+            );
+            exit_status = EXIT_FAILURE;
+        } else if (!profiler_start(
+                       &session.profiler, profile_output,
+                       args_get_size(
+                           &args, Str("profile-rate"), PROFILE_DEFAULT_RATE
+                       )
+                   ))
+        {
+            fprintf(
+                stderr, "error: failed to start the profiler: %s\n",
+                strerror(errno)
             );
-            continue;
+            exit_status = EXIT_FAILURE;
         }
+    }
 
-        auto command_line = &command_line_result.value;
+    auto monitor = (Monitor) {};
 
-        if (!command_line->has_command) {
-            continue;
+    if (args_has(&args, Str("monitor"))) {
+        if (monitor_start(&monitor)) {
+            session.executor.options.monitor = &monitor;
+        } else {
+            fprintf(
+                stderr, "error: failed to create the stats segment: %s\n",
+                strerror(errno)
+            );
+            exit_status = EXIT_FAILURE;
         }
+    }
+
+    auto footprint = (Footprint) {};
+    FILE* series = nullptr;
+    auto series_path = args_get(&args, Str("mem-series"));
+    auto max_growth = args_get_size(&args, Str("mem-max-growth"), 0);
+
+    if (0 != series_path.len) {
+        series = fopen(series_path.ptr, "w");
 
-        switch (command_line->command.type) {
-        case COMMAND_TYPE_USE: {
-            auto const result =
-                executor_load_library(&executor, command_line->command.content);
-
-            if (EXECUTOR_SUCCESS != result.status) {
-                fprintf(
-                    stderr, "error: failed to load library: %s\n",
-                    result.dl_error.ptr
-                );
-
-                continue;
-            }
-        } break;
-        case COMMAND_TYPE_CALL: {
-            auto const result = executor_call_function(
-                &executor, command_line->command.content
+        if (nullptr == series) {
+            fprintf(
+                stderr, "error: failed to open '%s': %s\n", series_path.ptr,
+                strerror(errno)
             );
+            exit_status = EXIT_FAILURE;
+        }
+    }
+
+    if (args_has(&args, Str("mem-report")) || nullptr != series ||
+        0 != max_growth)
+    {
+        footprint_start(
+            &footprint,
+            args_get_size(&args, Str("mem-period"), FOOTPRINT_DEFAULT_PERIOD),
+            max_growth, series
+        );
+        session.executor.options.footprint = &footprint;
+    }
 
-            if (EXECUTOR_SUCCESS != result.status) {
-                fprintf(
-                    stderr, "error: failed to call the function: %s\n",
-                    result.dl_error.ptr
-                );
+    if (!reporter_init(&session.reporter, format)) {
+        fprintf(
+            stderr, "error: failed to set up the report: %s\n",
+            strerror(errno)
+        );
+        exit_status = EXIT_FAILURE;
+    }
+
+    struct sigaction call_stats_action = {};
+    call_stats_action.sa_handler = request_call_stats;
+    call_stats_action.sa_flags = SA_RESTART;
+    sigemptyset(&call_stats_action.sa_mask);
+    sigaction(SIGUSR1, &call_stats_action, nullptr);
+
+    bool is_interactive = isatty(STDIN_FILENO) && !reading_from_file;
+
+    while (true) {
+        if (IS_CALL_STATS_REQUESTED) {
+            IS_CALL_STATS_REQUESTED = 0;
+            executor_write_call_stats(&session.executor, stderr);
+            executor_write_memory_report(&session.executor, stderr);
+        }
 
-                continue;
-            }
-        } break;
+        // Print arrows in terminal-mode only
+        if (is_interactive) {
+            printf(" >>> ");
+            capture_flush(&session.capture);
+        }
+
+        string_clear(&buf);
+
+        if (READLINE_EOF == string_readline(&buf, input)) {
+            break;
+        }
+
+        if (!session_execute_line(&session, buf.str)) {
+            break;
         }
+
+        // Show the output right away in interactive mode
+        if (is_interactive) {
+            capture_flush(&session.capture);
+            reporter_flush(&session.reporter);
+        }
+    }
+
+    session_finish(&session);
+
+    if (session.has_failed) {
+        exit_status = EXIT_FAILURE;
+    }
+
+    if (args_has(&args, Str("call-stats")) || IS_CALL_STATS_REQUESTED) {
+        executor_write_call_stats(&session.executor, stderr);
+    }
+
+    if (args_has(&args, Str("mem-report")) || IS_CALL_STATS_REQUESTED) {
+        executor_write_memory_report(&session.executor, stderr);
+    }
+
+    auto n_dropped = profiler_stop(&session.profiler);
+
+    if (0 != n_dropped) {
+        fprintf(
+            stderr,
+            "warning: %zu profile samples dropped, a command ran longer than "
+            "%zu samples\n",
+            n_dropped, PROFILE_MAX_SAMPLES
+        );
+    }
+
+    if (nullptr != profile_output) {
+        fclose(profile_output);
+    }
+
+    monitor_stop(&monitor);
+    footprint_free(&footprint);
+
+    if (nullptr != series) {
+        fclose(series);
     }
 
+    // Stops the capture, which may still write to the map
+    session_free(&session);
+
+    if (nullptr != capture_map) {
+        fclose(capture_map);
+    }
+
+    prefetcher_stop(&prefetcher);
+
     if (reading_from_file) {
         fclose(input);
     }
 
-    executor_free(&executor);
     string_free(&buf);
     args_free(&args);
+
+    return exit_status;
 }
@@ -0,0 +1,187 @@
+#define _GNU_SOURCE
+
+#include "monitor.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define K String
+#define V uint32_t
+#define SNAME SlotMap
+#define PFX slot_map
+
+#include <cmc/hashmap.h>
+
+static int local_string_compare(String a, String b) {
+    return string_compare(&a, &b);
+}
+
+static void local_string_free(String string) { string_free(&string); }
+
+static size_t local_string_hash(String string) { return string_hash(&string); }
+
+struct SlotMap_fkey SLOT_MAP_FKEY = {
+    .cmp = local_string_compare,
+    .free = local_string_free,
+    .hash = local_string_hash,
+};
+
+struct SlotMap_fval SLOT_MAP_FVAL = {};
+
+static void monitor_name(Monitor* self, pid_t pid) {
+    snprintf(self->name, sizeof(self->name), "/sotest-%d", (int) pid);
+}
+
+bool monitor_start(Monitor* self) {
+    *self = (Monitor) {};
+    monitor_name(self, getpid());
+
+    // A segment left by a crashed process with a reused pid is replaced
+    shm_unlink(self->name);
+
+    auto fd = shm_open(self->name, O_RDWR | O_CREAT | O_EXCL, 0644);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    if (0 != ftruncate(fd, sizeof(MonitorSegment))) {
+        auto error = errno;
+        close(fd);
+        shm_unlink(self->name);
+        errno = error;
+
+        return false;
+    }
+
+    auto segment = mmap(
+        nullptr, sizeof(MonitorSegment), PROT_READ | PROT_WRITE, MAP_SHARED,
+        fd, 0
+    );
+    close(fd);
+
+    if (MAP_FAILED == segment) {
+        auto error = errno;
+        shm_unlink(self->name);
+        errno = error;
+
+        return false;
+    }
+
+    // `ftruncate` zeroed the counters
+    self->segment = segment;
+    self->segment->version = MONITOR_VERSION;
+    self->segment->pid = getpid();
+    self->segment->start_ns = monitor_now_ns();
+    self->slots = slot_map_new(64, 0.5, &SLOT_MAP_FKEY, &SLOT_MAP_FVAL);
+    self->is_owner = true;
+
+    // Readers check the magic last, once the header is complete
+    atomic_thread_fence(memory_order_release);
+    self->segment->magic = MONITOR_MAGIC;
+
+    return true;
+}
+
+void monitor_stop(Monitor* self) {
+    if (nullptr == self->segment) {
+        return;
+    }
+
+    atomic_store_explicit(
+        &self->segment->is_finished, 1, memory_order_release
+    );
+    munmap(self->segment, sizeof(MonitorSegment));
+    shm_unlink(self->name);
+    slot_map_free(self->slots);
+
+    *self = (Monitor) {};
+}
+
+bool monitor_attach(Monitor* self, pid_t pid) {
+    *self = (Monitor) {};
+    monitor_name(self, pid);
+
+    auto fd = shm_open(self->name, O_RDONLY, 0);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat status;
+
+    if (0 != fstat(fd, &status) ||
+        (size_t) status.st_size != sizeof(MonitorSegment))
+    {
+        close(fd);
+        errno = EPROTO;
+
+        return false;
+    }
+
+    auto segment =
+        mmap(nullptr, sizeof(MonitorSegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (MAP_FAILED == segment) {
+        return false;
+    }
+
+    self->segment = segment;
+
+    if (MONITOR_MAGIC != self->segment->magic ||
+        MONITOR_VERSION != self->segment->version)
+    {
+        monitor_detach(self);
+        errno = EPROTO;
+
+        return false;
+    }
+
+    return true;
+}
+
+void monitor_detach(Monitor* self) {
+    if (nullptr != self->segment) {
+        munmap(self->segment, sizeof(MonitorSegment));
+    }
+
+    *self = (Monitor) {};
+}
+
+uint32_t monitor_slot(Monitor* self, Str function_name) {
+    auto slot = slot_map_get_ref(self->slots, (String) {.str = function_name});
+
+    if (nullptr != slot) {
+        return *slot;
+    }
+
+    auto n_functions = monitor_load(&self->segment->n_functions);
+
+    if (n_functions == MONITOR_MAX_FUNCTIONS) {
+        return MONITOR_NO_SLOT;
+    }
+
+    auto function = &self->segment->functions[n_functions];
+    auto len = function_name.len < MONITOR_NAME_SIZE - 1
+                   ? function_name.len
+                   : MONITOR_NAME_SIZE - 1;
+    memcpy(function->name, function_name.ptr, len);
+    function->name[len] = '\0';
+
+    atomic_store_explicit(
+        &self->segment->n_functions.value, n_functions + 1,
+        memory_order_release
+    );
+
+    auto name_copy = STRING_EMPTY;
+    string_append(&name_copy, function_name);
+    slot_map_insert(self->slots, name_copy, (uint32_t) n_functions);
+
+    return (uint32_t) n_functions;
+}
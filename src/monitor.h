@@ -0,0 +1,137 @@
+#ifndef _SOTEST_MONITOR_H
+#define _SOTEST_MONITOR_H
+
+#include "str.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+
+/// Functions with their own counters, calls of later ones count only in the
+/// totals
+size_t constexpr MONITOR_MAX_FUNCTIONS = 256;
+/// Longer names are cut, the slot is still their own
+size_t constexpr MONITOR_NAME_SIZE = 48;
+/// Calls of a repeated function counted at once, so a long `repeat` shows
+/// progress without a clock read per call
+size_t constexpr MONITOR_CHUNK = 1024;
+
+uint64_t constexpr MONITOR_MAGIC = 0x726f74696e6f6d73;  // "smonitor"
+uint32_t constexpr MONITOR_VERSION = 1;
+
+/// Function without a slot of its own, see `MONITOR_MAX_FUNCTIONS`
+uint32_t constexpr MONITOR_NO_SLOT = UINT32_MAX;
+
+/// Counter on a cache line of its own, so the reader polling one counter
+/// does not bounce the line another one is written to
+typedef struct MonitorCounter {
+    alignas(64) _Atomic uint64_t value;
+} MonitorCounter;
+
+/// Both counters of a function are written together, they share a line
+typedef struct MonitorFunction {
+    alignas(64) _Atomic uint64_t n_calls;
+    _Atomic uint64_t total_ns;
+    /// Nul-terminated, written before the slot is published
+    char name[MONITOR_NAME_SIZE];
+} MonitorFunction;
+
+/// Layout of the shared memory segment. Only the interpreter writes, with
+/// relaxed atomic adds; readers see each counter consistent on its own.
+typedef struct MonitorSegment {
+    uint64_t magic;
+    uint32_t version;
+    pid_t pid;
+    /// `CLOCK_MONOTONIC` time the interpreter started at
+    uint64_t start_ns;
+    /// Set once the interpreter is done, the counters are final
+    _Atomic uint32_t is_finished;
+    MonitorCounter n_lines;
+    MonitorCounter n_calls;
+    MonitorCounter n_cache_hits;
+    MonitorCounter n_cache_misses;
+    MonitorCounter n_libraries;
+    /// Slots of `functions` in use, bumped with release order after the name
+    /// is written
+    MonitorCounter n_functions;
+    MonitorFunction functions[MONITOR_MAX_FUNCTIONS];
+} MonitorSegment;
+
+/// Live counters of the interpreter in `/dev/shm/sotest-<pid>`, read by
+/// `sotest-top` while a script runs
+typedef struct Monitor {
+    MonitorSegment* segment;
+    /// Name of the segment for `shm_open`, `/sotest-<pid>`
+    char name[32];
+    /// Slots by function name, only kept by the interpreter
+    struct SlotMap* slots;
+    /// The segment was created by this monitor and is removed by it
+    bool is_owner;
+} Monitor;
+
+/// Creates the segment of this process
+///
+/// # Error
+///
+/// Returns `false` and sets `errno` if the segment can not be created
+bool monitor_start(Monitor* self);
+
+/// Marks the counters final and removes the segment, readers keep their
+/// mapping
+void monitor_stop(Monitor* self);
+
+/// Maps the segment of the interpreter with the process id read-only
+///
+/// # Error
+///
+/// Returns `false` and sets `errno` if there is no such segment or it has an
+/// unknown layout
+bool monitor_attach(Monitor* self, pid_t pid);
+
+/// Unmaps a segment from `monitor_attach`
+void monitor_detach(Monitor* self);
+
+/// Finds the slot of the function, taking a free one on the first call
+///
+/// # Return
+///
+/// `MONITOR_NO_SLOT` if every slot is taken
+uint32_t monitor_slot(Monitor* self, Str function_name);
+
+inline static void monitor_add(MonitorCounter* counter, uint64_t n) {
+    atomic_fetch_add_explicit(&counter->value, n, memory_order_relaxed);
+}
+
+inline static uint64_t monitor_load(MonitorCounter const* counter) {
+    return atomic_load_explicit(&counter->value, memory_order_relaxed);
+}
+
+/// Counts calls of the function in `slot` which took `duration_ns` together
+inline static void monitor_count_calls(
+    Monitor* self, uint32_t slot, uint64_t n_calls, uint64_t duration_ns
+) {
+    monitor_add(&self->segment->n_calls, n_calls);
+
+    if (MONITOR_NO_SLOT == slot) {
+        return;
+    }
+
+    auto function = &self->segment->functions[slot];
+    atomic_fetch_add_explicit(
+        &function->n_calls, n_calls, memory_order_relaxed
+    );
+    atomic_fetch_add_explicit(
+        &function->total_ns, duration_ns, memory_order_relaxed
+    );
+}
+
+/// Clock of the call durations
+inline static uint64_t monitor_now_ns() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (uint64_t) time.tv_sec * 1000000000 + (uint64_t) time.tv_nsec;
+}
+
+#endif  // !_SOTEST_MONITOR_H
@@ -2,6 +2,10 @@
 #include "interpreter.h"
 
 #include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 ParseResult parse_prefix(Str source, Str prefix) {
     if (!str_starts_with(source, prefix)) {
@@ -103,7 +107,605 @@ ParseResult parse_function_name(Str source) {
     };
 }
 
+ParseResult parse_qualified_name(Str source) {
+    auto first_result = parse_function_name(source);
+
+    if (!first_result.has_value) {
+        return first_result;
+    }
+
+    auto dot_result = parse_prefix(first_result.tail, Str("."));
+
+    if (!dot_result.has_value) {
+        return first_result;
+    }
+
+    auto second_result = parse_function_name(dot_result.tail);
+
+    if (!second_result.has_value) {
+        return (ParseResult) {
+            .has_value = false,
+            .tail = source,
+        };
+    }
+
+    return (ParseResult) {
+        .has_value = true,
+        .value = str_slice(
+            source, 0, (size_t) (second_result.tail.ptr - source.ptr)
+        ),
+        .tail = second_result.tail,
+    };
+}
+
+/// Parses the optional `as <alias>` or `in <alias>` part of `use`
+static CommandParseResult command_parse_use_alias(Command command, Str source) {
+    auto no_alias_result = (CommandParseResult) {
+        .has_value = true,
+        .value = command,
+        .tail = source,
+    };
+
+    auto keyword_str = str_trim_start(source);
+
+    // Should trim at least one whitespace
+    if (keyword_str.len == source.len) {
+        return no_alias_result;
+    }
+
+    auto keyword_result = parse_prefix(keyword_str, Str("as"));
+
+    if (!keyword_result.has_value) {
+        keyword_result = parse_prefix(keyword_str, Str("in"));
+        command.is_isolated = keyword_result.has_value;
+    }
+
+    if (!keyword_result.has_value) {
+        return no_alias_result;
+    }
+
+    auto alias_str = str_trim_start(keyword_result.tail);
+
+    if (alias_str.len == keyword_result.tail.len) {
+        return no_alias_result;
+    }
+
+    auto alias_result = parse_function_name(alias_str);
+
+    if (!alias_result.has_value) {
+        return no_alias_result;
+    }
+
+    command.alias = alias_result.value;
+
+    return (CommandParseResult) {
+        .has_value = true,
+        .value = command,
+        .tail = alias_result.tail,
+    };
+}
+
+ParseResult parse_hash(Str source) {
+    size_t end = 0;
+
+    while (end < source.len && isxdigit(source.ptr[end])) {
+        end += 1;
+    }
+
+    // A hash is a whole word, `12g` is not the hash `12`
+    auto is_cut = end < source.len &&
+                  (isalnum(source.ptr[end]) || '_' == source.ptr[end]);
+
+    if (0 == end || end > 16 || is_cut) {
+        return (ParseResult) {
+            .has_value = false,
+            .tail = source,
+        };
+    }
+
+    return (ParseResult) {
+        .has_value = true,
+        .value = str_slice(source, 0, end),
+        .tail = str_slice(source, end, source.len),
+    };
+}
+
+ParseResult parse_number(Str source, size_t* number) {
+    auto fail_result = (ParseResult) {
+        .has_value = false,
+        .tail = source,
+    };
+
+    size_t end = 0;
+    size_t value = 0;
+
+    for (; end < source.len && isdigit(source.ptr[end]); ++end) {
+        auto digit = (size_t) (source.ptr[end] - '0');
+
+        if (value > (SIZE_MAX - digit) / 10) {
+            return fail_result;
+        }
+
+        value = 10 * value + digit;
+    }
+
+    if (0 == end ||
+        (end < source.len &&
+         (isalpha(source.ptr[end]) || '_' == source.ptr[end])))
+    {
+        return fail_result;
+    }
+
+    *number = value;
+
+    return (ParseResult) {
+        .has_value = true,
+        .value = str_slice(source, 0, end),
+        .tail = str_slice(source, end, source.len),
+    };
+}
+
+ParseResult parse_type(Str source, JitType* type) {
+    static JitType const TYPES[] = {
+        JIT_TYPE_I32, JIT_TYPE_I64, JIT_TYPE_U32,
+        JIT_TYPE_U64, JIT_TYPE_F32, JIT_TYPE_F64,
+    };
+
+    auto name_result = parse_function_name(source);
+
+    if (name_result.has_value) {
+        for (size_t i = 0; i < sizeof(TYPES) / sizeof(*TYPES); ++i) {
+            if (str_eq(name_result.value, typed_type_name(TYPES[i]))) {
+                *type = TYPES[i];
+                return name_result;
+            }
+        }
+    }
+
+    return (ParseResult) {
+        .has_value = false,
+        .tail = source,
+    };
+}
+
+ParseResult parse_typed_value(Str source, JitType type, JitValue* value) {
+    auto fail_result = (ParseResult) {
+        .has_value = false,
+        .tail = source,
+    };
+
+    size_t end = 0;
+
+    for (; end < source.len; ++end) {
+        auto symbol = source.ptr[end];
+
+        if (',' == symbol || ')' == symbol || '#' == symbol ||
+            isspace(symbol))
+        {
+            break;
+        }
+    }
+
+    // `strto*` need a nul-terminated copy
+    char buffer[64];
+
+    if (0 == end || end >= sizeof(buffer)) {
+        return fail_result;
+    }
+
+    memcpy(buffer, source.ptr, end);
+    buffer[end] = '\0';
+
+    auto is_negative = '-' == buffer[0];
+    auto digits = buffer + (is_negative || '+' == buffer[0]);
+    auto base = 0 == strncmp(digits, "0x", 2) ? 16 : 10;
+    char* parsed_end = nullptr;
+    errno = 0;
+
+    switch (type) {
+    case JIT_TYPE_I32:
+    case JIT_TYPE_I64: {
+        auto number = strtoll(buffer, &parsed_end, base);
+
+        auto is_out_of_range =
+            JIT_TYPE_I32 == type && (number < INT32_MIN || number > INT32_MAX);
+
+        if (0 != errno || is_out_of_range) {
+            return fail_result;
+        }
+
+        value->i64 = number;
+    } break;
+    case JIT_TYPE_U32:
+    case JIT_TYPE_U64: {
+        auto number = strtoull(buffer, &parsed_end, base);
+
+        // `strtoull` negates negative numbers instead of failing
+        if (0 != errno || is_negative ||
+            (JIT_TYPE_U32 == type && number > UINT32_MAX))
+        {
+            return fail_result;
+        }
+
+        value->u64 = number;
+    } break;
+    case JIT_TYPE_F32:
+        *value = (JitValue) {.f32 = strtof(buffer, &parsed_end)};
+
+        if (ERANGE == errno && isinf(value->f32)) {
+            return fail_result;
+        }
+        break;
+    case JIT_TYPE_F64:
+        value->f64 = strtod(buffer, &parsed_end);
+
+        if (ERANGE == errno && isinf(value->f64)) {
+            return fail_result;
+        }
+        break;
+    case JIT_TYPE_VOID:
+        return fail_result;
+    }
+
+    if (buffer + end != parsed_end) {
+        return fail_result;
+    }
+
+    return (ParseResult) {
+        .has_value = true,
+        .value = str_slice(source, 0, end),
+        .tail = str_slice(source, end, source.len),
+    };
+}
+
+/// Parses `<type> <value>` of a typed call argument and adds it to `call`
+static ParseResult parse_typed_argument(Str source, TypedCall* call) {
+    auto fail_result = (ParseResult) {
+        .has_value = false,
+        .tail = source,
+    };
+
+    JitType type = JIT_TYPE_VOID;
+    auto type_result = parse_type(source, &type);
+
+    if (!type_result.has_value) {
+        return fail_result;
+    }
+
+    auto value_str = str_trim_start(type_result.tail);
+
+    // Should trim at least one whitespace
+    if (value_str.len == type_result.tail.len) {
+        return fail_result;
+    }
+
+    auto signature = &call->signature;
+    size_t n_floats = 0;
+
+    for (size_t i = 0; i < signature->n_arguments; ++i) {
+        auto argument = signature->arguments[i];
+        n_floats += JIT_TYPE_F32 == argument || JIT_TYPE_F64 == argument;
+    }
+
+    auto is_float = JIT_TYPE_F32 == type || JIT_TYPE_F64 == type;
+    auto n_integers = signature->n_arguments - n_floats;
+
+    if ((is_float && JIT_MAX_FLOAT_ARGUMENTS == n_floats) ||
+        (!is_float && JIT_MAX_INTEGER_ARGUMENTS == n_integers))
+    {
+        return fail_result;
+    }
+
+    auto value_result = parse_typed_value(
+        value_str, type, &call->arguments[signature->n_arguments]
+    );
+
+    if (!value_result.has_value) {
+        return fail_result;
+    }
+
+    signature->arguments[signature->n_arguments] = type;
+    signature->n_arguments += 1;
+
+    return (ParseResult) {
+        .has_value = true,
+        .value = str_slice(source, 0, source.len - value_result.tail.len),
+        .tail = value_result.tail,
+    };
+}
+
+ParseResult parse_typed_call(Str source, TypedCall* call) {
+    auto fail_result = (ParseResult) {
+        .has_value = false,
+        .tail = source,
+    };
+
+    auto open_result = parse_prefix(source, Str("("));
+
+    if (!open_result.has_value) {
+        return fail_result;
+    }
+
+    *call = (TypedCall) {};
+
+    auto tail = str_trim_start(open_result.tail);
+
+    while (!str_starts_with(tail, Str(")"))) {
+        if (0 != call->signature.n_arguments) {
+            auto comma_result = parse_prefix(tail, Str(","));
+
+            if (!comma_result.has_value) {
+                return fail_result;
+            }
+
+            tail = str_trim_start(comma_result.tail);
+        }
+
+        auto argument_result = parse_typed_argument(tail, call);
+
+        if (!argument_result.has_value) {
+            return fail_result;
+        }
+
+        tail = str_trim_start(argument_result.tail);
+    }
+
+    // Skip `)`
+    tail = str_slice(tail, 1, tail.len);
+
+    auto arrow_result = parse_prefix(str_trim_start(tail), Str("->"));
+
+    if (arrow_result.has_value) {
+        auto type_result = parse_type(
+            str_trim_start(arrow_result.tail), &call->signature.result
+        );
+
+        if (!type_result.has_value) {
+            return fail_result;
+        }
+
+        tail = type_result.tail;
+
+        auto equals_result = parse_prefix(str_trim_start(tail), Str("="));
+
+        if (equals_result.has_value) {
+            auto value_result = parse_typed_value(
+                str_trim_start(equals_result.tail), call->signature.result,
+                &call->expected
+            );
+
+            if (!value_result.has_value) {
+                return fail_result;
+            }
+
+            call->has_expected = true;
+            tail = value_result.tail;
+        }
+    }
+
+    return (ParseResult) {
+        .has_value = true,
+        .value = str_slice(source, 0, source.len - tail.len),
+        .tail = tail,
+    };
+}
+
+/// Parses `<count> {` or `<count> <command>` of `repeat`
+static CommandParseResult command_parse_repeat(Str source) {
+    auto fail_result = (CommandParseResult) {
+        .has_value = false,
+        .tail = source,
+    };
+
+    auto command = (Command) {.type = COMMAND_TYPE_REPEAT};
+    auto count_result = parse_number(source, &command.count);
+
+    if (!count_result.has_value) {
+        return fail_result;
+    }
+
+    command.content = count_result.value;
+
+    auto body_str = str_trim_start(count_result.tail);
+
+    if (body_str.len == count_result.tail.len) {
+        return fail_result;
+    }
+
+    auto block_result = parse_prefix(body_str, Str("{"));
+
+    if (block_result.has_value) {
+        return (CommandParseResult) {
+            .has_value = true,
+            .value = command,
+            .tail = block_result.tail,
+        };
+    }
+
+    auto body_result = command_parse(body_str);
+    auto body = &body_result.value;
+
+    // Blocks can not be opened or closed by a repeated command
+    if (!body_result.has_value || COMMAND_TYPE_END == body->type ||
+        COMMAND_TYPE_DEF == body->type ||
+        (COMMAND_TYPE_REPEAT == body->type && 0 == body->body.len))
+    {
+        return fail_result;
+    }
+
+    command.body =
+        str_slice(body_str, 0, body_str.len - body_result.tail.len);
+
+    return (CommandParseResult) {
+        .has_value = true,
+        .value = command,
+        .tail = body_result.tail,
+    };
+}
+
+/// Parses `<name> {` of `def`
+static CommandParseResult command_parse_def(Str source) {
+    auto fail_result = (CommandParseResult) {
+        .has_value = false,
+        .tail = source,
+    };
+
+    auto name_result = parse_function_name(source);
+
+    if (!name_result.has_value) {
+        return fail_result;
+    }
+
+    auto block_result =
+        parse_prefix(str_trim_start(name_result.tail), Str("{"));
+
+    if (!block_result.has_value) {
+        return fail_result;
+    }
+
+    return (CommandParseResult) {
+        .has_value = true,
+        .value =
+            (Command) {
+                .content = name_result.value,
+                .type = COMMAND_TYPE_DEF,
+            },
+        .tail = block_result.tail,
+    };
+}
+
+/// Parses `<function_name> <path> <path>` of `compare`
+static CommandParseResult command_parse_compare(Str source) {
+    auto fail_result = (CommandParseResult) {
+        .has_value = false,
+        .tail = source,
+    };
+
+    auto name_result = parse_function_name(source);
+
+    if (!name_result.has_value) {
+        return fail_result;
+    }
+
+    auto baseline_str = str_trim_start(name_result.tail);
+
+    // Should trim at least one whitespace
+    if (baseline_str.len == name_result.tail.len) {
+        return fail_result;
+    }
+
+    auto baseline_result = parse_path(baseline_str);
+
+    if (!baseline_result.has_value) {
+        return fail_result;
+    }
+
+    auto candidate_str = str_trim_start(baseline_result.tail);
+
+    if (candidate_str.len == baseline_result.tail.len) {
+        return fail_result;
+    }
+
+    auto candidate_result = parse_path(candidate_str);
+
+    if (!candidate_result.has_value) {
+        return fail_result;
+    }
+
+    return (CommandParseResult) {
+        .has_value = true,
+        .value =
+            (Command) {
+                .content = name_result.value,
+                .type = COMMAND_TYPE_COMPARE,
+                .baseline_path = baseline_result.value,
+                .candidate_path = candidate_result.value,
+            },
+        .tail = candidate_result.tail,
+    };
+}
+
 CommandParseResult command_parse(Str source) {
+    auto end_result = parse_prefix(source, Str("}"));
+
+    if (end_result.has_value) {
+        return (CommandParseResult) {
+            .has_value = true,
+            .value =
+                (Command) {
+                    .content = end_result.value,
+                    .type = COMMAND_TYPE_END,
+                },
+            .tail = end_result.tail,
+        };
+    }
+
+    auto repeat_result = parse_prefix(source, Str("repeat"));
+
+    if (repeat_result.has_value) {
+        auto count_str = str_trim_start(repeat_result.tail);
+
+        // Should trim at least one whitespace
+        if (count_str.len == repeat_result.tail.len) {
+            return (CommandParseResult) {
+                .has_value = false,
+                .tail = source,
+            };
+        }
+
+        auto result = command_parse_repeat(count_str);
+
+        if (!result.has_value) {
+            result.tail = source;
+        }
+
+        return result;
+    }
+
+    auto def_result = parse_prefix(source, Str("def"));
+
+    if (def_result.has_value) {
+        auto name_str = str_trim_start(def_result.tail);
+
+        // Should trim at least one whitespace
+        if (name_str.len == def_result.tail.len) {
+            return (CommandParseResult) {
+                .has_value = false,
+                .tail = source,
+            };
+        }
+
+        auto result = command_parse_def(name_str);
+
+        if (!result.has_value) {
+            result.tail = source;
+        }
+
+        return result;
+    }
+
+    auto compare_result = parse_prefix(source, Str("compare"));
+
+    if (compare_result.has_value) {
+        auto content_str = str_trim_start(compare_result.tail);
+
+        // Should trim at least one whitespace
+        if (content_str.len == compare_result.tail.len) {
+            return (CommandParseResult) {
+                .has_value = false,
+                .tail = source,
+            };
+        }
+
+        auto result = command_parse_compare(content_str);
+
+        if (!result.has_value) {
+            result.tail = source;
+        }
+
+        return result;
+    }
+
     auto command_result = parse_prefix(source, Str("use"));
     auto command_type = (CommandType) {};
 
@@ -115,10 +717,25 @@ CommandParseResult command_parse(Str source) {
         if (command_result.has_value) {
             command_type = COMMAND_TYPE_CALL;
         } else {
-            return (CommandParseResult) {
-                .has_value = false,
-                .tail = source,
-            };
+            command_result = parse_prefix(source, Str("bench"));
+            command_type = COMMAND_TYPE_BENCH;
+
+            if (!command_result.has_value) {
+                command_result = parse_prefix(source, Str("expect"));
+                command_type = COMMAND_TYPE_EXPECT;
+            }
+
+            if (!command_result.has_value) {
+                command_result = parse_prefix(source, Str("run"));
+                command_type = COMMAND_TYPE_RUN;
+            }
+
+            if (!command_result.has_value) {
+                return (CommandParseResult) {
+                    .has_value = false,
+                    .tail = source,
+                };
+            }
         }
     }
 
@@ -139,8 +756,20 @@ CommandParseResult command_parse(Str source) {
         content_result = parse_path(content_str);
         break;
     case COMMAND_TYPE_CALL:
+    case COMMAND_TYPE_BENCH:
+        content_result = parse_qualified_name(content_str);
+        break;
+    case COMMAND_TYPE_EXPECT:
+        content_result = parse_hash(content_str);
+        break;
+    case COMMAND_TYPE_RUN:
         content_result = parse_function_name(content_str);
         break;
+    case COMMAND_TYPE_COMPARE:
+    case COMMAND_TYPE_REPEAT:
+    case COMMAND_TYPE_END:
+    case COMMAND_TYPE_DEF:
+        break;
     }
 
     if (!content_result.has_value) {
@@ -150,13 +779,51 @@ CommandParseResult command_parse(Str source) {
         };
     }
 
+    auto command = (Command) {
+        .content = content_result.value,
+        .type = command_type,
+    };
+
+    switch (command_type) {
+    case COMMAND_TYPE_USE:
+        return command_parse_use_alias(command, content_result.tail);
+    case COMMAND_TYPE_CALL:
+    case COMMAND_TYPE_BENCH: {
+        auto alias_result = parse_function_name(command.content);
+
+        if (alias_result.tail.len != 0) {
+            command.alias = alias_result.value;
+        }
+    } break;
+    case COMMAND_TYPE_COMPARE:
+    case COMMAND_TYPE_EXPECT:
+    case COMMAND_TYPE_REPEAT:
+    case COMMAND_TYPE_END:
+    case COMMAND_TYPE_DEF:
+    case COMMAND_TYPE_RUN:
+        break;
+    }
+
+    if (COMMAND_TYPE_CALL == command_type &&
+        str_starts_with(content_result.tail, Str("(")))
+    {
+        auto call = (TypedCall) {};
+        auto signature_result = parse_typed_call(content_result.tail, &call);
+
+        if (!signature_result.has_value) {
+            return (CommandParseResult) {
+                .has_value = false,
+                .tail = source,
+            };
+        }
+
+        command.signature = signature_result.value;
+        content_result.tail = signature_result.tail;
+    }
+
     return (CommandParseResult) {
         .has_value = true,
-        .value =
-            (Command) {
-                .content = content_result.value,
-                .type = command_type,
-            },
+        .value = command,
         .tail = content_result.tail,
     };
 }
@@ -2,6 +2,7 @@
 #define _SOTEST_PARSE_H
 
 #include "str.h"
+#include "typed.h"
 
 #include <stdint.h>
 
@@ -20,4 +21,27 @@ ParseResult parse_comment(Str source);
 
 ParseResult parse_function_name(Str source);
 
+/// Parses `<alias>.<function_name>` or a plain `<function_name>`
+ParseResult parse_qualified_name(Str source);
+
+/// Parses a 64-bit hash written as 1 to 16 hex digits
+ParseResult parse_hash(Str source);
+
+/// Parses a decimal number which fits into `size_t`, stored into `number`
+ParseResult parse_number(Str source, size_t* number);
+
+/// Parses a type of typed calls other than `void`, e.g. `i64`, stored into
+/// `type`
+ParseResult parse_type(Str source, JitType* type);
+
+/// Parses a literal of the type, stored into `value`: a decimal or `0x` hex
+/// integer which fits into the type, or a floating-point number for `f32`
+/// and `f64`
+ParseResult parse_typed_value(Str source, JitType type, JitValue* value);
+
+/// Parses `(<type> <value>, ...)` optionally followed by `-> <type>` and
+/// `= <value>`, stored into `call`. The arguments must fit into the SysV
+/// argument registers.
+ParseResult parse_typed_call(Str source, TypedCall* call);
+
 #endif  // !_SOTEST_PARSE_H
@@ -0,0 +1,119 @@
+#include "prefetch.h"
+#include "interpreter.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define K String
+#define V bool
+#define SNAME PrefetchedSet
+#define PFX prefetched_set
+
+#include <cmc/hashmap.h>
+
+static int local_string_compare(String a, String b) {
+    return string_compare(&a, &b);
+}
+
+static void local_string_free(String string) { string_free(&string); }
+
+static size_t local_string_hash(String string) { return string_hash(&string); }
+
+struct PrefetchedSet_fkey PREFETCHED_SET_FKEY = {
+    .cmp = local_string_compare,
+    .free = local_string_free,
+    .hash = local_string_hash,
+};
+
+struct PrefetchedSet_fval PREFETCHED_SET_FVAL = {};
+
+bool prefetch_file(Str path) {
+    auto path_copy = STRING_EMPTY;
+    string_append(&path_copy, path);
+
+    int fd = open(path_copy.str.ptr, O_RDONLY | O_CLOEXEC);
+    string_free(&path_copy);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    // Zero length means 'up to the end of the file'. The advice only starts
+    // asynchronous read-ahead, so this does not wait for the disk.
+    bool success = 0 == posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+
+    close(fd);
+
+    return success;
+}
+
+static void* prefetcher_run(void* argument) {
+    Prefetcher* self = argument;
+
+    auto input = fopen(self->script_path.str.ptr, "rb");
+
+    if (nullptr == input) {
+        return nullptr;
+    }
+
+    auto hinted =
+        prefetched_set_new(16, 0.5, &PREFETCHED_SET_FKEY, &PREFETCHED_SET_FVAL);
+    auto buf = STRING_EMPTY;
+
+    while (!atomic_load_explicit(&self->should_stop, memory_order_relaxed)) {
+        string_clear(&buf);
+
+        if (READLINE_EOF == string_readline(&buf, input)) {
+            break;
+        }
+
+        auto result = command_line_parse(str_trim(buf.str));
+
+        if (!result.has_value || !result.value.has_command ||
+            COMMAND_TYPE_USE != result.value.command.type)
+        {
+            continue;
+        }
+
+        auto path = result.value.command.content;
+
+        if (prefetched_set_contains(hinted, (String) {.str = path})) {
+            continue;
+        }
+
+        auto path_copy = STRING_EMPTY;
+        string_append(&path_copy, path);
+        prefetched_set_insert(hinted, path_copy, true);
+
+        prefetch_file(path);
+    }
+
+    string_free(&buf);
+    prefetched_set_free(hinted);
+    fclose(input);
+
+    return nullptr;
+}
+
+void prefetcher_start(Prefetcher* self, Str script_path) {
+    *self = (Prefetcher) {};
+    string_append(&self->script_path, script_path);
+
+    if (0 != pthread_create(&self->thread, nullptr, prefetcher_run, self)) {
+        string_free(&self->script_path);
+        return;
+    }
+
+    self->is_running = true;
+}
+
+void prefetcher_stop(Prefetcher* self) {
+    if (self->is_running) {
+        atomic_store_explicit(&self->should_stop, true, memory_order_relaxed);
+        pthread_join(self->thread, nullptr);
+        self->is_running = false;
+    }
+
+    string_free(&self->script_path);
+}
@@ -0,0 +1,36 @@
+#ifndef _SOTEST_PREFETCH_H
+#define _SOTEST_PREFETCH_H
+
+#include "str.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+/// Background reader that walks a script ahead of the interpreter and asks
+/// the kernel to page in every library named by a `use` command, so the
+/// `dlopen` in `executor_load_library` mostly hits the page cache.
+typedef struct Prefetcher {
+    pthread_t thread;
+    /// Nul-terminated path to the script being read ahead
+    String script_path;
+    bool is_running;
+    /// Set by the interpreter to stop reading ahead early
+    atomic_bool should_stop;
+} Prefetcher;
+
+/// Spawns the read-ahead thread for a script file. `self` should outlive the
+/// thread. On failure the prefetcher is left not running, the interpreter
+/// works the same way without it.
+void prefetcher_start(Prefetcher* self, Str script_path);
+
+/// Stops reading ahead and waits for the thread to finish
+void prefetcher_stop(Prefetcher* self);
+
+/// Hints the kernel that the whole file at `path` will be read soon
+///
+/// # Error
+///
+/// Returns `false` if the file can not be opened or advised
+bool prefetch_file(Str path);
+
+#endif  // !_SOTEST_PREFETCH_H
@@ -0,0 +1,10 @@
+#include "probes.h"
+
+PROBE_DEFINE(line_read);
+PROBE_DEFINE(command_parsed);
+PROBE_DEFINE(library_load_start);
+PROBE_DEFINE(library_load_end);
+PROBE_DEFINE(symbol_cache_hit);
+PROBE_DEFINE(symbol_cache_miss);
+PROBE_DEFINE(call_entry);
+PROBE_DEFINE(call_exit);
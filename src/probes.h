@@ -0,0 +1,120 @@
+#ifndef _SOTEST_PROBES_H
+#define _SOTEST_PROBES_H
+
+#include <stdint.h>
+#include <time.h>
+
+// USDT probes for `bpftrace`, `perf probe` and SystemTap, written in the
+// `.note.stapsdt` format of `<sys/sdt.h>` without depending on it. A probe
+// site is a single `nop` while no tracer is attached. Arguments which cost
+// something to compute (durations) are guarded by `PROBE_IS_ENABLED`, the
+// semaphore tracers raise when they attach. Configure with
+// `-DSOTEST_PROBES=OFF` to compile them out entirely.
+//
+// All arguments are 8 bytes wide, names are passed as pointer and length:
+//
+//     bpftrace -e 'usdt:build/sotest:sotest:call_exit
+//         { @[str(arg0, arg1)] = hist(arg2); }' -c 'build/sotest script.sc'
+
+#if !defined(SOTEST_NO_PROBES) && defined(__ELF__) &&                          \
+    (defined(__x86_64__) || defined(__aarch64__))
+#define PROBES_ENABLED 1
+#else
+#define PROBES_ENABLED 0
+#endif
+
+#define PROBE_SEMAPHORE(name) sotest_##name##_semaphore
+
+/// Semaphores live in `.probes`, where tracers expect them. They are kept
+/// when probes are compiled out, unused.
+#define PROBE_DEFINE(name)                                                     \
+    __attribute__((section(".probes"))) volatile unsigned short                \
+        PROBE_SEMAPHORE(name) = 0
+
+#define PROBE_DECLARE(name) extern volatile unsigned short PROBE_SEMAPHORE(name)
+
+#if PROBES_ENABLED
+
+/// Note of a probe site: its address, the base to relocate it against, the
+/// semaphore, the provider, the name and the locations of the arguments
+#define PROBE_NOTE(name, args)                                                 \
+    "990: nop\n"                                                               \
+    ".pushsection .note.stapsdt, \"?\", \"note\"\n"                            \
+    ".balign 4\n"                                                              \
+    ".4byte 992f - 991f, 994f - 993f, 3\n"                                     \
+    "991: .asciz \"stapsdt\"\n"                                                \
+    "992: .balign 4\n"                                                         \
+    "993: .8byte 990b\n"                                                       \
+    ".8byte _.stapsdt.base\n"                                                  \
+    ".8byte sotest_" #name "_semaphore\n"                                      \
+    ".asciz \"sotest\"\n"                                                      \
+    ".asciz \"" #name "\"\n"                                                   \
+    ".asciz \"" args "\"\n"                                                    \
+    "994: .balign 4\n"                                                         \
+    ".popsection\n"                                                            \
+    ".ifndef _.stapsdt.base\n"                                                 \
+    ".pushsection .stapsdt.base, \"aG\", \"progbits\", .stapsdt.base, "        \
+    "comdat\n"                                                                 \
+    ".weak _.stapsdt.base\n"                                                   \
+    ".hidden _.stapsdt.base\n"                                                 \
+    "_.stapsdt.base: .space 1\n"                                               \
+    ".size _.stapsdt.base, 1\n"                                                \
+    ".popsection\n"                                                            \
+    ".endif\n"
+
+/// A tracer is attached to the probe
+#define PROBE_IS_ENABLED(name) __builtin_expect(0 != PROBE_SEMAPHORE(name), 0)
+
+#define PROBE2(name, a, b)                                                     \
+    __asm__ volatile(PROBE_NOTE(name, "8@%0 8@%1")                             \
+                     :                                                         \
+                     : "nor"((uintptr_t) (a)), "nor"((uintptr_t) (b)))
+
+#define PROBE3(name, a, b, c)                                                  \
+    __asm__ volatile(PROBE_NOTE(name, "8@%0 8@%1 8@%2")                        \
+                     :                                                         \
+                     : "nor"((uintptr_t) (a)), "nor"((uintptr_t) (b)),         \
+                       "nor"((uintptr_t) (c)))
+
+#define PROBE4(name, a, b, c, d)                                               \
+    __asm__ volatile(PROBE_NOTE(name, "8@%0 8@%1 8@%2 8@%3")                   \
+                     :                                                         \
+                     : "nor"((uintptr_t) (a)), "nor"((uintptr_t) (b)),         \
+                       "nor"((uintptr_t) (c)), "nor"((uintptr_t) (d)))
+
+#else
+
+#define PROBE_IS_ENABLED(name) false
+#define PROBE2(name, a, b) ((void) (a), (void) (b))
+#define PROBE3(name, a, b, c) ((void) (a), (void) (b), (void) (c))
+#define PROBE4(name, a, b, c, d)                                               \
+    ((void) (a), (void) (b), (void) (c), (void) (d))
+
+#endif
+
+/// `line_number`, `line`, `line_len`
+PROBE_DECLARE(line_read);
+/// `line_number`, `CommandType` or -1 if the line has none, `duration_ns`
+PROBE_DECLARE(command_parsed);
+/// `path`, `path_len`
+PROBE_DECLARE(library_load_start);
+/// `path`, `path_len`, `ExecutorResult.status`, `duration_ns`
+PROBE_DECLARE(library_load_end);
+/// `name`, `name_len`
+PROBE_DECLARE(symbol_cache_hit);
+/// `name`, `name_len`
+PROBE_DECLARE(symbol_cache_miss);
+/// `name`, `name_len`
+PROBE_DECLARE(call_entry);
+/// `name`, `name_len`, `duration_ns`
+PROBE_DECLARE(call_exit);
+
+/// Clock of the probe durations
+inline static uint64_t probe_now_ns() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (uint64_t) time.tv_sec * 1000000000 + (uint64_t) time.tv_nsec;
+}
+
+#endif  // !_SOTEST_PROBES_H
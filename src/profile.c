@@ -0,0 +1,338 @@
+#define _GNU_SOURCE
+
+#include "profile.h"
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#define CMC_EXT_ITER
+
+#define K String
+#define V size_t
+#define SNAME FoldMap
+#define PFX fold_map
+
+#include <cmc/hashmap.h>
+
+// Named only by newer C libraries
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+static int local_string_compare(String a, String b) {
+    return string_compare(&a, &b);
+}
+
+static void local_string_free(String string) { string_free(&string); }
+
+static size_t local_string_hash(String string) { return string_hash(&string); }
+
+struct FoldMap_fkey FOLD_MAP_FKEY = {
+    .cmp = local_string_compare,
+    .free = local_string_free,
+    .hash = local_string_hash,
+};
+
+struct FoldMap_fval FOLD_MAP_FVAL = {};
+
+/// Signal handlers get no argument of their own
+static Profiler* ACTIVE_PROFILER = nullptr;
+
+/// Walks the frame pointer chain from the interrupted context. Only reads
+/// inside the stack bounds, a library without frame pointers ends the walk
+/// early instead of faulting.
+static size_t profiler_walk(
+    Profiler const* self, ucontext_t const* context, void** pcs
+) {
+#if defined(__x86_64__)
+    auto pc = (uintptr_t) context->uc_mcontext.gregs[REG_RIP];
+    auto fp = (uintptr_t) context->uc_mcontext.gregs[REG_RBP];
+#elif defined(__aarch64__)
+    auto pc = (uintptr_t) context->uc_mcontext.pc;
+    auto fp = (uintptr_t) context->uc_mcontext.regs[29];
+#else
+    (void) self;
+    (void) context;
+    (void) pcs;
+    return 0;
+#endif
+
+#if defined(__x86_64__) || defined(__aarch64__)
+    pcs[0] = (void*) pc;
+    size_t depth = 1;
+
+    while (depth < PROFILE_MAX_DEPTH && fp >= self->stack_low &&
+           fp <= self->stack_high - 2 * sizeof(uintptr_t) &&
+           0 == fp % sizeof(uintptr_t))
+    {
+        auto frame = (uintptr_t const*) fp;
+        auto next_fp = frame[0];
+        auto return_address = frame[1];
+
+        if (0 == return_address) {
+            break;
+        }
+
+        // Inside the call instruction, so the caller's symbol is found even
+        // if the call was the last instruction of its function
+        pcs[depth] = (void*) (return_address - 1);
+        depth += 1;
+
+        // The stack grows down, callers' frames are above
+        if (next_fp <= fp) {
+            break;
+        }
+
+        fp = next_fp;
+    }
+
+    return depth;
+#endif
+}
+
+static void profiler_handle_signal(int signal, siginfo_t* info, void* context) {
+    (void) signal;
+    (void) info;
+
+    auto self = ACTIVE_PROFILER;
+
+    if (nullptr == self || !self->is_sampling) {
+        return;
+    }
+
+    if (self->n_samples == PROFILE_MAX_SAMPLES) {
+        self->n_dropped += 1;
+        return;
+    }
+
+    auto sample = &self->samples[self->n_samples];
+    sample->depth = profiler_walk(self, context, sample->pcs);
+    self->n_samples += 1;
+}
+
+bool profiler_start(Profiler* self, FILE* output, size_t rate) {
+    if (nullptr != ACTIVE_PROFILER) {
+        errno = EBUSY;
+        return false;
+    }
+
+    *self = (Profiler) {.output = output};
+
+    pthread_attr_t attributes;
+    void* stack = nullptr;
+    size_t stack_size = 0;
+
+    if (0 != pthread_getattr_np(pthread_self(), &attributes)) {
+        return false;
+    }
+
+    pthread_attr_getstack(&attributes, &stack, &stack_size);
+    pthread_attr_destroy(&attributes);
+
+    self->stack_low = (uintptr_t) stack;
+    self->stack_high = (uintptr_t) stack + stack_size;
+
+    Dl_info info;
+
+    if (0 != dladdr((void*) profiler_start, &info)) {
+        self->executable_base = info.dli_fbase;
+    }
+
+    // Only the interpreter thread is sampled, that is where calls run
+    auto event = (struct sigevent) {
+        .sigev_notify = SIGEV_THREAD_ID,
+        .sigev_signo = SIGPROF,
+    };
+    event.sigev_notify_thread_id = gettid();
+
+    if (0 != timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &self->timer)) {
+        return false;
+    }
+
+    struct sigaction action = {};
+    action.sa_sigaction = profiler_handle_signal;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    if (0 != sigaction(SIGPROF, &action, nullptr)) {
+        auto error = errno;
+        timer_delete(self->timer);
+        errno = error;
+
+        return false;
+    }
+
+    auto period_ns = 1000000000 / (0 == rate ? PROFILE_DEFAULT_RATE : rate);
+    auto period = (struct timespec) {
+        .tv_sec = (time_t) (period_ns / 1000000000),
+        .tv_nsec = (long) (period_ns % 1000000000),
+    };
+
+    self->interval = (struct itimerspec) {
+        .it_interval = period,
+        .it_value = period,
+    };
+    self->samples = malloc(sizeof(*self->samples) * PROFILE_MAX_SAMPLES);
+    self->folded = fold_map_new(256, 0.5, &FOLD_MAP_FKEY, &FOLD_MAP_FVAL);
+    self->is_active = true;
+    ACTIVE_PROFILER = self;
+
+    return true;
+}
+
+void profiler_begin(Profiler* self, size_t line_number) {
+    if (!self->is_active) {
+        return;
+    }
+
+    self->line_number = line_number;
+    self->n_samples = 0;
+    self->is_sampling = true;
+    timer_settime(self->timer, 0, &self->interval, nullptr);
+}
+
+/// Appends the name of the frame, `;` separates frames in the folded format
+static void profiler_append_frame(String* stack, Dl_info const* info) {
+    string_append(stack, Str(";"));
+
+    if (nullptr != info->dli_sname) {
+        string_append(stack, str_from_ptr((char*) info->dli_sname));
+        return;
+    }
+
+    auto name = nullptr == info->dli_fname ? "" : info->dli_fname;
+    auto basename = strrchr(name, '/');
+
+    if (nullptr != basename) {
+        name = basename + 1;
+    }
+
+    string_append(stack, Str("["));
+    string_append(stack, str_from_ptr((char*) name));
+    string_append(stack, Str("]"));
+}
+
+/// Folds a sample into the map, outermost library frame first
+static void profiler_fold(
+    Profiler* self, ProfileSample const* sample, String* stack
+) {
+    string_clear(stack);
+
+    char root[32];
+    snprintf(root, sizeof(root), "line %zu", self->line_number);
+    string_append(stack, str_from_ptr(root));
+
+    Dl_info infos[PROFILE_MAX_DEPTH];
+    bool is_found[PROFILE_MAX_DEPTH];
+    size_t depth = 0;
+
+    // Frames of the interpreter itself end the library part of the stack
+    for (; depth < sample->depth; ++depth) {
+        is_found[depth] = 0 != dladdr(sample->pcs[depth], &infos[depth]);
+
+        if (is_found[depth] &&
+            infos[depth].dli_fbase == self->executable_base)
+        {
+            break;
+        }
+    }
+
+    if (0 == depth) {
+        string_append(stack, Str(";[interpreter]"));
+    }
+
+    for (size_t i = depth; i-- > 0;) {
+        if (is_found[i]) {
+            profiler_append_frame(stack, &infos[i]);
+        } else {
+            // Anonymous code, e.g. thunks and stubs from `jit_compile`
+            string_append(stack, Str(";[jit]"));
+        }
+    }
+
+    auto count = fold_map_get_ref(self->folded, *stack);
+
+    if (nullptr != count) {
+        *count += 1;
+        return;
+    }
+
+    auto key = STRING_EMPTY;
+    string_append(&key, stack->str);
+    fold_map_insert(self->folded, key, 1);
+}
+
+void profiler_end(Profiler* self) {
+    if (!self->is_active) {
+        return;
+    }
+
+    self->is_sampling = false;
+    timer_settime(self->timer, 0, &(struct itimerspec) {}, nullptr);
+
+    auto stack = STRING_EMPTY;
+
+    for (size_t i = 0; i < self->n_samples; ++i) {
+        profiler_fold(self, &self->samples[i], &stack);
+    }
+
+    self->n_samples = 0;
+    string_free(&stack);
+}
+
+typedef struct FoldedStack {
+    Str stack;
+    size_t count;
+} FoldedStack;
+
+static int compare_folded_stacks(void const* a, void const* b) {
+    auto x = ((FoldedStack const*) a)->stack;
+    auto y = ((FoldedStack const*) b)->stack;
+
+    return str_compare(&x, &y);
+}
+
+size_t profiler_stop(Profiler* self) {
+    if (!self->is_active) {
+        return 0;
+    }
+
+    timer_delete(self->timer);
+    signal(SIGPROF, SIG_IGN);
+    ACTIVE_PROFILER = nullptr;
+
+    auto n_stacks = fold_map_count(self->folded);
+    auto stacks = (FoldedStack*) malloc(sizeof(FoldedStack) * (n_stacks + 1));
+    size_t n_written = 0;
+
+    for (auto it = fold_map_iter_start(self->folded);
+         !fold_map_iter_at_end(&it); fold_map_iter_next(&it))
+    {
+        stacks[n_written] = (FoldedStack) {
+            .stack = fold_map_iter_key(&it).str,
+            .count = fold_map_iter_value(&it),
+        };
+        n_written += 1;
+    }
+
+    qsort(stacks, n_written, sizeof(*stacks), compare_folded_stacks);
+
+    for (size_t i = 0; i < n_written; ++i) {
+        str_write(stacks[i].stack, self->output);
+        fprintf(self->output, " %zu\n", stacks[i].count);
+    }
+
+    free(stacks);
+    fold_map_free(self->folded);
+    free(self->samples);
+
+    auto n_dropped = self->n_dropped;
+    *self = (Profiler) {};
+
+    return n_dropped;
+}
@@ -0,0 +1,77 @@
+#ifndef _SOTEST_PROFILE_H
+#define _SOTEST_PROFILE_H
+
+#include "str.h"
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/// Deepest stack recorded per sample, the outermost frames are cut
+size_t constexpr PROFILE_MAX_DEPTH = 64;
+/// Samples buffered per command, later ones are dropped and counted
+size_t constexpr PROFILE_MAX_SAMPLES = 4096;
+/// Samples per second of CPU time, a prime so that sampling does not run in
+/// lockstep with periodic work
+size_t constexpr PROFILE_DEFAULT_RATE = 997;
+
+/// Stack captured by the signal handler, the interrupted instruction first
+typedef struct ProfileSample {
+    void* pcs[PROFILE_MAX_DEPTH];
+    size_t depth;
+} ProfileSample;
+
+/// Samples the stack of the interpreter thread on `SIGPROF` while commands
+/// run, and folds the samples into one line per distinct stack, rooted at
+/// the script line: `line 12;outer;inner 34`, the format of
+/// `flamegraph.pl`. Frames are found by walking frame pointers, so libraries
+/// built with `-fomit-frame-pointer` (the default of `-O2`) show only the
+/// interrupted function and the callers which keep a frame.
+typedef struct Profiler {
+    bool is_active;
+    timer_t timer;
+    struct itimerspec interval;
+    /// Set only while a command runs, the handler ignores late signals
+    volatile sig_atomic_t is_sampling;
+    ProfileSample* samples;
+    size_t n_samples;
+    size_t n_dropped;
+    size_t line_number;
+    /// Bounds of the interpreter thread's stack, frame pointers outside of
+    /// them end the walk
+    uintptr_t stack_low;
+    uintptr_t stack_high;
+    /// Base of the interpreter's own executable, its frames are left out
+    void* executable_base;
+    /// Sample counts by folded stack
+    struct FoldMap* folded;
+    FILE* output;
+} Profiler;
+
+/// Sets up a CPU-time timer of the calling thread firing `rate` times per
+/// second, armed only between `profiler_begin` and `profiler_end`. The
+/// folded stacks are written to `output` by `profiler_stop`.
+///
+/// # Error
+///
+/// Returns `false` and sets `errno` if the timer or the signal handler can
+/// not be set up, or another profiler is active
+bool profiler_start(Profiler* self, FILE* output, size_t rate);
+
+/// Starts sampling a command
+void profiler_begin(Profiler* self, size_t line_number);
+
+/// Stops sampling and folds the samples of the command. Symbols are looked up
+/// with `dladdr`, so only exported functions have names, other frames are
+/// named after their library, e.g. `[libfoo.so]`.
+void profiler_end(Profiler* self);
+
+/// Writes the folded stacks sorted by stack and removes the timer
+///
+/// # Return
+///
+/// Number of samples dropped because a command filled the buffer
+size_t profiler_stop(Profiler* self);
+
+#endif  // !_SOTEST_PROFILE_H
@@ -0,0 +1,506 @@
+#include "program.h"
+
+#include "parse.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void program_push(Program* self, ProgramOp op) {
+    if (0 == self->cap) {
+        self->cap = 16;
+        self->ptr = malloc(sizeof(*self->ptr) * self->cap);
+    } else if (self->len == self->cap) {
+        self->cap += self->cap / 2;
+        self->ptr = realloc(self->ptr, sizeof(*self->ptr) * self->cap);
+    }
+
+    self->ptr[self->len] = op;
+    self->len += 1;
+}
+
+static void program_blocks_push(ProgramBlocks* self, size_t index) {
+    if (0 == self->cap) {
+        self->cap = 4;
+        self->ptr = malloc(sizeof(*self->ptr) * self->cap);
+    } else if (self->len == self->cap) {
+        self->cap += self->cap / 2;
+        self->ptr = realloc(self->ptr, sizeof(*self->ptr) * self->cap);
+    }
+
+    self->ptr[self->len] = index;
+    self->len += 1;
+}
+
+static void program_thunks_push(ProgramThunks* self, ProgramThunk thunk) {
+    if (0 == self->cap) {
+        self->cap = 4;
+        self->ptr = malloc(sizeof(*self->ptr) * self->cap);
+    } else if (self->len == self->cap) {
+        self->cap += self->cap / 2;
+        self->ptr = realloc(self->ptr, sizeof(*self->ptr) * self->cap);
+    }
+
+    self->ptr[self->len] = thunk;
+    self->len += 1;
+}
+
+/// Thunk compiled earlier for the same calls and count, `nullptr` if none.
+/// A thunk depends on the addresses only, so it stays valid across reloads.
+static ProgramThunk const* program_find_thunk(
+    ProgramThunks const* self, JitFunction const* functions, size_t len,
+    size_t count
+) {
+    for (size_t i = 0; i < self->len; ++i) {
+        auto thunk = &self->ptr[i];
+
+        if (len == thunk->len && count == thunk->count &&
+            0 == memcmp(functions, thunk->functions, sizeof(*functions) * len))
+        {
+            return thunk;
+        }
+    }
+
+    return nullptr;
+}
+
+/// Compiles the loop of a `repeat` whose body is made of calls only, or
+/// reuses the thunk of the same loop
+static void program_compile_block(Program* self, size_t index) {
+    auto op = &self->ptr[index];
+
+    for (size_t i = 1; i <= op->body_len; ++i) {
+        if (PROGRAM_OP_CALL != op[i].type) {
+            return;
+        }
+    }
+
+    auto functions = (JitFunction*) malloc(sizeof(JitFunction) * op->body_len);
+
+    for (size_t i = 0; i < op->body_len; ++i) {
+        functions[i] = op[i + 1].function;
+    }
+
+    auto cached =
+        program_find_thunk(&self->thunks, functions, op->body_len, op->count);
+
+    if (nullptr != cached) {
+        op->jit = cached->jit;
+        free(functions);
+        return;
+    }
+
+    op->jit = jit_compile(functions, op->body_len, op->count);
+
+    if (nullptr == op->jit.entry) {
+        free(functions);
+        return;
+    }
+
+    program_thunks_push(
+        &self->thunks, (ProgramThunk) {
+                           .functions = functions,
+                           .len = op->body_len,
+                           .count = op->count,
+                           .jit = op->jit,
+                       }
+    );
+}
+
+static void program_close_block(Program* self, Executor const* executor) {
+    self->open.len -= 1;
+
+    auto index = self->open.ptr[self->open.len];
+    self->ptr[index].body_len = self->len - index - 1;
+
+    // Monitored calls are timed, measured ones sampled, a compiled loop
+    // would not be used
+    if (!executor->options.is_jit_disabled &&
+        nullptr == executor->options.monitor &&
+        nullptr == executor->options.footprint)
+    {
+        program_compile_block(self, index);
+    }
+}
+
+static ProgramAddResult program_fail(
+    uint8_t status, Command const* command, Str error
+) {
+    return (ProgramAddResult) {
+        .status = status,
+        .command = *command,
+        .result = {.dl_error = error},
+    };
+}
+
+/// Adds a typed call, resolved by `program_add`
+static ProgramAddResult program_add_typed_call(
+    Program* self, Executor* executor, Command const* command,
+    ExecutorResolveResult const* resolved
+) {
+    auto call = (TypedCall*) malloc(sizeof(TypedCall));
+
+    // The parser already validated the signature
+    parse_typed_call(command->signature, call);
+
+    if (call->has_expected) {
+        free(call);
+
+        return program_fail(
+            PROGRAM_NOT_ALLOWED, command,
+            Str("typed calls with an expected result can not be repeated")
+        );
+    }
+
+    auto stub = executor_resolve_stub(executor, &call->signature);
+
+    if (nullptr == stub) {
+        free(call);
+
+        return (ProgramAddResult) {
+            .status = PROGRAM_NOT_RESOLVED,
+            .command = *command,
+            .result =
+                {
+                    .status = EXECUTOR_STUB_FAILED,
+                    .dl_error = Str("can not compile a call stub, typed calls "
+                                    "need the JIT"),
+                },
+        };
+    }
+
+    program_push(
+        self, (ProgramOp) {
+                  .type = PROGRAM_OP_TYPED_CALL,
+                  .function = resolved->function,
+                  .stats = resolved->stats,
+                  .slot = resolved->slot,
+                  .typed_call = call,
+                  .stub = stub,
+              }
+    );
+
+    return (ProgramAddResult) {.status = PROGRAM_ADDED};
+}
+
+ProgramAddResult program_add(
+    Program* self, Executor* executor, Command const* command
+) {
+    self->monitor = executor->options.monitor;
+    self->footprint = executor->options.footprint;
+
+    switch (command->type) {
+    case COMMAND_TYPE_CALL: {
+        auto resolved =
+            0 == command->alias.len
+                ? executor_resolve_function(executor, command->content)
+                : executor_resolve_qualified_function(
+                      executor, command->content
+                  );
+
+        if (EXECUTOR_SUCCESS != resolved.result.status) {
+            return (ProgramAddResult) {
+                .status = PROGRAM_NOT_RESOLVED,
+                .command = *command,
+                .result = resolved.result,
+            };
+        }
+
+        if (0 != command->signature.len) {
+            return program_add_typed_call(
+                self, executor, command, &resolved
+            );
+        }
+
+        program_push(
+            self, (ProgramOp) {
+                      .type = PROGRAM_OP_CALL,
+                      .function = resolved.function,
+                      .stats = resolved.stats,
+                      .slot = resolved.slot,
+                  }
+        );
+    } break;
+    case COMMAND_TYPE_REPEAT: {
+        program_blocks_push(&self->open, self->len);
+        program_push(
+            self, (ProgramOp) {
+                      .type = PROGRAM_OP_REPEAT,
+                      .count = command->count,
+                  }
+        );
+
+        if (0 == command->body.len) {
+            break;
+        }
+
+        // The parser already validated the repeated command
+        auto body = command_parse(command->body).value;
+        auto result = program_add(self, executor, &body);
+        program_close_block(self, executor);
+
+        return result;
+    }
+    case COMMAND_TYPE_END:
+        if (!program_is_open(self)) {
+            return program_fail(
+                PROGRAM_UNEXPECTED_END, command,
+                Str("`}` without an open `repeat` block")
+            );
+        }
+
+        program_close_block(self, executor);
+        break;
+    case COMMAND_TYPE_RUN: {
+        auto procedure = executor_find_procedure(executor, command->content);
+
+        if (nullptr == procedure) {
+            return (ProgramAddResult) {
+                .status = PROGRAM_NOT_RESOLVED,
+                .command = *command,
+                .result =
+                    {
+                        .status = EXECUTOR_FIND_SYMBOL_FAILED,
+                        .dl_error = Str("no procedure defined with this name"),
+                    },
+            };
+        }
+
+        // No library is loaded while the program runs, it stays resolved
+        auto result = executor_resolve_procedure(executor, procedure);
+
+        program_push(
+            self, (ProgramOp) {
+                      .type = PROGRAM_OP_RUN,
+                      .procedure = procedure,
+                  }
+        );
+
+        if (EXECUTOR_SUCCESS != result.status) {
+            return (ProgramAddResult) {
+                .status = PROGRAM_NOT_RESOLVED,
+                .command = *command,
+                .result = result,
+            };
+        }
+    } break;
+    case COMMAND_TYPE_USE:
+    case COMMAND_TYPE_COMPARE:
+    case COMMAND_TYPE_BENCH:
+    case COMMAND_TYPE_EXPECT:
+    case COMMAND_TYPE_DEF:
+        return program_fail(
+            PROGRAM_NOT_ALLOWED, command,
+            Str("only `call`, `run` and `repeat` can be repeated")
+        );
+    }
+
+    return (ProgramAddResult) {.status = PROGRAM_ADDED};
+}
+
+static void program_run_ops(ProgramOp const* ops, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        auto op = &ops[i];
+
+        if (PROGRAM_OP_CALL == op->type) {
+            op->function();
+            op->stats->n_calls += 1;
+            continue;
+        }
+
+        if (PROGRAM_OP_RUN == op->type) {
+            procedure_call(op->procedure);
+            continue;
+        }
+
+        if (PROGRAM_OP_TYPED_CALL == op->type) {
+            JitValue result;
+            op->stub(op->function, op->typed_call->arguments, &result);
+            op->stats->n_calls += 1;
+            continue;
+        }
+
+        auto body = op + 1;
+
+        if (nullptr != op->jit.entry) {
+            auto start_cycles = cycles_now();
+            op->jit.entry();
+
+            // Only a loop of a single function tells its time
+            if (1 == op->body_len) {
+                call_stats_add_loop(
+                    body->stats, op->count, cycles_now() - start_cycles
+                );
+            } else {
+                for (size_t j = 1; j <= op->body_len; ++j) {
+                    op[j].stats->n_calls += op->count;
+                }
+            }
+
+            i += op->body_len;
+            continue;
+        }
+
+        // Repeating a single call is the common case of stress scripts, keep
+        // its loop free of dispatch
+        if (1 == op->body_len && PROGRAM_OP_CALL == body->type) {
+            auto function = body->function;
+            auto start_cycles = cycles_now();
+
+            for (size_t j = 0; j < op->count; ++j) {
+                function();
+            }
+
+            call_stats_add_loop(
+                body->stats, op->count, cycles_now() - start_cycles
+            );
+        } else if (1 == op->body_len && PROGRAM_OP_TYPED_CALL == body->type) {
+            auto stub = body->stub;
+            auto function = body->function;
+            auto arguments = body->typed_call->arguments;
+            JitValue result;
+            auto start_cycles = cycles_now();
+
+            for (size_t j = 0; j < op->count; ++j) {
+                stub(function, arguments, &result);
+            }
+
+            call_stats_add_loop(
+                body->stats, op->count, cycles_now() - start_cycles
+            );
+        } else if (0 != op->body_len) {
+            for (size_t j = 0; j < op->count; ++j) {
+                program_run_ops(body, op->body_len);
+            }
+        }
+
+        i += op->body_len;
+    }
+}
+
+/// Calls the function of a call op `count` times in chunks, each counted in
+/// the live stats. A chunk starting at a multiple of the period is sampled
+/// up to the next one, so a long `repeat` costs two samples per period.
+static void program_run_instrumented_call(
+    Program const* self, ProgramOp const* op, size_t count
+) {
+    auto monitor = self->monitor;
+    auto footprint = self->footprint;
+    auto stats = op->stats;
+    auto function = op->function;
+    JitValue result;
+
+    for (size_t done = 0; done < count;) {
+        auto chunk = count - done;
+
+        if (nullptr != monitor && chunk > MONITOR_CHUNK) {
+            chunk = MONITOR_CHUNK;
+        }
+
+        if (nullptr != footprint) {
+            auto to_period =
+                footprint->period - stats->n_calls % footprint->period;
+            chunk = chunk < to_period ? chunk : to_period;
+        }
+
+        FootprintSample before;
+        auto is_measured = footprint_begin(footprint, stats->n_calls, &before);
+        auto start_ns = nullptr == monitor ? 0 : monitor_now_ns();
+
+        if (PROGRAM_OP_CALL == op->type) {
+            for (size_t j = 0; j < chunk; ++j) {
+                function();
+            }
+        } else {
+            for (size_t j = 0; j < chunk; ++j) {
+                op->stub(function, op->typed_call->arguments, &result);
+            }
+        }
+
+        if (nullptr != monitor) {
+            monitor_count_calls(
+                monitor, op->slot, chunk, monitor_now_ns() - start_ns
+            );
+        }
+
+        stats->n_calls += chunk;
+
+        if (is_measured) {
+            footprint_add_calls(footprint, &stats->memory, chunk, &before);
+        }
+
+        done += chunk;
+    }
+}
+
+static void program_run_instrumented(
+    Program const* self, ProgramOp const* ops, size_t len
+) {
+    for (size_t i = 0; i < len; ++i) {
+        auto op = &ops[i];
+
+        switch (op->type) {
+        case PROGRAM_OP_CALL:
+        case PROGRAM_OP_TYPED_CALL:
+            program_run_instrumented_call(self, op, 1);
+            break;
+        case PROGRAM_OP_RUN:
+            procedure_call_instrumented(
+                op->procedure, self->monitor, self->footprint
+            );
+            break;
+        case PROGRAM_OP_REPEAT: {
+            auto body = op + 1;
+
+            if (1 == op->body_len && (PROGRAM_OP_CALL == body->type ||
+                                      PROGRAM_OP_TYPED_CALL == body->type))
+            {
+                program_run_instrumented_call(self, body, op->count);
+            } else if (0 != op->body_len) {
+                for (size_t j = 0; j < op->count; ++j) {
+                    program_run_instrumented(self, body, op->body_len);
+                }
+            }
+
+            i += op->body_len;
+        } break;
+        }
+    }
+}
+
+void program_run(Program const* self) {
+    if (nullptr != self->monitor || nullptr != self->footprint) {
+        program_run_instrumented(self, self->ptr, self->len);
+        return;
+    }
+
+    program_run_ops(self->ptr, self->len);
+}
+
+void program_clear(Program* self) {
+    for (size_t i = 0; i < self->len; ++i) {
+        if (PROGRAM_OP_TYPED_CALL == self->ptr[i].type) {
+            free(self->ptr[i].typed_call);
+        }
+    }
+
+    self->len = 0;
+    self->open.len = 0;
+    self->line_number = 0;
+    string_clear(&self->line);
+}
+
+void program_free(Program* self) {
+    program_clear(self);
+
+    for (size_t i = 0; i < self->thunks.len; ++i) {
+        jit_free(&self->thunks.ptr[i].jit);
+        free(self->thunks.ptr[i].functions);
+    }
+
+    free(self->thunks.ptr);
+    free(self->open.ptr);
+    free(self->ptr);
+    string_free(&self->line);
+
+    *self = PROGRAM_EMPTY;
+}
@@ -0,0 +1,152 @@
+#ifndef _SOTEST_PROGRAM_H
+#define _SOTEST_PROGRAM_H
+
+#include "str.h"
+#include "interpreter.h"
+
+#include <stdint.h>
+
+typedef enum ProgramOpType : uint8_t {
+    PROGRAM_OP_CALL = 0,
+    PROGRAM_OP_REPEAT,
+    PROGRAM_OP_RUN,
+    PROGRAM_OP_TYPED_CALL,
+} ProgramOpType;
+
+typedef struct ProgramOp {
+    ProgramOpType type;
+    /// Available only if `type` is `PROGRAM_OP_CALL` or
+    /// `PROGRAM_OP_TYPED_CALL`
+    ExecutorFunction function;
+    /// `Monitor` slot of `function`, `MONITOR_NO_SLOT` if the program is not
+    /// monitored
+    uint32_t slot;
+    /// Stats of `function`, owned by the executor. Available only if `type`
+    /// is `PROGRAM_OP_CALL` or `PROGRAM_OP_TYPED_CALL`
+    CallStats* stats;
+    /// Owned by the op, its result is dropped. Available only if `type ==
+    /// PROGRAM_OP_TYPED_CALL`
+    TypedCall* typed_call;
+    /// Stub for the signature of `typed_call`, owned by the executor.
+    /// Available only if `type == PROGRAM_OP_TYPED_CALL`
+    JitStub stub;
+    /// Resolved when added. Available only if `type == PROGRAM_OP_RUN`
+    Procedure const* procedure;
+    /// Available only if `type == PROGRAM_OP_REPEAT`
+    size_t count;
+    /// Number of ops following this one which make up the repeated body.
+    /// Available only if `type == PROGRAM_OP_REPEAT`
+    size_t body_len;
+    /// The whole loop compiled, if the body is made of calls only and the
+    /// JIT is enabled. Owned by `Program.thunks`. Available only if `type ==
+    /// PROGRAM_OP_REPEAT`
+    JitCode jit;
+} ProgramOp;
+
+/// Compiled loop of a `repeat`, the same calls repeated as many times reuse
+/// it
+typedef struct ProgramThunk {
+    JitFunction* functions;
+    size_t len;
+    size_t count;
+    JitCode jit;
+} ProgramThunk;
+
+/// Thunks compiled by a program, kept across `program_clear`
+typedef struct ProgramThunks {
+    ProgramThunk* ptr;
+    size_t len;
+    size_t cap;
+} ProgramThunks;
+
+/// Indices of `repeat` ops whose block is not closed yet, innermost last
+typedef struct ProgramBlocks {
+    size_t* ptr;
+    size_t len;
+    size_t cap;
+} ProgramBlocks;
+
+/// A `repeat` with its body, parsed and resolved once and then run without
+/// going back to the script. Nested repeats are stored inline: a `repeat` op
+/// is followed by the `body_len` ops of its body.
+typedef struct Program {
+    ProgramOp* ptr;
+    size_t len;
+    size_t cap;
+    ProgramBlocks open;
+    /// Line of the outermost `repeat` and its text, the program is reported
+    /// as that command
+    size_t line_number;
+    String line;
+    /// Live counters of the executor the ops were resolved with, `nullptr`
+    /// if not kept
+    Monitor* monitor;
+    /// Memory accounting of the executor the ops were resolved with,
+    /// `nullptr` if not measured
+    Footprint* footprint;
+    /// A `repeat` line of a script run many times maps its thunk only once
+    ProgramThunks thunks;
+} Program;
+
+Program constexpr PROGRAM_EMPTY = {
+    .ptr = nullptr,
+    .len = 0,
+    .cap = 0,
+    .open = {.ptr = nullptr, .len = 0, .cap = 0},
+    .line_number = 0,
+    .line = {.str = STR_NULL, .cap = 0},
+    .monitor = nullptr,
+    .footprint = nullptr,
+    .thunks = {.ptr = nullptr, .len = 0, .cap = 0},
+};
+
+typedef struct ProgramAddResult {
+    enum : uint8_t {
+        PROGRAM_ADDED = 0,
+        /// A `call` or the calls of a `run` did not resolve, `.result` tells
+        /// why
+        PROGRAM_NOT_RESOLVED = 1,
+        /// Only `call`, `run` and `repeat` can be repeated, typed calls
+        /// without an expected result
+        PROGRAM_NOT_ALLOWED = 2,
+        /// `}` without an open block
+        PROGRAM_UNEXPECTED_END = 3,
+    } status;
+
+    /// The failed command, the inner one of `repeat <count> <command>`.
+    /// Available only if `status != PROGRAM_ADDED`
+    Command command;
+    /// `dl_error` describes every failure, the `status` is set only for
+    /// `PROGRAM_NOT_RESOLVED`
+    ExecutorResult result;
+} ProgramAddResult;
+
+/// Adds a command of a `repeat` to the program. A `call` is resolved right
+/// away, a failed one is left out of the program. The stub of a typed call
+/// is resolved along, its result is not printed. The procedure of a `run` is
+/// resolved right away as well, its calls which failed are left out.
+///
+/// # Error
+///
+/// See `ProgramAddResult`
+ProgramAddResult program_add(
+    Program* self, Executor* executor, Command const* command
+);
+
+/// A `repeat` block is still waiting for its `}`
+inline static bool program_is_open(Program const* self) {
+    return 0 != self->open.len;
+}
+
+/// Runs every op of a closed program. A monitored or measured program is run
+/// without compiled thunks, counting the calls of a repeated function every
+/// `MONITOR_CHUNK` calls and sampling them every `Footprint.period` calls.
+void program_run(Program const* self);
+
+/// Drops the ops, keeps the allocations and the compiled thunks for the next
+/// program
+void program_clear(Program* self);
+
+void program_free(Program* self);
+
+#endif  // !_SOTEST_PROGRAM_H
@@ -0,0 +1,295 @@
+#include "report.h"
+
+#include <time.h>
+#include <unistd.h>
+
+static uint64_t report_now_ns() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (uint64_t) time.tv_sec * 1000000000 + (uint64_t) time.tv_nsec;
+}
+
+bool report_format_parse(Str name, ReportFormat* format) {
+    if (str_eq(name, Str("text"))) {
+        *format = REPORT_FORMAT_TEXT;
+    } else if (str_eq(name, Str("jsonl"))) {
+        *format = REPORT_FORMAT_JSONL;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+bool reporter_init(Reporter* self, ReportFormat format) {
+    *self = (Reporter) {.format = format, .stream = stderr};
+
+    if (REPORT_FORMAT_JSONL != format) {
+        return true;
+    }
+
+    // A separate stream, so that records do not make other errors buffered
+    auto fd = dup(STDERR_FILENO);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    self->stream = fdopen(fd, "w");
+
+    if (nullptr == self->stream) {
+        close(fd);
+        self->stream = stderr;
+
+        return false;
+    }
+
+    setvbuf(self->stream, nullptr, _IOFBF, REPORT_BUFFER_SIZE);
+
+    return true;
+}
+
+void reporter_init_records(
+    Reporter* self, ReportRecordFunction on_record, void* context
+) {
+    *self = (Reporter) {.on_record = on_record, .context = context};
+}
+
+void reporter_begin(Reporter* self) {
+    self->start_ns = report_now_ns();
+}
+
+char const* command_type_name(CommandType type) {
+    switch (type) {
+    case COMMAND_TYPE_USE:
+        return "use";
+    case COMMAND_TYPE_CALL:
+        return "call";
+    case COMMAND_TYPE_COMPARE:
+        return "compare";
+    case COMMAND_TYPE_BENCH:
+        return "bench";
+    case COMMAND_TYPE_EXPECT:
+        return "expect";
+    case COMMAND_TYPE_REPEAT:
+        return "repeat";
+    case COMMAND_TYPE_END:
+        return "end";
+    case COMMAND_TYPE_DEF:
+        return "def";
+    case COMMAND_TYPE_RUN:
+        return "run";
+    }
+
+    return "unknown";
+}
+
+/// Writes `source` as a quoted JSON string, copying unescaped runs at once
+static void report_write_json_str(Str source, FILE* stream) {
+    putc('"', stream);
+
+    size_t start = 0;
+
+    for (size_t i = 0; i < source.len; ++i) {
+        auto symbol = (unsigned char) source.ptr[i];
+
+        if ('"' != symbol && '\\' != symbol && symbol >= 0x20) {
+            continue;
+        }
+
+        fwrite(source.ptr + start, 1, i - start, stream);
+        start = i + 1;
+
+        switch (symbol) {
+        case '"':
+            fputs("\\\"", stream);
+            break;
+        case '\\':
+            fputs("\\\\", stream);
+            break;
+        case '\n':
+            fputs("\\n", stream);
+            break;
+        case '\t':
+            fputs("\\t", stream);
+            break;
+        default:
+            fprintf(stream, "\\u%04x", symbol);
+            break;
+        }
+    }
+
+    fwrite(source.ptr + start, 1, source.len - start, stream);
+    putc('"', stream);
+}
+
+/// What failed, in the words of the text format
+static char const* report_text_context(CommandType type) {
+    switch (type) {
+    case COMMAND_TYPE_USE:
+        return "failed to load library";
+    case COMMAND_TYPE_CALL:
+        return "failed to call the function";
+    case COMMAND_TYPE_COMPARE:
+        return "failed to compare";
+    case COMMAND_TYPE_BENCH:
+        return "failed to bench";
+    case COMMAND_TYPE_EXPECT:
+        return "expectation failed";
+    case COMMAND_TYPE_RUN:
+        return "failed to run the procedure";
+    case COMMAND_TYPE_REPEAT:
+    case COMMAND_TYPE_END:
+    case COMMAND_TYPE_DEF:
+        break;
+    }
+
+    return "failed";
+}
+
+void reporter_end(
+    Reporter* self, size_t line_number, Command const* command,
+    ExecutorResult result
+) {
+    if (nullptr != self->on_record) {
+        auto record = (ReportRecord) {
+            .line_number = line_number,
+            .command = command,
+            .result = result,
+            .duration_ns = report_now_ns() - self->start_ns,
+        };
+
+        self->on_record(self->context, &record);
+        return;
+    }
+
+    if (REPORT_FORMAT_TEXT == self->format) {
+        if (EXECUTOR_SUCCESS == result.status) {
+            return;
+        }
+
+        // Failed assertions describe themselves, e.g. `compare` regressions
+        if (EXECUTOR_ASSERTION_FAILED == result.status &&
+            COMMAND_TYPE_EXPECT != command->type)
+        {
+            fprintf(self->stream, "error: %s\n", result.dl_error.ptr);
+        } else if (EXECUTOR_ASSERTION_FAILED == result.status) {
+            fprintf(
+                self->stream, "error: line %zu: %s: %s\n", line_number,
+                report_text_context(command->type), result.dl_error.ptr
+            );
+        } else {
+            fprintf(
+                self->stream, "error: %s: %s\n",
+                report_text_context(command->type), result.dl_error.ptr
+            );
+        }
+
+        return;
+    }
+
+    auto duration_ns = report_now_ns() - self->start_ns;
+
+    fprintf(
+        self->stream, "{\"line\": %zu, \"type\": \"%s\", \"target\": ",
+        line_number, command_type_name(command->type)
+    );
+    report_write_json_str(command->content, self->stream);
+    fprintf(
+        self->stream, ", \"status\": \"%s\", \"dl_error\": ",
+        executor_result_name(result).ptr
+    );
+
+    if (EXECUTOR_SUCCESS == result.status) {
+        fputs("null", self->stream);
+    } else {
+        report_write_json_str(result.dl_error, self->stream);
+    }
+
+    fprintf(
+        self->stream, ", \"duration_ns\": %llu}\n",
+        (unsigned long long) duration_ns
+    );
+}
+
+static void report_write_json_parse_error(
+    Reporter* self, size_t line_number, Str line, Str reason
+) {
+    fprintf(
+        self->stream, "{\"line\": %zu, \"type\": null, \"target\": ",
+        line_number
+    );
+    report_write_json_str(line, self->stream);
+    fputs(", \"status\": \"PARSE_FAILED\", \"dl_error\": ", self->stream);
+    report_write_json_str(reason, self->stream);
+    fputs(", \"duration_ns\": 0}\n", self->stream);
+}
+
+/// Passes a line which failed to parse to `on_record`
+static void report_record_parse_error(
+    Reporter* self, size_t line_number, Str line, Str reason
+) {
+    auto record = (ReportRecord) {
+        .line_number = line_number,
+        .command = nullptr,
+        .line = line,
+        .result = {.dl_error = reason},
+    };
+
+    self->on_record(self->context, &record);
+}
+
+void reporter_parse_error(Reporter* self, size_t line_number, Str line) {
+    if (nullptr != self->on_record) {
+        report_record_parse_error(
+            self, line_number, line, Str("failed to parse as `CommandLine`")
+        );
+        return;
+    }
+
+    if (REPORT_FORMAT_TEXT == self->format) {
+        fprintf(
+            self->stream, "error: failed to parse '%.*s' as `CommandLine`\n",
+            (int) line.len, line.ptr
+        );
+        return;
+    }
+
+    report_write_json_parse_error(
+        self, line_number, line, Str("failed to parse as `CommandLine`")
+    );
+}
+
+void reporter_syntax_error(
+    Reporter* self, size_t line_number, Str line, Str reason
+) {
+    if (nullptr != self->on_record) {
+        report_record_parse_error(self, line_number, line, reason);
+        return;
+    }
+
+    if (REPORT_FORMAT_TEXT == self->format) {
+        fprintf(
+            self->stream, "error: line %zu: %.*s\n", line_number,
+            (int) reason.len, reason.ptr
+        );
+        return;
+    }
+
+    report_write_json_parse_error(self, line_number, line, reason);
+}
+
+void reporter_flush(Reporter* self) {
+    if (nullptr != self->stream) {
+        fflush(self->stream);
+    }
+}
+
+void reporter_free(Reporter* self) {
+    if (nullptr != self->stream && stderr != self->stream) {
+        fclose(self->stream);
+    }
+
+    self->stream = nullptr;
+}
@@ -0,0 +1,100 @@
+#ifndef _SOTEST_REPORT_H
+#define _SOTEST_REPORT_H
+
+#include "str.h"
+#include "interpreter.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum ReportFormat : uint8_t {
+    /// Human-readable errors, nothing for successful commands
+    REPORT_FORMAT_TEXT = 0,
+    /// One JSON object per executed command
+    REPORT_FORMAT_JSONL,
+} ReportFormat;
+
+/// Records are written to stderr through a buffer of this size
+size_t constexpr REPORT_BUFFER_SIZE = 1 << 20;
+
+/// Outcome of a command or a line which failed to parse, for
+/// `reporter_init_records`
+typedef struct ReportRecord {
+    size_t line_number;
+    /// `nullptr` for a line which failed to parse
+    Command const* command;
+    /// Available only if `command == nullptr`
+    Str line;
+    /// Only `dl_error` is set for a line which failed to parse, to the reason
+    ExecutorResult result;
+    uint64_t duration_ns;
+} ReportRecord;
+
+typedef void (*ReportRecordFunction)(void* context, ReportRecord const* record);
+
+/// Reports the outcome of every command to stderr. With
+/// `REPORT_FORMAT_JSONL` each record is a line like
+///
+/// ```json
+/// {"line": 3, "type": "call", "target": "foo", "status": "EXECUTOR_SUCCESS",
+///  "dl_error": null, "duration_ns": 1234}
+/// ```
+///
+/// Lines which fail to parse get `"type": null` and `"status":
+/// "PARSE_FAILED"`.
+typedef struct Reporter {
+    ReportFormat format;
+    FILE* stream;
+    /// Start of the current command, `CLOCK_MONOTONIC`
+    uint64_t start_ns;
+    /// Receives the records instead of `stream` if set
+    ReportRecordFunction on_record;
+    void* context;
+    /// Holds nul-terminated error descriptions built while executing
+    char error[256];
+} Reporter;
+
+/// Parses `text` or `jsonl`
+///
+/// # Return
+///
+/// `false` if the name is unknown
+bool report_format_parse(Str name, ReportFormat* format);
+
+/// # Error
+///
+/// Returns `false` and sets `errno` if stderr can not be duplicated
+bool reporter_init(Reporter* self, ReportFormat format);
+
+/// Passes every record to `on_record` instead of writing it, successful
+/// commands included
+void reporter_init_records(
+    Reporter* self, ReportRecordFunction on_record, void* context
+);
+
+/// Name of the command type as reported, e.g. `call`
+char const* command_type_name(CommandType type);
+
+/// Marks the start of a command
+void reporter_begin(Reporter* self);
+
+/// Reports the command started by `reporter_begin`
+void reporter_end(
+    Reporter* self, size_t line_number, Command const* command,
+    ExecutorResult result
+);
+
+/// Reports a line which is not a valid `CommandLine`
+void reporter_parse_error(Reporter* self, size_t line_number, Str line);
+
+/// Reports a line which parses but does not fit where it is, e.g. a `use` in
+/// a `repeat` block. Recorded like a parse failure.
+void reporter_syntax_error(
+    Reporter* self, size_t line_number, Str line, Str reason
+);
+
+void reporter_flush(Reporter* self);
+
+void reporter_free(Reporter* self);
+
+#endif  // !_SOTEST_REPORT_H
@@ -0,0 +1,618 @@
+#define _GNU_SOURCE
+
+#include "session.h"
+#include "elf_image.h"
+#include "history.h"
+#include "monitor.h"
+#include "probes.h"
+
+#include <ctype.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/// Runs `compare` and writes the results to `output`
+///
+/// # Error
+///
+/// Returns the status of a failed lookup, or `EXECUTOR_ASSERTION_FAILED` with
+/// a description written to `error` if the candidate regressed beyond the
+/// allowed threshold
+static ExecutorResult execute_compare(
+    Executor* executor, Environment* environment, Command const* command,
+    CompareOptions options, FILE* output, char* error, size_t error_size
+) {
+    auto baseline = executor_resolve_from(
+        executor, command->baseline_path, command->content
+    );
+
+    if (EXECUTOR_SUCCESS != baseline.result.status) {
+        return baseline.result;
+    }
+
+    auto candidate = executor_resolve_from(
+        executor, command->candidate_path, command->content
+    );
+
+    if (EXECUTOR_SUCCESS != candidate.result.status) {
+        return candidate.result;
+    }
+
+    environment_prefault_libraries(environment);
+
+    auto result =
+        compare_functions(baseline.function, candidate.function, options);
+
+    // Keep the report after the output of the compared functions
+    fflush(stdout);
+    compare_result_write(&result, command, output);
+    environment_write_noise(environment, "  ", output);
+
+    if (result.is_regression) {
+        snprintf(
+            error, error_size,
+            "'%.*s' is %.1f%% slower in the candidate, more than %.1f%% "
+            "allowed",
+            (int) command->content.len, command->content.ptr,
+            result.regression, options.max_regression
+        );
+
+        return (ExecutorResult) {
+            .status = EXECUTOR_ASSERTION_FAILED,
+            .dl_error = str_from_ptr(error),
+        };
+    }
+
+    return (ExecutorResult) {.status = EXECUTOR_SUCCESS};
+}
+
+/// Runs a typed call and writes its result to `output` as
+/// `<name> -> <value>`, unless it is checked against an expected value
+///
+/// # Error
+///
+/// Returns the status of a failed lookup or stub, or
+/// `EXECUTOR_ASSERTION_FAILED` with a description written to `error` if the
+/// result differs from the expected one
+static ExecutorResult execute_typed_call(
+    Executor* executor, Command const* command, FILE* output, char* error,
+    size_t error_size
+) {
+    auto resolved =
+        0 == command->alias.len
+            ? executor_resolve_function(executor, command->content)
+            : executor_resolve_qualified_function(executor, command->content);
+
+    if (EXECUTOR_SUCCESS != resolved.result.status) {
+        return resolved.result;
+    }
+
+    // The parser already validated the signature
+    auto call = (TypedCall) {};
+    parse_typed_call(command->signature, &call);
+
+    auto value = (JitValue) {};
+    auto result = executor_call_typed(
+        executor, command->content, &resolved, &call, &value
+    );
+    auto type = call.signature.result;
+
+    if (EXECUTOR_SUCCESS != result.status || JIT_TYPE_VOID == type) {
+        return result;
+    }
+
+    char formatted[64];
+    typed_value_format(value, type, formatted, sizeof(formatted));
+
+    if (!call.has_expected) {
+        fprintf(
+            output, "%.*s -> %s\n", (int) command->content.len,
+            command->content.ptr, formatted
+        );
+
+        return result;
+    }
+
+    if (typed_value_eq(value, call.expected, type)) {
+        return result;
+    }
+
+    char expected[64];
+    typed_value_format(call.expected, type, expected, sizeof(expected));
+    snprintf(
+        error, error_size, "'%.*s' returned %s, expected %s",
+        (int) command->content.len, command->content.ptr, formatted, expected
+    );
+
+    return (ExecutorResult) {
+        .status = EXECUTOR_ASSERTION_FAILED,
+        .dl_error = str_from_ptr(error),
+    };
+}
+
+/// Parses the hash of `expect`, which the parser already validated
+static uint64_t parse_hex(Str source) {
+    uint64_t value = 0;
+
+    for (size_t i = 0; i < source.len; ++i) {
+        auto symbol = source.ptr[i];
+        auto digit =
+            isdigit(symbol) ? symbol - '0' : tolower(symbol) - 'a' + 10;
+        value = 16 * value + (uint64_t) digit;
+    }
+
+    return value;
+}
+
+/// Runs `bench`, writes the results to `output` and records them in the
+/// history
+///
+/// # Error
+///
+/// Returns the status of a failed lookup, or `EXECUTOR_ASSERTION_FAILED` with
+/// a description written to `error` if the function regressed against the
+/// history baseline
+static ExecutorResult execute_bench(
+    Executor* executor, Environment* environment, Command const* command,
+    BenchOptions options, FILE* output, char* error, size_t error_size
+) {
+    auto resolved =
+        0 == command->alias.len
+            ? executor_resolve_function(executor, command->content)
+            : executor_resolve_qualified_function(executor, command->content);
+
+    if (EXECUTOR_SUCCESS != resolved.result.status) {
+        return resolved.result;
+    }
+
+    Dl_info info;
+    auto library = Str("-");
+
+    if (0 != dladdr((void*) resolved.function, &info) &&
+        nullptr != info.dli_fname)
+    {
+        library = str_from_ptr((char*) info.dli_fname);
+    }
+
+    environment_prefault_libraries(environment);
+
+    // Aliases are local to the script, the library identifies the function
+    auto function_name =
+        0 == command->alias.len
+            ? command->content
+            : str_slice(
+                  command->content, command->alias.len + 1,
+                  command->content.len
+              );
+
+    auto record = (HistoryRecord) {
+        .time = (int64_t) time(nullptr),
+        .function = function_name,
+        .library = library,
+        .n_samples = 0 == options.compare.n_samples ? 1
+                                                    : options.compare.n_samples,
+        .summary = compare_benchmark(resolved.function, options.compare),
+    };
+
+    // Keep the report after the output of the benchmarked function
+    fflush(stdout);
+    fprintf(
+        output, "bench %.*s: %zu samples\n", (int) command->content.len,
+        command->content.ptr, record.n_samples
+    );
+    compare_summary_write(&record.summary, "current", library, output);
+
+    if (0 == options.history_path.len) {
+        environment_write_noise(environment, "  ", output);
+        return (ExecutorResult) {.status = EXECUTOR_SUCCESS};
+    }
+
+    auto build_id = STRING_EMPTY;
+    auto image = elf_image_open(library);
+
+    if (ELF_SUCCESS == image.status) {
+        elf_image_build_id_hex(&image.value, &build_id);
+        elf_image_free(&image.value);
+    }
+
+    if (0 == build_id.str.len) {
+        string_append(&build_id, Str("-"));
+    }
+
+    auto host = STRING_EMPTY;
+    history_host_fingerprint(&host);
+
+    record.build_id = build_id.str;
+    record.host = host.str;
+
+    bool is_regression = false;
+
+    if (options.is_baseline) {
+        auto baseline = history_baseline(
+            options.history_path, &record, options.compare.max_regression
+        );
+
+        if (baseline.n_records < HISTORY_MIN_RECORDS) {
+            fprintf(
+                output, "  history   %zu matching runs, %zu needed for a "
+                        "baseline\n",
+                baseline.n_records, HISTORY_MIN_RECORDS
+            );
+        } else {
+            fprintf(
+                output,
+                "  history   median %10.1f ns, MAD %8.1f ns, threshold "
+                "%10.1f ns  (%zu runs)\n",
+                baseline.median, baseline.mad, baseline.threshold,
+                baseline.n_records
+            );
+
+            is_regression = record.summary.median > baseline.threshold;
+        }
+    }
+
+    environment_write_noise(environment, "  ", output);
+
+    if (is_regression) {
+        snprintf(
+            error, error_size,
+            "'%.*s' regressed against the history, not recording it",
+            (int) command->content.len, command->content.ptr
+        );
+    } else if (!history_append(options.history_path, &record)) {
+        fprintf(
+            stderr, "error: failed to write the history '%.*s': %s\n",
+            (int) options.history_path.len, options.history_path.ptr,
+            strerror(errno)
+        );
+    }
+
+    string_free(&host);
+    string_free(&build_id);
+
+    if (is_regression) {
+        return (ExecutorResult) {
+            .status = EXECUTOR_ASSERTION_FAILED,
+            .dl_error = str_from_ptr(error),
+        };
+    }
+
+    return (ExecutorResult) {.status = EXECUTOR_SUCCESS};
+}
+
+/// Adds a line of a `repeat` to the program, starting the program at the
+/// outermost `repeat`. Lines which do not make it into the program are
+/// reported, the rest of the program still runs.
+static void add_to_program(
+    Program* program, Executor* executor, Reporter* reporter,
+    size_t line_number, Str line, Command const* command
+) {
+    if (!program_is_open(program) && COMMAND_TYPE_REPEAT == command->type) {
+        program->line_number = line_number;
+        string_append(&program->line, line);
+    }
+
+    reporter_begin(reporter);
+
+    auto added = program_add(program, executor, command);
+
+    switch (added.status) {
+    case PROGRAM_ADDED:
+        break;
+    case PROGRAM_NOT_RESOLVED:
+        reporter_end(reporter, line_number, &added.command, added.result);
+        break;
+    case PROGRAM_NOT_ALLOWED:
+    case PROGRAM_UNEXPECTED_END:
+        reporter_syntax_error(
+            reporter, line_number, line, added.result.dl_error
+        );
+        break;
+    }
+}
+
+/// Adds a line of a `def` block to its procedure
+static void add_to_definition(
+    Definition* definition, Reporter* reporter, size_t line_number, Str line,
+    Command const* command
+) {
+    switch (command->type) {
+    case COMMAND_TYPE_CALL:
+        if (0 != command->signature.len) {
+            reporter_syntax_error(
+                reporter, line_number, line,
+                Str("typed calls can not be used in a `def` block")
+            );
+            break;
+        }
+
+        procedure_add_call(
+            definition->procedure, command->content, 0 != command->alias.len
+        );
+        break;
+    case COMMAND_TYPE_END:
+        definition->procedure = nullptr;
+        string_clear(&definition->line);
+        break;
+    case COMMAND_TYPE_USE:
+    case COMMAND_TYPE_COMPARE:
+    case COMMAND_TYPE_BENCH:
+    case COMMAND_TYPE_EXPECT:
+    case COMMAND_TYPE_REPEAT:
+    case COMMAND_TYPE_DEF:
+    case COMMAND_TYPE_RUN:
+        reporter_syntax_error(
+            reporter, line_number, line,
+            Str("only `call` can be used in a `def` block")
+        );
+        break;
+    }
+}
+
+Session session_new(ExecutorOptions options) {
+    auto compare_options = (CompareOptions) {
+        .n_samples = COMPARE_DEFAULT_SAMPLES,
+        .max_regression = COMPARE_DEFAULT_MAX_REGRESSION,
+        .seed = (uint64_t) time(nullptr),
+    };
+
+    return (Session) {
+        .executor = executor_with_options(options),
+        .compare_options = compare_options,
+        .bench_options = (BenchOptions) {.compare = compare_options},
+        .output = stdout,
+        .program = PROGRAM_EMPTY,
+        .definition = (Definition) {.line = STRING_EMPTY},
+    };
+}
+
+CommandLineParseResult session_parse_line(size_t line_number, Str line) {
+    auto parse_start_ns = PROBE_IS_ENABLED(command_parsed) ? probe_now_ns() : 0;
+
+    auto result = command_line_parse(str_trim(line));
+
+    if (PROBE_IS_ENABLED(command_parsed)) {
+        auto has_command = result.has_value && result.value.has_command;
+
+        PROBE3(
+            command_parsed, line_number,
+            has_command ? (int64_t) result.value.command.type : -1,
+            probe_now_ns() - parse_start_ns
+        );
+    }
+
+    return result;
+}
+
+/// Counts the line read from the script
+static void session_begin_line(Session* self, Str text) {
+    self->line_number += 1;
+    PROBE3(line_read, self->line_number, text.ptr, text.len);
+
+    auto monitor = self->executor.options.monitor;
+
+    if (nullptr != monitor && nullptr != monitor->segment) {
+        monitor_add(&monitor->segment->n_lines, 1);
+    }
+}
+
+static bool session_execute_command_line(
+    Session* self, Str line, CommandLineParseResult const* parsed
+) {
+    auto line_number = self->line_number;
+
+    if (str_starts_with(line, Str("exit"))) {
+        return false;
+    }
+
+    auto tail = str_trim_end(parsed->tail);
+
+    if (!parsed->has_value || 0 != tail.len) {
+        reporter_parse_error(&self->reporter, line_number, line);
+        return true;
+    }
+
+    auto command_line = &parsed->value;
+
+    if (!command_line->has_command) {
+        return true;
+    }
+
+    auto command = &command_line->command;
+    auto command_line_number = line_number;
+    auto repeat = (Command) {};
+
+    // Calls of a procedure are only stored, they are resolved when it runs
+    if (nullptr != self->definition.procedure) {
+        add_to_definition(
+            &self->definition, &self->reporter, line_number, line, command
+        );
+        return true;
+    }
+
+    // Commands of a `repeat` block are only resolved, the whole program runs
+    // as one command when the outermost `repeat` is complete
+    if (program_is_open(&self->program) ||
+        COMMAND_TYPE_REPEAT == command->type ||
+        COMMAND_TYPE_END == command->type)
+    {
+        add_to_program(
+            &self->program, &self->executor, &self->reporter, line_number,
+            line, command
+        );
+
+        if (program_is_open(&self->program) ||
+            0 == self->program.line_number)
+        {
+            return true;
+        }
+
+        command_line_number = self->program.line_number;
+        line = self->program.line.str;
+        repeat = command_parse(line).value;
+        command = &repeat;
+    }
+
+    auto executor = &self->executor;
+    auto reporter = &self->reporter;
+    auto result = (ExecutorResult) {.status = EXECUTOR_SUCCESS};
+
+    reporter_begin(reporter);
+
+    // `expect` checks the output of the previous command, it must not start
+    // an output of its own
+    if (COMMAND_TYPE_EXPECT != command->type) {
+        capture_begin(&self->capture);
+    }
+
+    profiler_begin(&self->profiler, command_line_number);
+
+    switch (command->type) {
+    case COMMAND_TYPE_USE: {
+        result = 0 == command->alias.len
+                     ? executor_load_library(executor, command->content)
+                     : executor_load_library_as(
+                           executor, command->content, command->alias,
+                           command->is_isolated
+                       );
+
+        if (EXECUTOR_SUCCESS == result.status) {
+            environment_prefault_libraries(&self->environment);
+        }
+    } break;
+    case COMMAND_TYPE_CALL:
+        if (0 != command->signature.len) {
+            result = execute_typed_call(
+                executor, command, self->output, reporter->error,
+                sizeof(reporter->error)
+            );
+            break;
+        }
+
+        result =
+            0 == command->alias.len
+                ? executor_call_function(executor, command->content)
+                : executor_call_qualified_function(executor, command->content);
+        break;
+    case COMMAND_TYPE_COMPARE:
+        result = execute_compare(
+            executor, &self->environment, command, self->compare_options,
+            self->output, reporter->error, sizeof(reporter->error)
+        );
+        break;
+    case COMMAND_TYPE_BENCH:
+        result = execute_bench(
+            executor, &self->environment, command, self->bench_options,
+            self->output, reporter->error, sizeof(reporter->error)
+        );
+        break;
+    case COMMAND_TYPE_EXPECT:
+        result = capture_expect(&self->capture, parse_hex(command->content));
+        break;
+    case COMMAND_TYPE_REPEAT:
+        program_run(&self->program);
+        break;
+    case COMMAND_TYPE_DEF:
+        self->definition.procedure =
+            executor_define_procedure(executor, command->content);
+        self->definition.line_number = line_number;
+        string_append(&self->definition.line, line);
+        break;
+    case COMMAND_TYPE_RUN:
+        result = executor_run_procedure(executor, command->content);
+        break;
+    case COMMAND_TYPE_END:
+        break;
+    }
+
+    // A leak only grows, the run stops at the first function beyond the
+    // limit
+    auto footprint = executor->options.footprint;
+    auto is_over_limit =
+        nullptr != footprint && 0 != footprint->exceeded.str.len;
+
+    if (is_over_limit) {
+        snprintf(
+            reporter->error, sizeof(reporter->error),
+            "'%.*s' grew the heap by %lld bytes per %zu calls, more than "
+            "%llu allowed",
+            (int) footprint->exceeded.str.len, footprint->exceeded.str.ptr,
+            (long long) footprint->exceeded_growth, footprint->period,
+            (unsigned long long) footprint->max_growth
+        );
+
+        result = (ExecutorResult) {
+            .status = EXECUTOR_ASSERTION_FAILED,
+            .dl_error = str_from_ptr(reporter->error),
+        };
+    }
+
+    profiler_end(&self->profiler);
+
+    if (COMMAND_TYPE_EXPECT != command->type) {
+        capture_end(&self->capture, command_line_number, line);
+    }
+
+    reporter_end(reporter, command_line_number, command, result);
+
+    // `line` and `repeat` point into the program
+    if (COMMAND_TYPE_REPEAT == command->type) {
+        program_clear(&self->program);
+    }
+
+    // Failed lookups are reported, failed checks fail the whole run
+    if (EXECUTOR_ASSERTION_FAILED == result.status) {
+        self->has_failed = true;
+    }
+
+    return !is_over_limit;
+}
+
+bool session_execute_line(Session* self, Str text) {
+    session_begin_line(self, text);
+
+    auto line = str_trim(text);
+    auto parsed = session_parse_line(self->line_number, line);
+
+    return session_execute_command_line(self, line, &parsed);
+}
+
+bool session_execute_parsed(
+    Session* self, Str line, CommandLineParseResult const* parsed
+) {
+    session_begin_line(self, line);
+
+    return session_execute_command_line(self, line, parsed);
+}
+
+void session_finish(Session* self) {
+    if (program_is_open(&self->program)) {
+        reporter_syntax_error(
+            &self->reporter, self->program.line_number,
+            self->program.line.str, Str("`repeat` block is not closed by `}`")
+        );
+        program_clear(&self->program);
+    }
+
+    if (nullptr != self->definition.procedure) {
+        reporter_syntax_error(
+            &self->reporter, self->definition.line_number,
+            self->definition.line.str, Str("`def` block is not closed by `}`")
+        );
+        self->definition.procedure = nullptr;
+        string_clear(&self->definition.line);
+    }
+}
+
+void session_free(Session* self) {
+    profiler_stop(&self->profiler);
+    capture_stop(&self->capture);
+    reporter_free(&self->reporter);
+    program_free(&self->program);
+    string_free(&self->definition.line);
+    environment_free(&self->environment);
+    executor_free(&self->executor);
+}
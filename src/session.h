@@ -0,0 +1,89 @@
+#ifndef _SOTEST_SESSION_H
+#define _SOTEST_SESSION_H
+
+#include "str.h"
+#include "interpreter.h"
+#include "parse.h"
+#include "capture.h"
+#include "compare.h"
+#include "environment.h"
+#include "profile.h"
+#include "program.h"
+#include "report.h"
+
+#include <stdio.h>
+
+/// Where `bench` results go
+typedef struct BenchOptions {
+    CompareOptions compare;
+    /// History file, empty if results are not recorded
+    Str history_path;
+    /// Fail on regressions against the history instead of only recording
+    bool is_baseline;
+} BenchOptions;
+
+/// `def` block being read
+typedef struct Definition {
+    /// `nullptr` outside of a `def` block
+    Procedure* procedure;
+    size_t line_number;
+    String line;
+} Definition;
+
+/// Everything a line of a script may leave for the next ones. The capture,
+/// the profiler and the environment act on the whole process, they stay
+/// inactive unless the owner starts them, so that independent sessions can
+/// run in one process.
+typedef struct Session {
+    Executor executor;
+    /// Set up by the owner, see `reporter_init` and `reporter_init_records`
+    Reporter reporter;
+    Capture capture;
+    Profiler profiler;
+    Environment environment;
+    CompareOptions compare_options;
+    BenchOptions bench_options;
+    /// Output of the interpreter itself: results of typed calls, `compare`
+    /// and `bench` reports. Not owned, stdout unless set.
+    FILE* output;
+    /// Number of the last line executed
+    size_t line_number;
+    Program program;
+    Definition definition;
+    /// A check failed, e.g. `expect` or a `compare` regression
+    bool has_failed;
+} Session;
+
+/// A session with default compare options and nothing started
+Session session_new(ExecutorOptions options);
+
+/// Parses a trimmed line, firing the `command_parsed` probe. The result is
+/// kept by compiled scripts, see `session_execute_parsed`.
+CommandLineParseResult session_parse_line(size_t line_number, Str line);
+
+/// Executes the next line of a script, parsed beforehand by
+/// `session_parse_line`. Lines of a `repeat` block run as one command once
+/// the block is closed, lines of a `def` block only add calls to the
+/// procedure. Every command and every line which fails to parse is reported.
+///
+/// # Return
+///
+/// `false` if the script is to stop: the line is `exit` or a function grew
+/// the heap beyond the limit of the `Footprint`
+bool session_execute_parsed(
+    Session* self, Str line, CommandLineParseResult const* parsed
+);
+
+/// Parses and executes the next line of a script, see
+/// `session_execute_parsed`
+bool session_execute_line(Session* self, Str text);
+
+/// Reports the `repeat` and `def` blocks left open at the end of a script and
+/// drops them
+void session_finish(Session* self);
+
+/// Stops the capture and the profiler, frees the reporter, the environment
+/// and the executor. The output is left to its owner.
+void session_free(Session* self);
+
+#endif  // !_SOTEST_SESSION_H
@@ -0,0 +1,213 @@
+#define _GNU_SOURCE
+
+#include <sotest.h>
+
+#include "str.h"
+#include "session.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct Sotest {
+    Session session;
+    SotestCallbacks callbacks;
+    /// Status of the last command reported, see `sotest_execute_line`
+    SotestStatus status;
+};
+
+/// Line of a compiled script
+typedef struct SotestLine {
+    /// Trimmed, points into `SotestScript.source`
+    Str text;
+    CommandLineParseResult parsed;
+} SotestLine;
+
+struct SotestScript {
+    /// Copy of the source the lines point into
+    char* source;
+    SotestLine* lines;
+    size_t len;
+};
+
+/// Forwards the output of the interpreter to `on_output`
+static ssize_t sotest_write_output(void* cookie, char const* ptr, size_t len) {
+    Sotest* self = cookie;
+    self->callbacks.on_output(self->callbacks.context, ptr, len);
+
+    return (ssize_t) len;
+}
+
+/// Keeps the status of the record and passes it on to `on_result`
+static void sotest_on_record(void* context, ReportRecord const* record) {
+    Sotest* self = context;
+
+    auto status = nullptr == record->command
+                      ? SOTEST_PARSE_FAILED
+                      : (SotestStatus) record->result.status;
+
+    self->status = status;
+
+    if (nullptr == self->callbacks.on_result) {
+        return;
+    }
+
+    auto target =
+        nullptr == record->command ? record->line : record->command->content;
+
+    auto error =
+        SOTEST_SUCCESS == status ? nullptr : record->result.dl_error.ptr;
+
+    auto result = (SotestResult) {
+        .line_number = record->line_number,
+        .type = nullptr == record->command
+                    ? nullptr
+                    : command_type_name(record->command->type),
+        .target = target.ptr,
+        .target_len = target.len,
+        .status = status,
+        .error = error,
+        .duration_ns = record->duration_ns,
+    };
+
+    self->callbacks.on_result(self->callbacks.context, &result);
+}
+
+Sotest* sotest_new(SotestOptions options) {
+    auto self = (Sotest*) calloc(1, sizeof(Sotest));
+
+    self->callbacks = options.callbacks;
+    self->session = session_new((ExecutorOptions) {
+        .is_lazy = options.is_lazy,
+        .is_jit_disabled = options.is_jit_disabled,
+    });
+
+    reporter_init_records(&self->session.reporter, sotest_on_record, self);
+
+    if (nullptr != options.callbacks.on_output) {
+        auto output = fopencookie(
+            self, "w", (cookie_io_functions_t) {.write = sotest_write_output}
+        );
+
+        if (nullptr == output) {
+            session_free(&self->session);
+            free(self);
+
+            return nullptr;
+        }
+
+        // Each report reaches the callback before the result of its command
+        setvbuf(output, nullptr, _IONBF, 0);
+        self->session.output = output;
+    }
+
+    return self;
+}
+
+/// Executes a line and tells its status
+static SotestStatus sotest_execute_parsed(
+    Sotest* self, Str line, CommandLineParseResult const* parsed
+) {
+    self->status = SOTEST_SUCCESS;
+
+    if (!session_execute_parsed(&self->session, line, parsed)) {
+        return SOTEST_EXIT;
+    }
+
+    return self->status;
+}
+
+SotestStatus sotest_execute_line(Sotest* self, char const* line, size_t len) {
+    auto text = str_trim((Str) {.ptr = (char*) line, .len = len});
+    auto parsed = session_parse_line(self->session.line_number + 1, text);
+
+    return sotest_execute_parsed(self, text, &parsed);
+}
+
+void sotest_finish(Sotest* self) { session_finish(&self->session); }
+
+SotestScript* sotest_compile(char const* source, size_t len) {
+    auto self = (SotestScript*) calloc(1, sizeof(SotestScript));
+
+    self->source = (char*) malloc(len + 1);
+    memcpy(self->source, source, len);
+    self->source[len] = '\0';
+
+    size_t n_lines = 0;
+
+    for (size_t i = 0; i < len; ++i) {
+        n_lines += '\n' == source[i];
+    }
+
+    // The last line need not end with a newline
+    n_lines += 0 != len && '\n' != source[len - 1];
+
+    self->lines = (SotestLine*) malloc(sizeof(SotestLine) * (n_lines + 1));
+
+    auto rest = (Str) {.ptr = self->source, .len = len};
+
+    while (0 != rest.len) {
+        size_t end = 0;
+
+        while (end < rest.len && '\n' != rest.ptr[end]) {
+            end += 1;
+        }
+
+        auto text = str_trim(str_slice(rest, 0, end));
+
+        self->lines[self->len] = (SotestLine) {
+            .text = text,
+            .parsed = session_parse_line(self->len + 1, text),
+        };
+        self->len += 1;
+
+        rest = str_slice(rest, end + 1, rest.len);
+    }
+
+    return self;
+}
+
+size_t sotest_script_len(SotestScript const* self) { return self->len; }
+
+bool sotest_execute(Sotest* self, SotestScript const* script) {
+    auto session = &self->session;
+
+    session->line_number = 0;
+    session->has_failed = false;
+
+    for (size_t i = 0; i < script->len; ++i) {
+        auto line = &script->lines[i];
+        auto status = sotest_execute_parsed(self, line->text, &line->parsed);
+
+        if (SOTEST_EXIT == status) {
+            break;
+        }
+    }
+
+    session_finish(session);
+
+    return !session->has_failed;
+}
+
+void sotest_script_free(SotestScript* self) {
+    if (nullptr == self) {
+        return;
+    }
+
+    free(self->lines);
+    free(self->source);
+    free(self);
+}
+
+void sotest_free(Sotest* self) {
+    if (nullptr == self) {
+        return;
+    }
+
+    if (stdout != self->session.output) {
+        fclose(self->session.output);
+    }
+
+    session_free(&self->session);
+    free(self);
+}
@@ -0,0 +1,226 @@
+#include "stats.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int stats_compare_doubles(void const* a, void const* b) {
+    auto first = *(double const*) a;
+    auto second = *(double const*) b;
+
+    return (first > second) - (first < second);
+}
+
+void stats_sort(double* values, size_t len) {
+    qsort(values, len, sizeof(*values), stats_compare_doubles);
+}
+
+double stats_percentile(double const* sorted, size_t len, double rank) {
+    if (0 == len) {
+        return NAN;
+    }
+
+    auto position = rank / 100.0 * (double) (len - 1);
+    auto index = (size_t) position;
+
+    if (index + 1 >= len) {
+        return sorted[len - 1];
+    }
+
+    auto fraction = position - (double) index;
+
+    return sorted[index] + fraction * (sorted[index + 1] - sorted[index]);
+}
+
+double stats_median(double const* sorted, size_t len) {
+    return stats_percentile(sorted, len, 50.0);
+}
+
+double stats_mean(double const* values, size_t len) {
+    if (0 == len) {
+        return NAN;
+    }
+
+    double sum = 0.0;
+
+    for (size_t i = 0; i < len; ++i) {
+        sum += values[i];
+    }
+
+    return sum / (double) len;
+}
+
+double stats_mad(double const* sorted, size_t len) {
+    if (0 == len) {
+        return NAN;
+    }
+
+    auto median = stats_median(sorted, len);
+    auto deviations = (double*) malloc(sizeof(double) * len);
+
+    for (size_t i = 0; i < len; ++i) {
+        deviations[i] = fabs(sorted[i] - median);
+    }
+
+    stats_sort(deviations, len);
+    auto result = stats_median(deviations, len);
+    free(deviations);
+
+    return result;
+}
+
+typedef struct RankedValue {
+    double value;
+    bool is_first;
+} RankedValue;
+
+static int stats_compare_ranked(void const* a, void const* b) {
+    return stats_compare_doubles(
+        &((RankedValue const*) a)->value, &((RankedValue const*) b)->value
+    );
+}
+
+MannWhitneyResult stats_mann_whitney(
+    double const* first, size_t first_len, double const* second,
+    size_t second_len
+) {
+    auto len = first_len + second_len;
+
+    if (0 == first_len || 0 == second_len) {
+        return (MannWhitneyResult) {.u = NAN, .z = NAN, .p_value = NAN};
+    }
+
+    auto values = (RankedValue*) malloc(sizeof(RankedValue) * len);
+
+    for (size_t i = 0; i < first_len; ++i) {
+        values[i] = (RankedValue) {.value = first[i], .is_first = true};
+    }
+
+    for (size_t i = 0; i < second_len; ++i) {
+        values[first_len + i] =
+            (RankedValue) {.value = second[i], .is_first = false};
+    }
+
+    qsort(values, len, sizeof(*values), stats_compare_ranked);
+
+    double first_rank_sum = 0.0;
+    double tie_sum = 0.0;
+
+    for (size_t start = 0; start < len;) {
+        auto end = start + 1;
+
+        while (end < len && values[end].value == values[start].value) {
+            end += 1;
+        }
+
+        // Tied values share the average of their 1-based ranks
+        auto rank = (double) (start + 1 + end) / 2.0;
+        auto n_tied = (double) (end - start);
+
+        for (size_t i = start; i < end; ++i) {
+            if (values[i].is_first) {
+                first_rank_sum += rank;
+            }
+        }
+
+        tie_sum += n_tied * n_tied * n_tied - n_tied;
+        start = end;
+    }
+
+    free(values);
+
+    auto n1 = (double) first_len;
+    auto n2 = (double) second_len;
+    auto n = (double) len;
+    auto u = first_rank_sum - n1 * (n1 + 1.0) / 2.0;
+    auto mean = n1 * n2 / 2.0;
+    auto variance =
+        n1 * n2 / 12.0 * ((n + 1.0) - tie_sum / (n * (n - 1.0)));
+
+    if (variance <= 0.0) {
+        return (MannWhitneyResult) {.u = u, .z = 0.0, .p_value = 1.0};
+    }
+
+    auto difference = fabs(u - mean) - 0.5;
+
+    if (difference < 0.0) {
+        difference = 0.0;
+    }
+
+    auto z = copysign(difference / sqrt(variance), u - mean);
+
+    return (MannWhitneyResult) {
+        .u = u,
+        .z = z,
+        .p_value = erfc(fabs(z) / sqrt(2.0)),
+    };
+}
+
+StatsRandom stats_random_new(uint64_t seed) {
+    // Zero is a fixed point of xorshift
+    return (StatsRandom) {.state = 0 == seed ? 0x9e3779b97f4a7c15ull : seed};
+}
+
+uint64_t stats_random_next(StatsRandom* self) {
+    auto x = self->state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    self->state = x;
+
+    return x * 0x2545f4914f6cdd1dull;
+}
+
+size_t stats_random_index(StatsRandom* self, size_t len) {
+    return (size_t) (stats_random_next(self) % len);
+}
+
+static double stats_resampled_median(
+    double const* values, size_t len, double* buffer, StatsRandom* random
+) {
+    for (size_t i = 0; i < len; ++i) {
+        buffer[i] = values[stats_random_index(random, len)];
+    }
+
+    stats_sort(buffer, len);
+
+    return stats_median(buffer, len);
+}
+
+StatsInterval stats_bootstrap_median_ratio(
+    double const* numerator, size_t numerator_len, double const* denominator,
+    size_t denominator_len, double confidence, size_t n_resamples,
+    StatsRandom* random
+) {
+    if (0 == numerator_len || 0 == denominator_len || 0 == n_resamples) {
+        return (StatsInterval) {.low = NAN, .high = NAN};
+    }
+
+    auto max_len =
+        numerator_len > denominator_len ? numerator_len : denominator_len;
+    auto buffer = (double*) malloc(sizeof(double) * max_len);
+    auto ratios = (double*) malloc(sizeof(double) * n_resamples);
+
+    for (size_t i = 0; i < n_resamples; ++i) {
+        auto top =
+            stats_resampled_median(numerator, numerator_len, buffer, random);
+        auto bottom = stats_resampled_median(
+            denominator, denominator_len, buffer, random
+        );
+
+        ratios[i] = top / bottom;
+    }
+
+    stats_sort(ratios, n_resamples);
+
+    auto tail = (1.0 - confidence) / 2.0 * 100.0;
+    auto result = (StatsInterval) {
+        .low = stats_percentile(ratios, n_resamples, tail),
+        .high = stats_percentile(ratios, n_resamples, 100.0 - tail),
+    };
+
+    free(ratios);
+    free(buffer);
+
+    return result;
+}
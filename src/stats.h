@@ -0,0 +1,61 @@
+#ifndef _SOTEST_STATS_H
+#define _SOTEST_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Sorts `len` values in place in ascending order
+void stats_sort(double* values, size_t len);
+
+/// Linearly interpolated percentile of sorted values, `rank` in `[0, 100]`
+double stats_percentile(double const* sorted, size_t len, double rank);
+
+double stats_median(double const* sorted, size_t len);
+
+double stats_mean(double const* values, size_t len);
+
+/// Median absolute deviation of sorted values, not scaled
+double stats_mad(double const* sorted, size_t len);
+
+typedef struct MannWhitneyResult {
+    /// U statistic of the first sample
+    double u;
+    /// Normal approximation with tie and continuity corrections
+    double z;
+    /// Two-sided p-value
+    double p_value;
+} MannWhitneyResult;
+
+/// Mann-Whitney U test of two independent samples
+MannWhitneyResult stats_mann_whitney(
+    double const* first, size_t first_len, double const* second,
+    size_t second_len
+);
+
+/// Small xorshift generator, good enough for shuffling and resampling
+typedef struct StatsRandom {
+    uint64_t state;
+} StatsRandom;
+
+StatsRandom stats_random_new(uint64_t seed);
+
+uint64_t stats_random_next(StatsRandom* self);
+
+/// Uniformly distributed index in `[0, len)`
+size_t stats_random_index(StatsRandom* self, size_t len);
+
+typedef struct StatsInterval {
+    double low;
+    double high;
+} StatsInterval;
+
+/// Percentile bootstrap confidence interval for the ratio of medians
+/// `median(numerator) / median(denominator)` at the given `confidence`, e.g.
+/// `0.95`
+StatsInterval stats_bootstrap_median_ratio(
+    double const* numerator, size_t numerator_len, double const* denominator,
+    size_t denominator_len, double confidence, size_t n_resamples,
+    StatsRandom* random
+);
+
+#endif  // !_SOTEST_STATS_H
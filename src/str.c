@@ -1,3 +1,5 @@
+#define _GNU_SOURCE
+
 #include "str.h"
 
 #include <ctype.h>
@@ -137,22 +139,56 @@ String string_with_capacity(size_t capacity) {
         capacity = STRING_INITIAL_CAPACITY;
     }
 
+    auto ptr = (char*) malloc(capacity * sizeof(char));
+    ptr[0] = '\0';
+
     return (String) {
         .str =
             (Str) {
-                .ptr = calloc(capacity, sizeof(char)),
+                .ptr = ptr,
                 .len = 0,
             },
         .cap = capacity,
     };
 }
 
-void string_push(String* self, char symbol) {
+void string_reserve(String* self, size_t additional) {
+    auto required = self->str.len + additional + 1;
+
+    if (required <= self->cap) {
+        return;
+    }
+
+    auto cap = STRING_GROWTH_RATE * self->cap;
+
+    if (cap < required) {
+        cap = required;
+    }
+
+    if (cap < STRING_INITIAL_CAPACITY) {
+        cap = STRING_INITIAL_CAPACITY;
+    }
+
     if (0 == self->cap) {
-        *self = string_with_capacity(STRING_INITIAL_CAPACITY);
-    } else if (self->str.len + 1 == self->cap) {
-        self->cap *= STRING_GROWTH_RATE * self->cap;
-        self->str.ptr = realloc(self->str.ptr, self->cap * sizeof(char));
+        // Empty or borrowed, the contents are copied into a buffer of its own
+        auto ptr = (char*) malloc(cap * sizeof(char));
+
+        if (0 != self->str.len) {
+            memcpy(ptr, self->str.ptr, self->str.len);
+        }
+
+        self->str.ptr = ptr;
+    } else {
+        self->str.ptr = realloc(self->str.ptr, cap * sizeof(char));
+    }
+
+    self->str.ptr[self->str.len] = '\0';
+    self->cap = cap;
+}
+
+void string_push(String* self, char symbol) {
+    if (self->str.len + 2 > self->cap) {
+        string_reserve(self, 1);
     }
 
     self->str.ptr[self->str.len] = symbol;
@@ -163,60 +199,70 @@ void string_push(String* self, char symbol) {
 char string_pop(String* self) {
     if (0 == self->str.len) {
         return EOF;
-    } else {
-        auto symbol = self->str.ptr[self->str.len - 1];
-        self->str.len -= 1;
-        return symbol;
     }
+
+    // A borrowed string is copied so that the nul byte can be moved
+    string_reserve(self, 0);
+
+    auto symbol = self->str.ptr[self->str.len - 1];
+    self->str.len -= 1;
+    self->str.ptr[self->str.len] = '\0';
+
+    return symbol;
 }
 
 void string_free(String* self) {
-    free(self->str.ptr);
+    if (0 != self->cap) {
+        free(self->str.ptr);
+    }
+
     *self = STRING_EMPTY;
 }
 
 ReadlineStatus string_readline(String* self, FILE* stream) {
+    auto status = READLINE_SUCCESS;
+
+    // One lock for the whole line instead of one per symbol
+    flockfile(stream);
+
     while (true) {
-        auto symbol = fgetc(stream);
+        auto symbol = getc_unlocked(stream);
 
         if (EOF == symbol) {
-            return READLINE_EOF;
+            status = READLINE_EOF;
+            break;
         }
 
         if ('\n' == symbol) {
             break;
         }
 
-        string_push(self, symbol);
+        string_push(self, (char) symbol);
     }
 
-    return READLINE_SUCCESS;
-}
-
-void string_clear(String* self) { self->str.len = 0; }
+    funlockfile(stream);
 
-void string_append(String* self, Str source) {
-    bool needs_allocation = false;
+    return status;
+}
 
-    // Allow the algorithm to find best fit allocation size
+void string_clear(String* self) {
     if (0 == self->cap) {
-        self->cap = 1;
+        // Nothing to reuse, a borrowed buffer is let go
+        *self = STRING_EMPTY;
+        return;
     }
 
-    while (self->str.len + source.len + 1 > self->cap) {
-        needs_allocation = true;
-        self->cap *= STRING_GROWTH_RATE;
-    }
+    self->str.len = 0;
+    self->str.ptr[0] = '\0';
+}
 
-    if (needs_allocation) {
-        if (nullptr == self->str.ptr) {
-            self->str.ptr = calloc(self->cap, sizeof(char));
-        } else {
-            self->str.ptr = realloc(self->str.ptr, self->cap * sizeof(char));
-        }
+void string_append(String* self, Str source) {
+    string_reserve(self, source.len);
+
+    if (0 != source.len) {
+        memcpy(self->str.ptr + self->str.len, source.ptr, source.len);
     }
 
-    memcpy(self->str.ptr + self->str.len, source.ptr, source.len);
     self->str.len += source.len;
     self->str.ptr[self->str.len] = '\0';
 }
@@ -281,7 +327,15 @@ int str_compare(Str const* a, Str const* b) {
     auto first = (Str const*) a;
     auto second = (Str const*) b;
 
-    return strcmp(first->ptr ? first->ptr : "", second->ptr ? second->ptr : "");
+    // Slices are not nul-terminated in general, so compare by length
+    auto min_len = first->len < second->len ? first->len : second->len;
+    auto result = 0 == min_len ? 0 : memcmp(first->ptr, second->ptr, min_len);
+
+    if (0 != result) {
+        return result;
+    }
+
+    return (first->len > second->len) - (first->len < second->len);
 }
 
 size_t str_hash(Str const* item) {
@@ -61,7 +61,9 @@ int str_compare(Str const* a, Str const* b);
 ///
 /// # Note
 ///
-/// `.str.len` does not count for nul-byte
+/// `.str.len` does not count for nul-byte. A string with `.cap` of 0 owns no
+/// buffer: it is empty or borrows its contents, e.g. from an `Arena`, and
+/// copies them into a buffer of its own on the first change.
 typedef struct String {
     Str str;
     /// Internal buffer capacity (includes nul byte)
@@ -75,6 +77,12 @@ size_t constexpr STRING_INITIAL_CAPACITY = 16;
 /// Heap-allocated string with (at least) initial capacity
 String string_with_capacity(size_t capacity);
 
+/// Makes room for `additional` more bytes and the nul byte. The capacity
+/// grows at least `STRING_GROWTH_RATE` times, so that pushes and appends
+/// are amortized O(1).
+void string_reserve(String* self, size_t additional);
+
+/// Empties the string, the buffer is kept for the next contents
 void string_clear(String* self);
 
 void string_push(String* self, char symbol);
@@ -0,0 +1,84 @@
+#include "typed.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+Str typed_type_name(JitType type) {
+    switch (type) {
+    case JIT_TYPE_VOID:
+        return Str("void");
+    case JIT_TYPE_I32:
+        return Str("i32");
+    case JIT_TYPE_I64:
+        return Str("i64");
+    case JIT_TYPE_U32:
+        return Str("u32");
+    case JIT_TYPE_U64:
+        return Str("u64");
+    case JIT_TYPE_F32:
+        return Str("f32");
+    case JIT_TYPE_F64:
+        return Str("f64");
+    }
+
+    return Str("unknown");
+}
+
+JitValue typed_value_normalize(JitValue value, JitType type) {
+    switch (type) {
+    case JIT_TYPE_VOID:
+        return (JitValue) {};
+    case JIT_TYPE_I32:
+        return (JitValue) {.i64 = (int32_t) value.i64};
+    case JIT_TYPE_U32:
+        return (JitValue) {.u64 = (uint32_t) value.u64};
+    case JIT_TYPE_F32:
+        return (JitValue) {.f32 = value.f32};
+    case JIT_TYPE_I64:
+    case JIT_TYPE_U64:
+    case JIT_TYPE_F64:
+        break;
+    }
+
+    return value;
+}
+
+bool typed_value_eq(JitValue a, JitValue b, JitType type) {
+    switch (type) {
+    case JIT_TYPE_VOID:
+        return true;
+    case JIT_TYPE_I32:
+    case JIT_TYPE_I64:
+        return a.i64 == b.i64;
+    case JIT_TYPE_U32:
+    case JIT_TYPE_U64:
+        return a.u64 == b.u64;
+    case JIT_TYPE_F32:
+        return a.f32 == b.f32;
+    case JIT_TYPE_F64:
+        return a.f64 == b.f64;
+    }
+
+    return false;
+}
+
+int typed_value_format(
+    JitValue value, JitType type, char* buffer, size_t size
+) {
+    switch (type) {
+    case JIT_TYPE_VOID:
+        return snprintf(buffer, size, "void");
+    case JIT_TYPE_I32:
+    case JIT_TYPE_I64:
+        return snprintf(buffer, size, "%" PRId64, value.i64);
+    case JIT_TYPE_U32:
+    case JIT_TYPE_U64:
+        return snprintf(buffer, size, "%" PRIu64, value.u64);
+    case JIT_TYPE_F32:
+        return snprintf(buffer, size, "%.9g", (double) value.f32);
+    case JIT_TYPE_F64:
+        return snprintf(buffer, size, "%.17g", value.f64);
+    }
+
+    return snprintf(buffer, size, "?");
+}
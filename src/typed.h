@@ -0,0 +1,37 @@
+#ifndef _SOTEST_TYPED_H
+#define _SOTEST_TYPED_H
+
+#include "str.h"
+#include "jit.h"
+
+#include <stddef.h>
+
+/// Parsed `(<type> <value>, ...) -> <type> = <value>` of a typed call
+typedef struct TypedCall {
+    JitSignature signature;
+    JitValue arguments[JIT_MAX_ARGUMENTS];
+    /// Set by `= <value>`, the result must equal `expected`
+    bool has_expected;
+    /// Available only if `has_expected == true`
+    JitValue expected;
+} TypedCall;
+
+/// Name of the type as written in scripts, e.g. `i64`
+Str typed_type_name(JitType type);
+
+/// Drops the bits of a returned value the type does not cover, e.g. the
+/// upper half of `rax` for `i32`
+JitValue typed_value_normalize(JitValue value, JitType type);
+
+/// `==` on the type, so a `NaN` never equals anything
+bool typed_value_eq(JitValue a, JitValue b, JitType type);
+
+/// Formats the value with `snprintf`, floating-point values with enough
+/// digits to be read back exactly
+///
+/// # Return
+///
+/// The result of `snprintf`
+int typed_value_format(JitValue value, JitType type, char* buffer, size_t size);
+
+#endif  // !_SOTEST_TYPED_H
@@ -0,0 +1,81 @@
+#include "libtest/macros.h"
+
+#include <arena.h>
+#include <assert.h>
+#include <interpreter.h>
+#include <stdint.h>
+#include <string.h>
+
+TEST(arena_alloc_aligned) {
+    auto arena = ARENA_EMPTY;
+
+    for (size_t size = 0; size < 40; ++size) {
+        auto ptr = arena_alloc(&arena, size);
+        assert(0 == (uintptr_t) ptr % alignof(max_align_t));
+    }
+
+    assert(1 == arena.n_blocks);
+
+    // Larger than a block, gets one of its own
+    auto large = (char*) arena_alloc(&arena, 2 * ARENA_BLOCK_SIZE);
+    memset(large, 1, 2 * ARENA_BLOCK_SIZE);
+    assert(2 == arena.n_blocks);
+
+    arena_free(&arena);
+    assert(nullptr == arena.head);
+    assert(0 == arena.n_bytes);
+}
+
+TEST(arena_copy) {
+    auto arena = ARENA_EMPTY;
+    auto source = Str("foo # comment");
+
+    auto copy = arena_copy(&arena, str_slice(source, 0, 3));
+    assert(str_eq(copy, Str("foo")));
+    assert('\0' == copy.ptr[3]);
+
+    auto empty = arena_copy_string(&arena, STR_NULL);
+    assert(0 == empty.str.len);
+    assert(0 == empty.cap);
+    assert('\0' == empty.str.ptr[0]);
+
+    arena_free(&arena);
+}
+
+TEST(arena_rewind) {
+    auto arena = ARENA_EMPTY;
+    arena_copy(&arena, Str("kept"));
+
+    auto mark = arena_mark(&arena);
+
+    for (size_t i = 0; i < 4; ++i) {
+        arena_alloc(&arena, ARENA_BLOCK_SIZE / 2);
+    }
+
+    assert(3 <= arena.n_blocks);
+
+    arena_rewind(&arena, mark);
+    assert(1 == arena.n_blocks);
+    assert(mark.n_bytes == arena.n_bytes);
+
+    // The space is reused
+    auto copy = arena_copy(&arena, Str("next"));
+    assert(mark.block->data + mark.len == copy.ptr);
+
+    arena_free(&arena);
+}
+
+TEST(arena_executor_failed_lookup) {
+    auto executor = executor_new();
+    executor_load_library(&executor, Str("build/libtest1.so"));
+
+    auto before = executor.arena.n_bytes;
+    assert(0 < before);
+
+    auto result = executor_resolve_function(&executor, Str("missing"));
+    assert(EXECUTOR_FIND_SYMBOL_FAILED == result.result.status);
+    assert(before == executor.arena.n_bytes);
+
+    executor_free(&executor);
+    assert(0 == executor.arena.n_blocks);
+}
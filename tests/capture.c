@@ -0,0 +1,76 @@
+#include "libtest/macros.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <capture.h>
+
+TEST(capture_expect) {
+    char path[] = "/tmp/sotest-capture-XXXXXX";
+    auto fd = mkstemp(path);
+    assert(fd >= 0);
+
+    fflush(stdout);
+    auto stdout_fd = dup(STDOUT_FILENO);
+    dup2(fd, STDOUT_FILENO);
+
+    auto map = tmpfile();
+    Capture capture;
+    assert(capture_start(&capture, map));
+
+    capture_begin(&capture);
+    printf("hello\n");
+    capture_end(&capture, 1, Str("call hello"));
+
+    auto expected = murmur_hash("hello\n", 6, 0);
+    assert(EXECUTOR_SUCCESS == capture_expect(&capture, expected).status);
+
+    auto result = capture_expect(&capture, expected + 1);
+    assert(EXECUTOR_ASSERTION_FAILED == result.status);
+    assert(str_starts_with(result.dl_error, Str("output of line 1 (6 bytes)")));
+
+    // Output of commands in between is not part of the next one
+    printf("prompt ");
+    capture_begin(&capture);
+    capture_end(&capture, 2, Str("call silent"));
+
+    assert(
+        EXECUTOR_SUCCESS ==
+        capture_expect(&capture, murmur_hash("", 0, 0)).status
+    );
+
+    capture_begin(&capture);
+    printf("world\n");
+    capture_end(&capture, 3, Str("call world"));
+    capture_stop(&capture);
+
+    fflush(stdout);
+    dup2(stdout_fd, STDOUT_FILENO);
+    close(stdout_fd);
+
+    char output[64] = {};
+    assert(19 == pread(fd, output, sizeof(output), 0));
+    assert(0 == strcmp(output, "hello\nprompt world\n"));
+    close(fd);
+    unlink(path);
+
+    char records[128] = {};
+    rewind(map);
+    fread(records, 1, sizeof(records) - 1, map);
+    fclose(map);
+
+    assert(
+        0 == strcmp(records, "0\t6\t1\tcall hello\n13\t6\t3\tcall world\n")
+    );
+}
+
+TEST(capture_expect_inactive) {
+    Capture capture = {};
+
+    auto result = capture_expect(&capture, 0);
+    assert(EXECUTOR_ASSERTION_FAILED == result.status);
+    assert(str_eq(
+        result.dl_error, Str("output is not captured, run with `--capture`")
+    ));
+}
@@ -0,0 +1,81 @@
+#include "libtest/macros.h"
+
+#include <assert.h>
+#include <check.h>
+#include <stdlib.h>
+
+static size_t check_source(Str source, char** report) {
+    auto input = fmemopen(source.ptr, source.len, "r");
+    size_t report_len = 0;
+    auto output = open_memstream(report, &report_len);
+
+    auto n_problems = check_script(input, Str("script.sc"), output);
+
+    fclose(output);
+    fclose(input);
+
+    return n_problems;
+}
+
+TEST(check_valid_script) {
+    char* report = nullptr;
+    auto n_problems = check_source(
+        Str("use build/libtest1.so\n"
+            "call foo # comment\n"
+            "\n"
+            "use build/libtest2.so\n"
+            "call qux\n"),
+        &report
+    );
+
+    assert(0 == n_problems);
+    assert(0 == strlen(report));
+
+    free(report);
+}
+
+TEST(check_invalid_script) {
+    char* report = nullptr;
+    auto n_problems = check_source(
+        Str("call foo\n"
+            "use build/libtest1.so\n"
+            "call qux\n"
+            "use build/nonexistent.so\n"
+            "use examples/simple.sc\n"
+            "call @\n"
+            "use build/libtest2.so\n"
+            "call qux\n"),
+        &report
+    );
+
+    assert(5 == n_problems);
+    assert(strstr(report, "script.sc:1: EXECUTOR_LIBRARY_NOT_LOADED"));
+    assert(strstr(report, "script.sc:3: EXECUTOR_FIND_SYMBOL_FAILED"));
+    assert(strstr(report, "script.sc:4: EXECUTOR_LOAD_FAILED"));
+    assert(strstr(report, "script.sc:5: EXECUTOR_LOAD_FAILED"));
+    assert(strstr(report, "script.sc:6: syntax error"));
+    assert(!strstr(report, "script.sc:8"));
+
+    free(report);
+}
+
+TEST(check_qualified_calls) {
+    char* report = nullptr;
+    auto n_problems = check_source(
+        Str("use build/libtest2.so as test2\n"
+            "call test2.qux\n"
+            "call qux\n"
+            "call test1.foo\n"
+            "call test2.nonexistent\n"
+            "use build/libtest1.so as test2\n"),
+        &report
+    );
+
+    assert(4 == n_problems);
+    assert(strstr(report, "script.sc:3: EXECUTOR_LIBRARY_NOT_LOADED"));
+    assert(strstr(report, "script.sc:4: EXECUTOR_LIBRARY_NOT_LOADED"));
+    assert(strstr(report, "script.sc:5: EXECUTOR_FIND_SYMBOL_FAILED"));
+    assert(strstr(report, "script.sc:6: EXECUTOR_LOAD_FAILED"));
+
+    free(report);
+}
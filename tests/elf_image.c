@@ -0,0 +1,73 @@
+#include "libtest/macros.h"
+
+#include <assert.h>
+#include <elf_image.h>
+
+TEST(elf_image_open) {
+    auto r = elf_image_open(Str("build/libtest1.so"));
+
+    assert(r.status == ELF_SUCCESS);
+    assert(r.value.n_symbols > 0);
+
+    elf_image_free(&r.value);
+}
+
+TEST(elf_image_open_failures) {
+    auto r = elf_image_open(Str("build/nonexistent.so"));
+
+    assert(r.status == ELF_OPEN_FAILED);
+    assert(r.error.len > 0);
+
+    r = elf_image_open(Str("examples/simple.sc"));
+
+    assert(r.status == ELF_INVALID);
+
+    r = elf_image_open(Str("build/"));
+
+    assert(r.status == ELF_INVALID);
+}
+
+TEST(elf_image_exports) {
+    auto r = elf_image_open(Str("build/libtest1.so"));
+    assert(r.status == ELF_SUCCESS);
+
+    assert(elf_image_exports(&r.value, Str("foo")));
+    assert(elf_image_exports(&r.value, Str("bar")));
+    assert(elf_image_exports(&r.value, Str("baz")));
+    assert(!elf_image_exports(&r.value, Str("qux")));
+    assert(!elf_image_exports(&r.value, Str("fo")));
+    assert(!elf_image_exports(&r.value, Str("foobar")));
+
+    // Imported, not defined by the library
+    assert(!elf_image_exports(&r.value, Str("printf")));
+
+    elf_image_free(&r.value);
+
+    r = elf_image_open(Str("build/libtest2.so"));
+    assert(r.status == ELF_SUCCESS);
+
+    assert(elf_image_exports(&r.value, Str("qux")));
+
+    elf_image_free(&r.value);
+}
+
+TEST(elf_image_build_id) {
+    auto r = elf_image_open(Str("build/libtest1.so"));
+    assert(r.status == ELF_SUCCESS);
+    assert(nullptr != r.value.build_id && r.value.build_id_len > 0);
+
+    auto hex = STRING_EMPTY;
+    elf_image_build_id_hex(&r.value, &hex);
+
+    assert(hex.str.len == 2 * r.value.build_id_len);
+    assert(strspn(hex.str.ptr, "0123456789abcdef") == hex.str.len);
+
+    string_free(&hex);
+    elf_image_free(&r.value);
+
+    auto other = elf_image_open(Str("build/libtest2.so"));
+    assert(other.status == ELF_SUCCESS);
+    assert(nullptr != other.value.build_id);
+
+    elf_image_free(&other.value);
+}
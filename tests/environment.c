@@ -0,0 +1,77 @@
+#define _GNU_SOURCE
+
+#include "libtest/macros.h"
+
+#include <assert.h>
+#include <dlfcn.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <environment.h>
+
+TEST(environment_pins_to_cpus) {
+    // CI may run in a cpuset without cpu 0, pin to the first one allowed
+    cpu_set_t allowed;
+    assert(0 == sched_getaffinity(0, sizeof(allowed), &allowed));
+
+    int cpu = 0;
+
+    while (!CPU_ISSET(cpu, &allowed)) {
+        cpu += 1;
+    }
+
+    char cpus[16];
+    snprintf(cpus, sizeof(cpus), "%d", cpu);
+
+    auto environment = environment_setup((EnvironmentOptions) {
+        .cpus = str_from_ptr(cpus),
+    });
+
+    cpu_set_t set;
+    assert(0 == sched_getaffinity(0, sizeof(set), &set));
+    assert(1 == CPU_COUNT(&set) && CPU_ISSET(cpu, &set));
+
+    environment_free(&environment);
+    assert(0 == sched_setaffinity(0, sizeof(allowed), &allowed));
+}
+
+TEST(environment_prefaults_libraries) {
+    auto environment = environment_setup((EnvironmentOptions) {
+        .lock_memory = true,
+        .warmup_ms = 1,
+    });
+
+    environment_prefault_libraries(&environment);
+    auto adds = environment.prefaulted_adds;
+
+    auto handle = dlopen("build/libtest1.so", RTLD_NOW);
+    assert(nullptr != handle);
+
+    environment_prefault_libraries(&environment);
+    assert(environment.prefaulted_adds > adds);
+
+    dlclose(handle);
+    environment_free(&environment);
+}
+
+TEST(environment_noise_report) {
+    auto environment = environment_setup((EnvironmentOptions) {});
+    string_append(&environment.noise, Str("noise: first\nnoise: second\n"));
+
+    char* report = nullptr;
+    size_t report_size = 0;
+    auto stream = open_memstream(&report, &report_size);
+
+    environment_write_noise(&environment, "  ", stream);
+    fclose(stream);
+
+    // Only check the lines appended above, the host may add its own
+    assert(nullptr != strstr(report, "  noise: first\n  noise: second\n"));
+
+    for (auto line = report; '\0' != *line; line = strchr(line, '\n') + 1) {
+        assert(str_starts_with(str_from_ptr(line), Str("  noise: ")));
+    }
+
+    free(report);
+    environment_free(&environment);
+}
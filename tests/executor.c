@@ -1,6 +1,8 @@
 #include "libtest/macros.h"
 
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 #include <interpreter.h>
 #include <parse.h>
 
@@ -191,3 +193,283 @@ TEST(executor_malformed_paths) {
 
     executor_free(&executor);
 }
+
+TEST(executor_lazy_load_library) {
+    auto executor = executor_with_options((ExecutorOptions) {.is_lazy = true});
+
+    auto r = executor_load_library(&executor, Str("build/libtest1.so"));
+    assert(r.status == EXECUTOR_SUCCESS);
+    assert(executor.deferred.len == 1);
+    assert(executor.deferred.ptr[0].handle == nullptr);
+
+    r = executor_load_library(&executor, Str("build/libtest1.so"));
+    assert(r.status == EXECUTOR_SUCCESS);
+    assert(executor.deferred.len == 1);
+
+    r = executor_load_library(&executor, Str("build/nonexistent.so"));
+    assert(r.status == EXECUTOR_LOAD_FAILED);
+    assert(r.dl_error.len > 0);
+
+    executor_free(&executor);
+}
+
+TEST(executor_lazy_call_function) {
+    auto executor = executor_with_options((ExecutorOptions) {.is_lazy = true});
+
+    auto r = executor_call_function(&executor, Str("foo"));
+    assert(r.status == EXECUTOR_LIBRARY_NOT_LOADED);
+
+    r = executor_load_library(&executor, Str("build/libtest1.so"));
+    assert(r.status == EXECUTOR_SUCCESS);
+
+    r = executor_load_library(&executor, Str("build/libtest2.so"));
+    assert(r.status == EXECUTOR_SUCCESS);
+
+    // Only the second library is opened
+    r = executor_call_function(&executor, Str("qux"));
+    assert(r.status == EXECUTOR_SUCCESS);
+    assert(executor.deferred.ptr[0].handle == nullptr);
+    assert(executor.deferred.ptr[1].handle != nullptr);
+
+    // The first `use` takes precedence
+    r = executor_call_function(&executor, Str("foo"));
+    assert(r.status == EXECUTOR_SUCCESS);
+    assert(executor.deferred.ptr[0].handle != nullptr);
+
+    r = executor_call_function(&executor, Str("nonexistent_function"));
+    assert(r.status == EXECUTOR_FIND_SYMBOL_FAILED);
+
+    executor_free(&executor);
+}
+
+TEST(executor_load_library_as) {
+    auto executor = executor_new();
+
+    auto r = executor_load_library_as(
+        &executor, Str("build/libtest1.so"), Str("test1"), false
+    );
+    assert(r.status == EXECUTOR_SUCCESS);
+
+    r = executor_load_library_as(
+        &executor, Str("build/libtest1.so"), Str("test1"), false
+    );
+    assert(r.status == EXECUTOR_SUCCESS);
+
+    r = executor_load_library_as(
+        &executor, Str("build/libtest2.so"), Str("test1"), false
+    );
+    assert(r.status == EXECUTOR_LOAD_FAILED);
+
+    r = executor_load_library_as(
+        &executor, Str("build/nonexistent.so"), Str("test3"), false
+    );
+    assert(r.status == EXECUTOR_LOAD_FAILED);
+    assert(r.dl_error.len > 0);
+
+    // Aliased libraries are not used for unqualified calls
+    r = executor_call_function(&executor, Str("foo"));
+    assert(r.status == EXECUTOR_LIBRARY_NOT_LOADED);
+
+    executor_free(&executor);
+}
+
+TEST(executor_call_qualified_function) {
+    auto executor = executor_new();
+
+    auto r = executor_load_library(&executor, Str("build/libtest1.so"));
+    assert(r.status == EXECUTOR_SUCCESS);
+
+    r = executor_load_library_as(
+        &executor, Str("build/libtest2.so"), Str("test2"), false
+    );
+    assert(r.status == EXECUTOR_SUCCESS);
+
+    r = executor_call_qualified_function(&executor, Str("test2.foo"));
+    assert(r.status == EXECUTOR_SUCCESS);
+
+    r = executor_call_qualified_function(&executor, Str("test2.foo"));
+    assert(r.status == EXECUTOR_SUCCESS);
+
+    r = executor_call_qualified_function(&executor, Str("test2.nonexistent"));
+    assert(r.status == EXECUTOR_FIND_SYMBOL_FAILED);
+
+    r = executor_call_qualified_function(&executor, Str("test3.foo"));
+    assert(r.status == EXECUTOR_LIBRARY_NOT_LOADED);
+
+    // Unqualified calls do not see the aliased library
+    r = executor_call_function(&executor, Str("qux"));
+    assert(r.status == EXECUTOR_FIND_SYMBOL_FAILED);
+
+    executor_free(&executor);
+}
+
+TEST(executor_call_isolated_function) {
+    auto executor = executor_new();
+
+    auto r = executor_load_library_as(
+        &executor, Str("build/libtest1.so"), Str("test1"), true
+    );
+    assert(r.status == EXECUTOR_SUCCESS);
+
+    r = executor_call_qualified_function(&executor, Str("test1.bar"));
+    assert(r.status == EXECUTOR_SUCCESS);
+
+    executor_free(&executor);
+}
+
+BENCH(executor_call_cached_function) {
+    auto executor = executor_new();
+    executor_load_library(&executor, Str("build/libtest1.so"));
+
+    // Resolved through the library's dependencies, does no work itself
+    auto name = Str("__errno_location");
+    executor_call_function(&executor, name);
+
+    BENCH_LOOP {
+        black_box(executor_call_function(&executor, black_box(name)));
+    }
+
+    executor_free(&executor);
+}
+
+BENCH(executor_load_library) {
+    BENCH_LOOP {
+        auto executor = executor_new();
+        black_box(executor_load_library(&executor, Str("build/libtest1.so")));
+        executor_free(&executor);
+    }
+}
+
+TEST(executor_run_procedure) {
+    auto executor = executor_new();
+
+    auto procedure = executor_define_procedure(&executor, Str("workload"));
+    procedure_add_call(procedure, Str("foo"), false);
+    procedure_add_call(procedure, Str("test2.qux"), true);
+
+    assert(procedure == executor_find_procedure(&executor, Str("workload")));
+    assert(nullptr == executor_find_procedure(&executor, Str("other")));
+
+    // Calls resolve when the procedure runs, not when it is defined
+    auto result = executor_run_procedure(&executor, Str("workload"));
+    assert(EXECUTOR_LIBRARY_NOT_LOADED == result.status);
+    assert(str_starts_with(result.dl_error, Str("foo: ")));
+    assert(0 == procedure->n_functions);
+
+    assert(
+        EXECUTOR_SUCCESS ==
+        executor_load_library(&executor, Str("build/libtest1.so")).status
+    );
+
+    result = executor_run_procedure(&executor, Str("workload"));
+    assert(EXECUTOR_LIBRARY_NOT_LOADED == result.status);
+    assert(str_starts_with(result.dl_error, Str("test2.qux: ")));
+    assert(1 == procedure->n_functions);
+
+    // Loading a library makes the next run resolve the calls again
+    auto load_result = executor_load_library_as(
+        &executor, Str("build/libtest2.so"), Str("test2"), false
+    );
+    assert(EXECUTOR_SUCCESS == load_result.status);
+
+    result = executor_run_procedure(&executor, Str("workload"));
+    assert(EXECUTOR_SUCCESS == result.status);
+    assert(2 == procedure->n_functions);
+    assert(executor.generation == procedure->generation);
+
+    // A redefinition replaces the calls
+    assert(
+        procedure == executor_define_procedure(&executor, Str("workload"))
+    );
+    assert(0 == procedure->len);
+
+    result = executor_run_procedure(&executor, Str("missing"));
+    assert(EXECUTOR_FIND_SYMBOL_FAILED == result.status);
+
+    executor_free(&executor);
+}
+
+TEST(executor_call_typed) {
+    auto executor = executor_new();
+    auto load_result =
+        executor_load_library(&executor, Str("build/libtest1.so"));
+    assert(EXECUTOR_SUCCESS == load_result.status);
+
+    auto call = (TypedCall) {};
+    assert(parse_typed_call(Str("(i32 3, f64 0.5, u32 2, f32 1) -> f32"), &call)
+               .has_value);
+
+    auto resolved = executor_resolve_function(&executor, Str("mix"));
+    assert(EXECUTOR_SUCCESS == resolved.result.status);
+
+    auto value = (JitValue) {};
+    auto result = executor_call_typed(
+        &executor, Str("mix"), &resolved, &call, &value
+    );
+
+#if defined(__x86_64__) && defined(__linux__)
+    assert(EXECUTOR_SUCCESS == result.status);
+    assert(8.0f == value.f32);
+
+    // The stub is compiled once per signature
+    auto stub = executor_resolve_stub(&executor, &call.signature);
+    assert(stub == executor_resolve_stub(&executor, &call.signature));
+#else
+    assert(EXECUTOR_STUB_FAILED == result.status);
+#endif
+
+    // The function is not called without a stub
+    auto interpreted = executor_with_options((ExecutorOptions) {
+        .is_jit_disabled = true,
+    });
+    result = executor_call_typed(
+        &interpreted, Str("mix"), &resolved, &call, &value
+    );
+    assert(EXECUTOR_STUB_FAILED == result.status);
+
+    executor_free(&interpreted);
+    executor_free(&executor);
+}
+
+TEST(executor_call_stats) {
+    auto executor = executor_new();
+    executor_load_library(&executor, Str("build/libtest1.so"));
+
+    // The first call and one in every period are timed
+    for (size_t i = 0; i < CALL_STATS_PERIOD + 1; ++i) {
+        auto result = executor_call_function(&executor, Str("foo"));
+        assert(EXECUTOR_SUCCESS == result.status);
+    }
+
+    // Procedure calls are counted, not timed
+    auto procedure = executor_define_procedure(&executor, Str("both"));
+    procedure_add_call(procedure, Str("foo"), false);
+    procedure_add_call(procedure, Str("bar"), false);
+
+    auto result = executor_run_procedure(&executor, Str("both"));
+    assert(EXECUTOR_SUCCESS == result.status);
+
+    auto foo = executor_resolve_function(&executor, Str("foo")).stats;
+    assert(CALL_STATS_PERIOD + 2 == foo->n_calls);
+    assert(2 == foo->n_timed);
+    assert(0 != foo->max_cycles);
+    assert(foo->max_cycles <= foo->total_cycles);
+
+    auto bar = executor_resolve_function(&executor, Str("bar")).stats;
+    assert(1 == bar->n_calls);
+    assert(0 == bar->n_timed);
+
+    char* report = nullptr;
+    size_t report_size = 0;
+    auto stream = open_memstream(&report, &report_size);
+    executor_write_call_stats(&executor, stream);
+    fclose(stream);
+
+    // The longest total time first
+    auto foo_row = strstr(report, "\n  foo ");
+    auto bar_row = strstr(report, "\n  bar ");
+    assert(nullptr != foo_row && nullptr != bar_row && foo_row < bar_row);
+
+    free(report);
+    executor_free(&executor);
+}
@@ -0,0 +1,103 @@
+#include "libtest/macros.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <program.h>
+
+TEST(footprint_sample_heap) {
+    FootprintSample before;
+    assert(footprint_sample(&before));
+    assert(0 < before.rss);
+    assert(before.rss == before.anonymous + before.file);
+
+    auto block = (char*) malloc(1 << 20);
+    memset(block, 1, 1 << 20);
+
+    FootprintSample after;
+    assert(footprint_sample(&after));
+    assert(after.heap - before.heap >= 1 << 20);
+    assert(after.anonymous - before.anonymous >= 1 << 20);
+
+    free(block);
+}
+
+TEST(footprint_executor_calls) {
+    auto footprint = (Footprint) {};
+    footprint_start(&footprint, 4, 512, nullptr);
+
+    auto executor = executor_with_options((ExecutorOptions) {
+        .footprint = &footprint,
+    });
+
+    assert(
+        EXECUTOR_SUCCESS ==
+        executor_load_library(&executor, Str("build/libtest1.so")).status
+    );
+    assert(1 == footprint.libraries.len);
+    assert(1 == footprint.libraries.ptr[0].usage.n_samples);
+
+    // Calls 0, 4 and 8 are sampled, the first only as a one-off
+    for (size_t i = 0; i < 9; ++i) {
+        auto result = executor_call_function(&executor, Str("leak"));
+        assert(EXECUTOR_SUCCESS == result.status);
+    }
+
+    auto leak = executor_resolve_function(&executor, Str("leak")).stats;
+    assert(3 == leak->memory.n_samples);
+    assert(2 == leak->memory.n_calls);
+    assert(2 * 256 <= leak->memory.growth.heap);
+
+    int64_t growth = 0;
+    assert(footprint_usage_rate(&footprint, &leak->memory, &growth));
+    assert(4 * 256 <= growth);
+    assert(0 == strcmp("leak", footprint.exceeded.str.ptr));
+
+    char* report = nullptr;
+    size_t report_size = 0;
+    auto stream = open_memstream(&report, &report_size);
+    executor_write_memory_report(&executor, stream);
+    fclose(stream);
+
+    assert(nullptr != strstr(report, "\n  build/libtest1.so "));
+    assert(nullptr != strstr(report, "\n  leak "));
+
+    free(report);
+    executor_free(&executor);
+    footprint_free(&footprint);
+}
+
+TEST(footprint_program_periods) {
+    auto footprint = (Footprint) {};
+    footprint_start(&footprint, 4, 0, nullptr);
+
+    auto executor = executor_with_options((ExecutorOptions) {
+        .footprint = &footprint,
+    });
+    executor_load_library(&executor, Str("build/libtest1.so"));
+
+    // Sampled from call 0 to 4, 4 to 8 and 8 to the end, never compiled
+    auto program = PROGRAM_EMPTY;
+    auto repeat = (Command) {
+        .type = COMMAND_TYPE_REPEAT,
+        .count = 10,
+        .body = Str("call leak"),
+    };
+    assert(PROGRAM_ADDED == program_add(&program, &executor, &repeat).status);
+    assert(nullptr == program.ptr[0].jit.entry);
+    program_run(&program);
+    program_free(&program);
+
+    auto leak = executor_resolve_function(&executor, Str("leak")).stats;
+    assert(10 == leak->n_calls);
+    assert(3 == leak->memory.n_samples);
+    assert(6 == leak->memory.n_calls);
+    assert(6 * 256 <= leak->memory.growth.heap);
+
+    // No limit, nothing exceeded
+    assert(0 == footprint.exceeded.str.len);
+
+    executor_free(&executor);
+    footprint_free(&footprint);
+}
@@ -0,0 +1,83 @@
+#include "libtest/macros.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <history.h>
+
+static HistoryRecord history_test_record(double median) {
+    return (HistoryRecord) {
+        .time = 1700000000,
+        .function = Str("foo"),
+        .library = Str("build/libtest1.so"),
+        .build_id = Str("0123abcd"),
+        .host = Str("0011223344556677"),
+        .n_samples = 100,
+        .summary =
+            (CompareSummary) {
+                .median = median,
+                .p90 = median * 1.1,
+                .p99 = median * 1.5,
+                .mean = median * 1.05,
+            },
+    };
+}
+
+TEST(history_host_fingerprint) {
+    auto first = STRING_EMPTY;
+    auto second = STRING_EMPTY;
+
+    history_host_fingerprint(&first);
+    history_host_fingerprint(&second);
+
+    assert(16 == first.str.len);
+    assert(str_eq(first.str, second.str));
+
+    string_free(&second);
+    string_free(&first);
+}
+
+TEST(history_baseline) {
+    char path[] = "/tmp/sotest-history-XXXXXX";
+    close(mkstemp(path));
+    auto path_str = str_from_ptr(path);
+
+    auto record = history_test_record(100.0);
+    assert(0 == history_baseline(path_str, &record, 10.0).n_records);
+
+    double medians[] = {100.0, 102.0, 98.0, 101.0, 99.0, 500.0};
+
+    for (size_t i = 0; i < sizeof(medians) / sizeof(*medians); ++i) {
+        record = history_test_record(medians[i]);
+        assert(history_append(path_str, &record));
+    }
+
+    // Other functions and hosts are not part of the baseline
+    record = history_test_record(1.0);
+    record.function = Str("bar");
+    assert(history_append(path_str, &record));
+
+    record = history_test_record(1.0);
+    record.host = Str("7766554433221100");
+    assert(history_append(path_str, &record));
+
+    record = history_test_record(100.0);
+    auto baseline = history_baseline(path_str, &record, 10.0);
+
+    // The outlier moves neither the median nor the MAD much
+    assert(6 == baseline.n_records);
+    assert(100.5 == baseline.median);
+    assert(baseline.mad < 5.0);
+    assert(baseline.threshold >= 110.0 && baseline.threshold < 120.0);
+
+    unlink(path);
+}
+
+TEST(history_missing_file) {
+    auto record = history_test_record(100.0);
+    auto baseline =
+        history_baseline(Str("/nonexistent/history"), &record, 10.0);
+
+    assert(0 == baseline.n_records);
+    assert(!history_append(Str("/nonexistent/history"), &record));
+}
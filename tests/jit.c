@@ -0,0 +1,110 @@
+#include "libtest/macros.h"
+
+#include <assert.h>
+#include <jit.h>
+#include <interpreter.h>
+
+static size_t jit_test_value;
+
+static void jit_test_increment() { jit_test_value += 1; }
+
+static void jit_test_double() { jit_test_value *= 2; }
+
+TEST(jit_compile) {
+    JitFunction functions[] = {jit_test_increment, jit_test_double};
+    auto code = jit_compile(functions, 2, 3);
+
+#if defined(__x86_64__) && defined(__linux__)
+    assert(nullptr != code.entry);
+#else
+    assert(nullptr == code.entry);
+    return;
+#endif
+
+    // The calls run in order, the whole list `count` times
+    jit_test_value = 0;
+    code.entry();
+    assert(14 == jit_test_value);
+
+    jit_free(&code);
+    assert(nullptr == code.entry);
+
+    assert(nullptr == jit_compile(functions, 0, 3).entry);
+    assert(nullptr == jit_compile(functions, 2, 0).entry);
+}
+
+TEST(jit_procedure) {
+    auto executor = executor_new();
+    auto interpreted = executor_with_options((ExecutorOptions) {
+        .is_jit_disabled = true,
+    });
+
+    Executor* executors[] = {&executor, &interpreted};
+
+    for (size_t i = 0; i < 2; ++i) {
+        auto load_result =
+            executor_load_library(executors[i], Str("build/libtest1.so"));
+        assert(EXECUTOR_SUCCESS == load_result.status);
+
+        auto procedure = executor_define_procedure(executors[i], Str("p"));
+        procedure_add_call(procedure, Str("foo"), false);
+        procedure_add_call(procedure, Str("bar"), false);
+
+        auto result = executor_run_procedure(executors[i], Str("p"));
+        assert(EXECUTOR_SUCCESS == result.status);
+        assert(2 == procedure->n_functions);
+
+#if defined(__x86_64__) && defined(__linux__)
+        assert((0 == i) == (nullptr != procedure->jit.entry));
+#endif
+    }
+
+    executor_free(&interpreted);
+    executor_free(&executor);
+}
+
+static int64_t jit_test_sum(int32_t a, double b, uint64_t c, float d) {
+    return a + (int64_t) b + (int64_t) c + (int64_t) d;
+}
+
+static double jit_test_scale(double x, float factor) { return x * factor; }
+
+TEST(jit_compile_stub) {
+    auto signature = (JitSignature) {
+        .arguments = {JIT_TYPE_I32, JIT_TYPE_F64, JIT_TYPE_U64, JIT_TYPE_F32},
+        .n_arguments = 4,
+        .result = JIT_TYPE_I64,
+    };
+    auto code = jit_compile_stub(&signature);
+
+#if defined(__x86_64__) && defined(__linux__)
+    assert(nullptr != code.entry);
+#else
+    assert(nullptr == code.entry);
+    return;
+#endif
+
+    // Integer and floating-point registers are counted separately
+    JitValue arguments[] = {
+        {.i64 = -1},
+        {.f64 = 2.5},
+        {.u64 = 10},
+        {.f32 = 4.0f},
+    };
+    auto result = (JitValue) {};
+    ((JitStub) code.entry)((JitFunction) jit_test_sum, arguments, &result);
+    assert(15 == result.i64);
+    jit_free(&code);
+
+    signature = (JitSignature) {
+        .arguments = {JIT_TYPE_F64, JIT_TYPE_F32},
+        .n_arguments = 2,
+        .result = JIT_TYPE_F64,
+    };
+    code = jit_compile_stub(&signature);
+    arguments[0] = (JitValue) {.f64 = 1.5};
+    arguments[1] = (JitValue) {.f32 = 3.0f};
+    ((JitStub) code.entry)((JitFunction) jit_test_scale, arguments, &result);
+    assert(4.5 == result.f64);
+    jit_free(&code);
+}
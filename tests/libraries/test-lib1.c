@@ -1,7 +1,39 @@
 #include <stdio.h>
+#include <stdlib.h>
 
 void foo() { printf("foo() from test1\n"); }
 
 void bar() { printf("bar() from test1\n"); }
 
 void baz() { printf("baz() from test1\n"); }
+
+long add(long a, long b) { return a + b; }
+
+double scale(double x) { return 2.0 * x; }
+
+/// Mixes integer and floating-point registers
+float mix(int a, double b, unsigned c, float d) {
+    return (float) (a + b) * (float) c + d;
+}
+
+/// Burns CPU time in a callee, for stacks of the profiler
+__attribute__((noinline)) unsigned long spin_step(unsigned long value) {
+    return value * 6364136223846793005UL + 1442695040888963407UL;
+}
+
+unsigned long spin(unsigned long n) {
+    unsigned long value = 0;
+
+    for (unsigned long i = 0; i < n; ++i) {
+        value = spin_step(value);
+        __asm__ volatile("" : "+r"(value));
+    }
+
+    return value;
+}
+
+/// Keeps the last block only, every call loses the one before
+static void* volatile LEAKED = nullptr;
+
+/// Leaks 256 bytes a call, for the memory report
+void leak() { LEAKED = malloc(256); }
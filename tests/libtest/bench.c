@@ -0,0 +1,83 @@
+#include "bench.h"
+
+#include <math.h>
+#include <stats.h>
+#include <time.h>
+
+size_t constexpr BENCH_MAX_ITERATIONS = (size_t) 1 << 40;
+
+static uint64_t bench_now_ns() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (uint64_t) time.tv_sec * 1000000000 + (uint64_t) time.tv_nsec;
+}
+
+void bencher_start(Bencher* self) {
+    self->iteration = 0;
+    self->start_ns = bench_now_ns();
+}
+
+void bencher_stop(Bencher* self) {
+    self->elapsed_ns = bench_now_ns() - self->start_ns;
+}
+
+static uint64_t bench_sample(Bench const* bench, size_t n_iterations) {
+    auto bencher = (Bencher) {.n_iterations = n_iterations};
+    bench->run(&bencher);
+
+    return bencher.elapsed_ns;
+}
+
+BenchResult bench_run(Bench const* bench) {
+    size_t n_iterations = 1;
+
+    // The limit stops benchmarks without a `BENCH_LOOP`, their time is zero
+    while (bench_sample(bench, n_iterations) < BENCH_SAMPLE_NS &&
+           n_iterations < BENCH_MAX_ITERATIONS)
+    {
+        n_iterations *= 2;
+    }
+
+    double samples[BENCH_N_SAMPLES];
+
+    for (size_t i = 0; i < BENCH_N_SAMPLES; ++i) {
+        samples[i] = (double) bench_sample(bench, n_iterations) /
+                     (double) n_iterations;
+    }
+
+    stats_sort(samples, BENCH_N_SAMPLES);
+
+    auto mean = stats_mean(samples, BENCH_N_SAMPLES);
+    double variance = 0.0;
+
+    for (size_t i = 0; i < BENCH_N_SAMPLES; ++i) {
+        variance += (samples[i] - mean) * (samples[i] - mean);
+    }
+
+    return (BenchResult) {
+        .n_iterations = n_iterations,
+        .n_samples = BENCH_N_SAMPLES,
+        .mean_ns = mean,
+        .stddev_ns = sqrt(variance / (BENCH_N_SAMPLES - 1)),
+        .min_ns = samples[0],
+        .median_ns = stats_median(samples, BENCH_N_SAMPLES),
+        .p90_ns = stats_percentile(samples, BENCH_N_SAMPLES, 90.0),
+        .p99_ns = stats_percentile(samples, BENCH_N_SAMPLES, 99.0),
+    };
+}
+
+void bench_result_write_json(
+    BenchResult const* self, Bench const* bench, Str path, FILE* stream
+) {
+    fprintf(
+        stream,
+        "{\"name\": \"%s\", \"path\": \"%.*s\", \"line\": %zu, "
+        "\"iterations\": %zu, \"samples\": %zu, \"mean_ns\": %.3f, "
+        "\"stddev_ns\": %.3f, \"min_ns\": %.3f, \"median_ns\": %.3f, "
+        "\"p90_ns\": %.3f, \"p99_ns\": %.3f}",
+        bench->name.ptr, (int) path.len, path.ptr, bench->line_number,
+        self->n_iterations, self->n_samples, self->mean_ns, self->stddev_ns,
+        self->min_ns, self->median_ns, self->p90_ns, self->p99_ns
+    );
+}
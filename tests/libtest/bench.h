@@ -0,0 +1,34 @@
+#ifndef _SOTEST_TESTS_BENCH_H
+#define _SOTEST_TESTS_BENCH_H
+
+#include "tests.h"
+
+#include <stdio.h>
+
+/// Shortest duration of one timed sample
+uint64_t constexpr BENCH_SAMPLE_NS = 5000000;
+size_t constexpr BENCH_N_SAMPLES = 20;
+
+typedef struct BenchResult {
+    /// Iterations per sample
+    size_t n_iterations;
+    size_t n_samples;
+    /// Statistics of the time per iteration over the samples
+    double mean_ns;
+    double stddev_ns;
+    double min_ns;
+    double median_ns;
+    double p90_ns;
+    double p99_ns;
+} BenchResult;
+
+/// Calibrates the number of iterations so a sample takes at least
+/// `BENCH_SAMPLE_NS`, then takes `BENCH_N_SAMPLES` samples
+BenchResult bench_run(Bench const* bench);
+
+/// Writes the result as a JSON object, without a trailing newline
+void bench_result_write_json(
+    BenchResult const* self, Bench const* bench, Str path, FILE* stream
+);
+
+#endif  // !_SOTEST_TESTS_BENCH_H
@@ -15,4 +15,41 @@
     }                                                            \
     void __execute_test_##test_name()
 
+/// Registers a benchmark, run only with `--bench`. The body does its setup
+/// and then runs the measured code in `BENCH_LOOP`:
+///
+/// ```c
+/// BENCH(parse_call) {
+///     auto line = Str("call foo");
+///
+///     BENCH_LOOP {
+///         black_box(command_line_parse(black_box(line)));
+///     }
+/// }
+/// ```
+#define BENCH(bench_name)                                                   \
+    void __execute_bench_##bench_name(Bencher* bencher);                    \
+    __attribute__((constructor)) void __add_bench_##bench_name() {          \
+        benches_add(                                                        \
+            &BENCHES, (Bench) {.run = __execute_bench_##bench_name,         \
+                               .name = Str(#bench_name),                    \
+                               .path = Str(__FILE__),                       \
+                               .line_number = (size_t) __LINE__}            \
+        );                                                                  \
+    }                                                                       \
+    void __execute_bench_##bench_name([[maybe_unused]] Bencher* bencher)
+
+/// Runs the following statement as many times as the calibration asks for
+/// and times it, once per `BENCH`
+#define BENCH_LOOP for (bencher_start(bencher); bencher_is_running(bencher);)
+
+/// Hides a value from the optimizer, so computing it can not be removed and
+/// it can not be treated as a constant
+#define black_box(value)                                              \
+    ({                                                                \
+        __auto_type __black_box_value = (value);                      \
+        __asm__ volatile("" : : "r"(&__black_box_value) : "memory"); \
+        __black_box_value;                                            \
+    })
+
 #endif  // !_SOTEST_TESTS_MACROS_H
@@ -1,8 +1,13 @@
 #include "tests.h"
+#include "bench.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/wait.h>
 #include <parse.h>
@@ -11,63 +16,383 @@
 #define RED_START "\033[1;31m"
 #define COLOR_END "\033[0m"
 
-int run_test(Test test) {
-    int result = EXIT_SUCCESS;
+size_t constexpr DEFAULT_N_SLOWEST = 5;
+
+typedef struct RunnerOptions {
+    size_t n_jobs;
+    size_t n_slowest;
+    /// Print the output of passed tests too, not only of failed ones
+    bool show_output;
+    /// Run benchmarks instead of tests
+    bool bench;
+    /// Run only tests with a name containing one of these, all if empty
+    char** filters;
+    size_t n_filters;
+} RunnerOptions;
+
+/// Forked test whose output is still being collected
+typedef struct RunningTest {
+    size_t index;
+    pid_t pid;
+    /// Read end of the pipe the test writes its stdout and stderr into
+    int fd;
+    String output;
+    uint64_t start_ns;
+} RunningTest;
+
+typedef struct TestResult {
+    size_t index;
+    uint64_t duration_ns;
+} TestResult;
+
+static uint64_t now_ns() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (uint64_t) time.tv_sec * 1000000000 + (uint64_t) time.tv_nsec;
+}
+
+static void print_usage(char const* program) {
+    printf(
+        "Usage: %s [OPTIONS] [FILTER]...\n"
+        "\n"
+        "Runs tests (or benchmarks) with a name containing any FILTER, all\n"
+        "if none given\n"
+        "\n"
+        "Options:\n"
+        "  -j, --jobs <N>     run N tests in parallel (default 1)\n"
+        "      --slowest <N>  list N slowest tests (default %zu)\n"
+        "      --show-output  print the output of passed tests too\n"
+        "      --bench        run benchmarks and write the results as JSON\n"
+        "  -h, --help         show this message\n",
+        program, DEFAULT_N_SLOWEST
+    );
+}
+
+static size_t parse_count(char const* program, char const* source) {
+    char* end = nullptr;
+    errno = 0;
+    auto value = strtoull(nullptr == source ? "" : source, &end, 10);
+
+    if (nullptr == source || end == source || '\0' != *end || 0 != errno ||
+        '-' == source[0])
+    {
+        fprintf(
+            stderr, "error: expected a count, got '%s'\n",
+            nullptr == source ? "" : source
+        );
+        print_usage(program);
+        exit(EXIT_FAILURE);
+    }
+
+    return (size_t) value;
+}
+
+static RunnerOptions parse_options(int argc, char* argv[]) {
+    auto options = (RunnerOptions) {
+        .n_jobs = 1,
+        .n_slowest = DEFAULT_N_SLOWEST,
+        .filters = malloc(sizeof(char*) * (size_t) argc),
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        auto arg = str_from_ptr(argv[i]);
+
+        if (str_eq(arg, Str("-h")) || str_eq(arg, Str("--help"))) {
+            print_usage(argv[0]);
+            exit(EXIT_SUCCESS);
+        } else if (str_eq(arg, Str("-j")) || str_eq(arg, Str("--jobs"))) {
+            options.n_jobs = parse_count(argv[0], argv[++i]);
+        } else if (str_starts_with(arg, Str("-j"))) {
+            options.n_jobs = parse_count(argv[0], argv[i] + 2);
+        } else if (str_eq(arg, Str("--slowest"))) {
+            options.n_slowest = parse_count(argv[0], argv[++i]);
+        } else if (str_eq(arg, Str("--show-output"))) {
+            options.show_output = true;
+        } else if (str_eq(arg, Str("--bench"))) {
+            options.bench = true;
+        } else if (str_starts_with(arg, Str("-"))) {
+            fprintf(stderr, "error: unknown option '%s'\n", argv[i]);
+            print_usage(argv[0]);
+            exit(EXIT_FAILURE);
+        } else {
+            options.filters[options.n_filters++] = argv[i];
+        }
+    }
+
+    if (0 == options.n_jobs) {
+        options.n_jobs = 1;
+    }
+
+    return options;
+}
+
+static bool name_matches(Str name, RunnerOptions const* options) {
+    if (0 == options->n_filters) {
+        return true;
+    }
+
+    for (size_t i = 0; i < options->n_filters; ++i) {
+        if (nullptr != strstr(name.ptr, options->filters[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static RunningTest start_test(size_t index) {
+    int fds[2];
+    assert(0 == pipe(fds));
+
+    auto start_ns = now_ns();
     auto pid = fork();
 
     if (0 == pid) {
-        test.run();
+        close(fds[0]);
+        dup2(fds[1], STDOUT_FILENO);
+        dup2(fds[1], STDERR_FILENO);
+        close(fds[1]);
+
+        // Keep the output written before a failed assertion aborts
+        setvbuf(stdout, nullptr, _IONBF, 0);
+
+        TESTS.ptr[index].run();
+        fflush(stdout);
         _exit(EXIT_SUCCESS);
     } else if (pid < 0) {
         abort();
     }
 
-    String current_dir = (String) {
-        .str = str_from_ptr(getcwd(nullptr, 0)),
-        .cap = current_dir.str.len,
+    close(fds[1]);
+
+    return (RunningTest) {
+        .index = index,
+        .pid = pid,
+        .fd = fds[0],
+        .output = STRING_EMPTY,
+        .start_ns = start_ns,
     };
+}
+
+/// Reads the available output of a test
+///
+/// # Return
+///
+/// `false` once the test closed its end of the pipe
+static bool read_output(RunningTest* self) {
+    char buffer[4096];
+    auto len = read(self->fd, buffer, sizeof(buffer));
 
-    auto parse_result = parse_prefix(test.path, current_dir.str);
-    auto path = parse_result.tail;
+    if (len < 0 && EINTR == errno) {
+        return true;
+    }
+
+    if (len <= 0) {
+        return false;
+    }
+
+    string_append(&self->output, (Str) {.ptr = buffer, .len = (size_t) len});
+
+    return true;
+}
+
+static Str relative_path(Str path, Str current_dir) {
+    auto parse_result = parse_prefix(path, current_dir);
 
-    if (parse_result.has_value) {
-        // Remove starting `/`
-        path = str_slice(path, 1, path.len);
+    if (!parse_result.has_value) {
+        return path;
     }
 
+    // Remove starting `/`
+    return str_slice(parse_result.tail, 1, parse_result.tail.len);
+}
+
+/// Reaps the test and prints its result
+///
+/// # Return
+///
+/// `EXIT_SUCCESS` if the test passed
+static int finish_test(
+    RunningTest* self, RunnerOptions const* options, Str current_dir,
+    uint64_t* duration_ns
+) {
+    close(self->fd);
+
+    int status = 0;
+    assert(self->pid == waitpid(self->pid, &status, 0));
+    *duration_ns = now_ns() - self->start_ns;
+
+    auto test = &TESTS.ptr[self->index];
+    auto path = relative_path(test->path, current_dir);
+    auto passed = WIFEXITED(status) && EXIT_SUCCESS == WEXITSTATUS(status);
+
     printf(
-        "test %s - %s (line %zu)", path.ptr, test.name.ptr, test.line_number
+        "test %s - %s (line %zu) ... %s (%.1f ms)\n", path.ptr, test->name.ptr,
+        test->line_number,
+        passed ? GREEN_START "ok" COLOR_END : RED_START "failed" COLOR_END,
+        (double) *duration_ns / 1e6
     );
 
-    int status = 0;
-    assert(pid == waitpid(pid, &status, 0));
+    if ((!passed || options->show_output) && 0 != self->output.str.len) {
+        str_write(self->output.str, stdout);
+
+        if (!str_ends_with(self->output.str, Str("\n"))) {
+            putchar('\n');
+        }
+    }
 
-    if ((WIFEXITED(status) && EXIT_SUCCESS == WEXITSTATUS(status))) {
-        result = EXIT_SUCCESS;
-        printf(" ... " GREEN_START "ok" COLOR_END);
-    } else {
-        result = EXIT_FAILURE;
-        printf(" ... " RED_START "failed" COLOR_END);
+    if (!passed && WIFSIGNALED(status)) {
+        printf("  killed by signal %d\n", WTERMSIG(status));
     }
 
-    putchar('\n');
+    string_free(&self->output);
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int compare_durations(void const* a, void const* b) {
+    auto x = ((TestResult const*) a)->duration_ns;
+    auto y = ((TestResult const*) b)->duration_ns;
+
+    return (x < y) - (x > y);
+}
+
+/// Runs the benchmarks one after another, in this process, so they do not
+/// disturb each other. Writes a JSON array of the results to stdout, their own
+/// output is discarded.
+static int run_benches(RunnerOptions const* options) {
+    auto cwd = str_from_ptr(getcwd(nullptr, 0));
+    auto current_dir = (String) {.str = cwd, .cap = cwd.len + 1};
+
+    fflush(stdout);
+    auto report = fdopen(dup(STDOUT_FILENO), "w");
+    int null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    dup2(null_fd, STDOUT_FILENO);
+    close(null_fd);
+
+    fputs("[", report);
+    size_t n_run = 0;
+
+    for (size_t i = 0; i < BENCHES.len; ++i) {
+        auto bench = &BENCHES.ptr[i];
 
+        if (!name_matches(bench->name, options)) {
+            continue;
+        }
+
+        auto result = bench_run(bench);
+        fflush(stdout);
+
+        fputs(0 == n_run ? "\n  " : ",\n  ", report);
+        auto path = relative_path(bench->path, current_dir.str);
+        bench_result_write_json(&result, bench, path, report);
+        n_run += 1;
+
+        fprintf(
+            stderr, "bench %s ... %.1f ns/iter (+/- %.1f)\n", bench->name.ptr,
+            result.median_ns, result.stddev_ns
+        );
+    }
+
+    fputs(0 == n_run ? "]\n" : "\n]\n", report);
+    fclose(report);
     string_free(&current_dir);
 
-    return result;
+    return EXIT_SUCCESS;
 }
 
-int main() {
-    printf("running %zu tests\n", TESTS.len);
+int main(int argc, char* argv[]) {
+    auto options = parse_options(argc, argv);
+
+    if (options.bench) {
+        auto status = run_benches(&options);
+        free(options.filters);
+
+        return status;
+    }
+
+    auto selected = (size_t*) malloc(sizeof(size_t) * (TESTS.len + 1));
+    size_t n_selected = 0;
+
+    for (size_t i = 0; i < TESTS.len; ++i) {
+        if (name_matches(TESTS.ptr[i].name, &options)) {
+            selected[n_selected++] = i;
+        }
+    }
+
+    printf("running %zu tests\n", n_selected);
+
+    // Forked tests would flush the inherited buffer once more otherwise
+    fflush(stdout);
+
+    auto cwd = str_from_ptr(getcwd(nullptr, 0));
+    auto current_dir = (String) {.str = cwd, .cap = cwd.len + 1};
 
+    auto running = (RunningTest*) malloc(sizeof(RunningTest) * options.n_jobs);
+    auto fds = (struct pollfd*) malloc(sizeof(struct pollfd) * options.n_jobs);
+    auto results = (TestResult*) malloc(sizeof(TestResult) * (n_selected + 1));
+    size_t n_running = 0;
+    size_t n_started = 0;
     size_t n_passed = 0;
     size_t n_failed = 0;
 
-    for (size_t i = 0; i < TESTS.len; ++i) {
-        if (EXIT_SUCCESS == run_test(TESTS.ptr[i])) {
-            n_passed += 1;
-        } else {
-            n_failed += 1;
+    auto start_ns = now_ns();
+
+    while (n_started < n_selected || 0 != n_running) {
+        while (n_running < options.n_jobs && n_started < n_selected) {
+            running[n_running++] = start_test(selected[n_started++]);
+        }
+
+        for (size_t i = 0; i < n_running; ++i) {
+            fds[i] = (struct pollfd) {.fd = running[i].fd, .events = POLLIN};
+        }
+
+        if (poll(fds, n_running, -1) < 0) {
+            assert(EINTR == errno);
+            continue;
+        }
+
+        // Iterate backwards, finished tests are replaced by the last one
+        for (size_t i = n_running; i-- > 0;) {
+            if (0 == fds[i].revents || read_output(&running[i])) {
+                continue;
+            }
+
+            auto result = (TestResult) {.index = running[i].index};
+            auto status = finish_test(
+                &running[i], &options, current_dir.str, &result.duration_ns
+            );
+
+            if (EXIT_SUCCESS == status) {
+                n_passed += 1;
+            } else {
+                n_failed += 1;
+            }
+
+            results[n_passed + n_failed - 1] = result;
+            running[i] = running[--n_running];
+            fds[i] = fds[n_running];
+        }
+
+        fflush(stdout);
+    }
+
+    auto elapsed_ns = now_ns() - start_ns;
+    auto n_slowest =
+        options.n_slowest < n_selected ? options.n_slowest : n_selected;
+
+    if (0 != n_slowest) {
+        qsort(results, n_selected, sizeof(*results), compare_durations);
+        printf("\nslowest tests:\n");
+
+        for (size_t i = 0; i < n_slowest; ++i) {
+            auto test = &TESTS.ptr[results[i].index];
+
+            printf(
+                "  %8.1f ms  %s - %s\n", (double) results[i].duration_ns / 1e6,
+                relative_path(test->path, current_dir.str).ptr, test->name.ptr
+            );
         }
     }
 
@@ -75,7 +400,16 @@ int main() {
                                      : RED_START "error" COLOR_END;
 
     printf(
-        "\ntest result: %s. %zu passed; %zu failed\n", test_result, n_passed,
-        n_failed
+        "\ntest result: %s. %zu passed; %zu failed; finished in %.2f s\n",
+        test_result, n_passed, n_failed, (double) elapsed_ns / 1e9
     );
+
+    free(results);
+    free(fds);
+    free(running);
+    free(selected);
+    free(options.filters);
+    string_free(&current_dir);
+
+    return 0 == n_failed ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 
 Tests TESTS = TESTS_EMPTY;
+Benches BENCHES = BENCHES_EMPTY;
 
 void tests_free(Tests* self) {
     free(self->ptr);
@@ -22,4 +23,25 @@ void tests_add(Tests* self, Test test) {
     self->len += 1;
 }
 
-__attribute__((destructor)) void global_tests_free() { tests_free(&TESTS); }
+void benches_free(Benches* self) {
+    free(self->ptr);
+    *self = BENCHES_EMPTY;
+}
+
+void benches_add(Benches* self, Bench bench) {
+    if (0 == self->cap) {
+        self->cap = 2;
+        self->ptr = malloc(sizeof(*self->ptr) * self->cap);
+    } else if (self->len == self->cap) {
+        self->cap += self->cap / 2;
+        self->ptr = realloc(self->ptr, sizeof(*self->ptr) * self->cap);
+    }
+
+    self->ptr[self->len] = bench;
+    self->len += 1;
+}
+
+__attribute__((destructor)) void global_tests_free() {
+    tests_free(&TESTS);
+    benches_free(&BENCHES);
+}
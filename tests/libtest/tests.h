@@ -3,6 +3,7 @@
 
 #include <str.h>
 #include <stddef.h>
+#include <stdint.h>
 
 typedef void (*TestFunction)();
 
@@ -27,4 +28,52 @@ void tests_add(Tests* self, Test test);
 
 void tests_free(Tests* self);
 
+/// State of a running benchmark, see `BENCH_LOOP`
+typedef struct Bencher {
+    /// Iterations the current `BENCH_LOOP` runs
+    size_t n_iterations;
+    size_t iteration;
+    uint64_t start_ns;
+    /// Duration of the last completed `BENCH_LOOP`
+    uint64_t elapsed_ns;
+} Bencher;
+
+typedef void (*BenchFunction)(Bencher* bencher);
+
+typedef struct Bench {
+    BenchFunction run;
+    Str name;
+    Str path;
+    size_t line_number;
+} Bench;
+
+typedef struct Benches {
+    Bench* ptr;
+    size_t len;
+    size_t cap;
+} Benches;
+
+Benches constexpr BENCHES_EMPTY =
+    (Benches) {.ptr = nullptr, .len = 0, .cap = 0};
+
+extern Benches BENCHES;
+
+void benches_add(Benches* self, Bench bench);
+
+void benches_free(Benches* self);
+
+void bencher_start(Bencher* self);
+
+void bencher_stop(Bencher* self);
+
+inline static bool bencher_is_running(Bencher* self) {
+    if (self->iteration < self->n_iterations) {
+        self->iteration += 1;
+        return true;
+    }
+
+    bencher_stop(self);
+    return false;
+}
+
 #endif  // !_SOTEST_TESTS_H
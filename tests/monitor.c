@@ -0,0 +1,108 @@
+#include "libtest/macros.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <program.h>
+
+TEST(monitor_attach_read_only) {
+    auto monitor = (Monitor) {};
+    assert(monitor_start(&monitor));
+
+    monitor_add(&monitor.segment->n_lines, 3);
+    assert(0 == monitor_slot(&monitor, Str("foo")));
+    assert(1 == monitor_slot(&monitor, Str("bar")));
+    assert(0 == monitor_slot(&monitor, Str("foo")));
+    monitor_count_calls(&monitor, 1, 10, 500);
+
+    // Seen through a mapping of its own, as `sotest-top` sees it
+    auto reader = (Monitor) {};
+    assert(monitor_attach(&reader, getpid()));
+    assert(reader.segment != monitor.segment);
+    assert(getpid() == reader.segment->pid);
+    assert(3 == monitor_load(&reader.segment->n_lines));
+    assert(10 == monitor_load(&reader.segment->n_calls));
+    assert(2 == monitor_load(&reader.segment->n_functions));
+    assert(0 == strcmp("bar", reader.segment->functions[1].name));
+    assert(10 == reader.segment->functions[1].n_calls);
+    assert(500 == reader.segment->functions[1].total_ns);
+
+    monitor_stop(&monitor);
+    assert(0 != reader.segment->is_finished);
+    monitor_detach(&reader);
+
+    // The segment is gone once the interpreter stops
+    assert(!monitor_attach(&reader, getpid()));
+}
+
+TEST(monitor_slots_run_out) {
+    auto monitor = (Monitor) {};
+    assert(monitor_start(&monitor));
+
+    char name[16];
+
+    for (size_t i = 0; i < MONITOR_MAX_FUNCTIONS; ++i) {
+        snprintf(name, sizeof(name), "f%zu", i);
+        assert(i == monitor_slot(&monitor, str_from_ptr(name)));
+    }
+
+    assert(MONITOR_NO_SLOT == monitor_slot(&monitor, Str("extra")));
+
+    // Counted in the totals only
+    monitor_count_calls(&monitor, MONITOR_NO_SLOT, 2, 100);
+    assert(2 == monitor_load(&monitor.segment->n_calls));
+
+    monitor_stop(&monitor);
+}
+
+TEST(monitor_executor_counters) {
+    auto monitor = (Monitor) {};
+    assert(monitor_start(&monitor));
+
+    auto executor = executor_with_options((ExecutorOptions) {
+        .monitor = &monitor,
+    });
+    auto segment = monitor.segment;
+
+    assert(
+        EXECUTOR_SUCCESS ==
+        executor_load_library(&executor, Str("build/libtest1.so")).status
+    );
+    assert(1 == monitor_load(&segment->n_libraries));
+
+    for (size_t i = 0; i < 2; ++i) {
+        auto result = executor_call_function(&executor, Str("foo"));
+        assert(EXECUTOR_SUCCESS == result.status);
+    }
+
+    assert(1 == monitor_load(&segment->n_cache_misses));
+    assert(1 == monitor_load(&segment->n_cache_hits));
+    assert(2 == monitor_load(&segment->n_calls));
+
+    // The slot is taken once, along the cached function
+    assert(0 == executor_resolve_function(&executor, Str("foo")).slot);
+
+    // Repeated calls are counted in chunks, a loop is never compiled
+    auto program = PROGRAM_EMPTY;
+    auto repeat = (Command) {
+        .type = COMMAND_TYPE_REPEAT,
+        .count = 3 * MONITOR_CHUNK + 5,
+        .body = Str("call bar"),
+    };
+    assert(PROGRAM_ADDED == program_add(&program, &executor, &repeat).status);
+    assert(nullptr == program.ptr[0].jit.entry);
+    program_run(&program);
+    program_free(&program);
+
+    assert(2 + 3 * MONITOR_CHUNK + 5 == monitor_load(&segment->n_calls));
+    assert(2 == monitor_load(&segment->n_functions));
+    assert(0 == strcmp("foo", segment->functions[0].name));
+    assert(2 == segment->functions[0].n_calls);
+    assert(0 == strcmp("bar", segment->functions[1].name));
+    assert(3 * MONITOR_CHUNK + 5 == segment->functions[1].n_calls);
+    assert(0 != segment->functions[1].total_ns);
+
+    executor_free(&executor);
+    monitor_stop(&monitor);
+}
@@ -130,6 +130,224 @@ TEST(parse_function_name) {
     assert(str_eq(r.tail, Str("")));
 }
 
+TEST(parse_qualified_name) {
+    auto r = parse_qualified_name(Str("alias.function tail"));
+
+    assert(r.has_value);
+    assert(str_eq(r.value, Str("alias.function")));
+    assert(str_eq(r.tail, Str(" tail")));
+
+    r = parse_qualified_name(Str("function tail"));
+
+    assert(r.has_value);
+    assert(str_eq(r.value, Str("function")));
+    assert(str_eq(r.tail, Str(" tail")));
+
+    r = parse_qualified_name(Str("alias. function"));
+
+    assert(!r.has_value);
+    assert(str_eq(r.tail, Str("alias. function")));
+
+    r = parse_qualified_name(Str("alias.42"));
+
+    assert(!r.has_value);
+    assert(str_eq(r.tail, Str("alias.42")));
+
+    r = parse_qualified_name(Str(".function"));
+
+    assert(!r.has_value);
+    assert(str_eq(r.tail, Str(".function")));
+}
+
+TEST(parse_command_alias) {
+    auto r = command_parse(Str("use path/to/lib as lib # comment"));
+
+    assert(r.has_value);
+    assert(r.value.type == COMMAND_TYPE_USE);
+    assert(str_eq(r.value.content, Str("path/to/lib")));
+    assert(str_eq(r.value.alias, Str("lib")));
+    assert(!r.value.is_isolated);
+    assert(str_eq(r.tail, Str(" # comment")));
+
+    r = command_parse(Str("use path/to/lib in lib"));
+
+    assert(r.has_value);
+    assert(str_eq(r.value.content, Str("path/to/lib")));
+    assert(str_eq(r.value.alias, Str("lib")));
+    assert(r.value.is_isolated);
+    assert(str_eq(r.tail, Str("")));
+
+    r = command_parse(Str("use path/to/lib as"));
+
+    assert(r.has_value);
+    assert(str_eq(r.value.alias, Str("")));
+    assert(str_eq(r.tail, Str(" as")));
+
+    r = command_parse(Str("use path/to/lib as 42"));
+
+    assert(r.has_value);
+    assert(str_eq(r.value.alias, Str("")));
+    assert(str_eq(r.tail, Str(" as 42")));
+
+    r = command_parse(Str("call lib.function # comment"));
+
+    assert(r.has_value);
+    assert(r.value.type == COMMAND_TYPE_CALL);
+    assert(str_eq(r.value.content, Str("lib.function")));
+    assert(str_eq(r.value.alias, Str("lib")));
+    assert(str_eq(r.tail, Str(" # comment")));
+
+    r = command_parse(Str("call function"));
+
+    assert(r.has_value);
+    assert(str_eq(r.value.alias, Str("")));
+
+    r = command_parse(Str("call lib."));
+
+    assert(!r.has_value);
+    assert(str_eq(r.tail, Str("call lib.")));
+}
+
+TEST(parse_command_compare) {
+    auto r = command_parse(Str("compare foo lib/a.so lib/b.so # comment"));
+
+    assert(r.has_value);
+    assert(r.value.type == COMMAND_TYPE_COMPARE);
+    assert(str_eq(r.value.content, Str("foo")));
+    assert(str_eq(r.value.baseline_path, Str("lib/a.so")));
+    assert(str_eq(r.value.candidate_path, Str("lib/b.so")));
+    assert(str_eq(r.tail, Str(" # comment")));
+
+    r = command_parse(Str("compare foo lib/a.so"));
+
+    assert(!r.has_value);
+    assert(str_eq(r.tail, Str("compare foo lib/a.so")));
+
+    r = command_parse(Str("compare 42 lib/a.so lib/b.so"));
+
+    assert(!r.has_value);
+    assert(str_eq(r.tail, Str("compare 42 lib/a.so lib/b.so")));
+
+    r = command_parse(Str("comparefoo a b"));
+
+    assert(!r.has_value);
+    assert(str_eq(r.tail, Str("comparefoo a b")));
+}
+
+TEST(parse_command_bench) {
+    auto r = command_parse(Str("bench foo # comment"));
+
+    assert(r.has_value);
+    assert(r.value.type == COMMAND_TYPE_BENCH);
+    assert(str_eq(r.value.content, Str("foo")));
+    assert(str_eq(r.value.alias, Str("")));
+    assert(str_eq(r.tail, Str(" # comment")));
+
+    r = command_parse(Str("bench lib.foo"));
+
+    assert(r.has_value);
+    assert(str_eq(r.value.content, Str("lib.foo")));
+    assert(str_eq(r.value.alias, Str("lib")));
+
+    r = command_parse(Str("benchfoo"));
+
+    assert(!r.has_value);
+    assert(str_eq(r.tail, Str("benchfoo")));
+}
+
+TEST(parse_command_expect) {
+    auto r = command_parse(Str("expect 0123456789abcdef # comment"));
+
+    assert(r.has_value);
+    assert(r.value.type == COMMAND_TYPE_EXPECT);
+    assert(str_eq(r.value.content, Str("0123456789abcdef")));
+    assert(str_eq(r.tail, Str(" # comment")));
+
+    r = command_parse(Str("expect 12345678901234567"));
+
+    assert(!r.has_value);
+
+    r = command_parse(Str("expect xyz"));
+
+    assert(!r.has_value);
+}
+
+TEST(parse_number) {
+    size_t number = 0;
+    auto r = parse_number(Str("1000 {"), &number);
+
+    assert(r.has_value);
+    assert(1000 == number);
+    assert(str_eq(r.value, Str("1000")));
+    assert(str_eq(r.tail, Str(" {")));
+
+    assert(!parse_number(Str("99999999999999999999999"), &number).has_value);
+    assert(!parse_number(Str("10x"), &number).has_value);
+    assert(!parse_number(Str("x"), &number).has_value);
+}
+
+TEST(parse_command_repeat) {
+    auto r = command_parse(Str("repeat 1000 { # comment"));
+
+    assert(r.has_value);
+    assert(r.value.type == COMMAND_TYPE_REPEAT);
+    assert(1000 == r.value.count);
+    assert(str_eq(r.value.content, Str("1000")));
+    assert(0 == r.value.body.len);
+    assert(str_eq(r.tail, Str(" # comment")));
+
+    r = command_parse(Str("repeat 3 call lib.foo # comment"));
+
+    assert(r.has_value);
+    assert(3 == r.value.count);
+    assert(str_eq(r.value.body, Str("call lib.foo")));
+    assert(str_eq(r.tail, Str(" # comment")));
+
+    r = command_parse(Str("repeat 2 repeat 3 call foo"));
+
+    assert(r.has_value);
+    assert(str_eq(r.value.body, Str("repeat 3 call foo")));
+
+    r = command_parse(Str("} # end"));
+
+    assert(r.has_value);
+    assert(r.value.type == COMMAND_TYPE_END);
+    assert(str_eq(r.tail, Str(" # end")));
+
+    // Blocks are opened and closed only by whole lines
+    assert(!command_parse(Str("repeat 2 repeat 3 {")).has_value);
+    assert(!command_parse(Str("repeat 2 }")).has_value);
+    assert(!command_parse(Str("repeat 2")).has_value);
+    assert(!command_parse(Str("repeat x call foo")).has_value);
+    assert(!command_parse(Str("repeat2 call foo")).has_value);
+}
+
+TEST(parse_command_def_run) {
+    auto r = command_parse(Str("def setup { # comment"));
+
+    assert(r.has_value);
+    assert(r.value.type == COMMAND_TYPE_DEF);
+    assert(str_eq(r.value.content, Str("setup")));
+    assert(str_eq(r.tail, Str(" # comment")));
+
+    r = command_parse(Str("run setup # comment"));
+
+    assert(r.has_value);
+    assert(r.value.type == COMMAND_TYPE_RUN);
+    assert(str_eq(r.value.content, Str("setup")));
+    assert(str_eq(r.tail, Str(" # comment")));
+
+    r = command_parse(Str("repeat 3 run setup"));
+
+    assert(r.has_value);
+    assert(str_eq(r.value.body, Str("run setup")));
+
+    assert(!command_parse(Str("def setup")).has_value);
+    assert(!command_parse(Str("defsetup {")).has_value);
+    assert(!command_parse(Str("runsetup")).has_value);
+    assert(!command_parse(Str("repeat 3 def setup {")).has_value);
+}
+
 TEST(parse_command) {
     auto r = command_parse(Str("use path/to/library # comment"));
 
@@ -247,3 +465,83 @@ TEST(parse_command_line) {
     assert(str_eq(r.value.comment, Str(" with a comment")));
     assert(str_eq(r.tail, Str("")));
 }
+
+BENCH(parse_command_line_call) {
+    auto line = Str("call foo # comment");
+
+    BENCH_LOOP {
+        black_box(command_line_parse(black_box(line)));
+    }
+}
+
+BENCH(parse_command_line_use_alias) {
+    auto line = Str("use build/libtest2.so as second");
+
+    BENCH_LOOP {
+        black_box(command_line_parse(black_box(line)));
+    }
+}
+
+TEST(parse_typed_call) {
+    auto call = (TypedCall) {};
+    auto r =
+        parse_typed_call(Str("(i64 -2, f64 1.5, u32 0x10) -> f32 = 4"), &call);
+
+    assert(r.has_value);
+    assert(0 == r.tail.len);
+    assert(3 == call.signature.n_arguments);
+    assert(JIT_TYPE_I64 == call.signature.arguments[0]);
+    assert(JIT_TYPE_F64 == call.signature.arguments[1]);
+    assert(JIT_TYPE_U32 == call.signature.arguments[2]);
+    assert(-2 == call.arguments[0].i64);
+    assert(1.5 == call.arguments[1].f64);
+    assert(16 == call.arguments[2].u64);
+    assert(JIT_TYPE_F32 == call.signature.result);
+    assert(call.has_expected);
+    assert(4.0f == call.expected.f32);
+
+    r = parse_typed_call(Str("( ) # comment"), &call);
+
+    assert(r.has_value);
+    assert(str_eq(r.value, Str("( )")));
+    assert(str_eq(r.tail, Str(" # comment")));
+    assert(0 == call.signature.n_arguments);
+    assert(JIT_TYPE_VOID == call.signature.result);
+    assert(!call.has_expected);
+
+    // Out of range for the type
+    assert(!parse_typed_call(Str("(i32 2147483648)"), &call).has_value);
+    assert(!parse_typed_call(Str("(u64 -1)"), &call).has_value);
+    assert(!parse_typed_call(Str("(f64 1e999)"), &call).has_value);
+    // Malformed
+    assert(!parse_typed_call(Str("(i64 1,)"), &call).has_value);
+    assert(!parse_typed_call(Str("(i64 1 i64 2)"), &call).has_value);
+    assert(!parse_typed_call(Str("(i64)"), &call).has_value);
+    assert(!parse_typed_call(Str("(i64 1"), &call).has_value);
+    assert(!parse_typed_call(Str("(i8 1)"), &call).has_value);
+    assert(!parse_typed_call(Str("() -> void"), &call).has_value);
+    assert(!parse_typed_call(Str("() -> i64 ="), &call).has_value);
+    // More integer arguments than registers
+    r = parse_typed_call(
+        Str("(i64 1, i64 2, i64 3, i64 4, i64 5, i64 6, i64 7)"), &call
+    );
+    assert(!r.has_value);
+}
+
+TEST(parse_command_typed_call) {
+    auto r = command_parse(Str("call lib.add(i64 2, i64 3) -> i64 # comment"));
+
+    assert(r.has_value);
+    assert(r.value.type == COMMAND_TYPE_CALL);
+    assert(str_eq(r.value.content, Str("lib.add")));
+    assert(str_eq(r.value.alias, Str("lib")));
+    assert(str_eq(r.value.signature, Str("(i64 2, i64 3) -> i64")));
+    assert(str_eq(r.tail, Str(" # comment")));
+
+    r = command_parse(Str("call foo"));
+
+    assert(r.has_value);
+    assert(0 == r.value.signature.len);
+
+    assert(!command_parse(Str("call add(i64 x)")).has_value);
+}
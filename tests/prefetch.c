@@ -0,0 +1,25 @@
+#include "libtest/macros.h"
+
+#include <assert.h>
+#include <prefetch.h>
+
+TEST(prefetch_file) {
+    assert(prefetch_file(Str("build/libtest1.so")));
+    assert(!prefetch_file(Str("build/nonexistent.so")));
+}
+
+TEST(prefetcher_start_and_stop) {
+    Prefetcher prefetcher;
+
+    prefetcher_start(&prefetcher, Str("examples/multiple.sc"));
+    prefetcher_stop(&prefetcher);
+
+    assert(!prefetcher.is_running);
+}
+
+TEST(prefetcher_missing_script) {
+    Prefetcher prefetcher;
+
+    prefetcher_start(&prefetcher, Str("examples/nonexistent.sc"));
+    prefetcher_stop(&prefetcher);
+}
@@ -0,0 +1,32 @@
+#include "libtest/macros.h"
+
+#include <assert.h>
+#include <elf_image.h>
+#include <probes.h>
+
+TEST(probes_notes) {
+    // Built with the same options as the tests, so probes are in both or none
+    auto result = elf_image_open(Str("build/sotest"));
+    assert(ELF_SUCCESS == result.status);
+
+    auto image = &result.value;
+    char const* names[] = {
+        "line_read",        "command_parsed",    "library_load_start",
+        "library_load_end", "symbol_cache_hit",  "symbol_cache_miss",
+        "call_entry",       "call_exit",
+    };
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(*names); ++i) {
+        auto name = str_from_ptr((char*) names[i]);
+        auto has_probe = elf_image_has_probe(image, Str("sotest"), name);
+        assert(PROBES_ENABLED == has_probe);
+    }
+
+    assert(!elf_image_has_probe(image, Str("sotest"), Str("nonexistent")));
+    assert(!elf_image_has_probe(image, Str("other"), Str("call_entry")));
+
+    // Untraced, the semaphores stay down
+    assert(!PROBE_IS_ENABLED(call_exit));
+
+    elf_image_free(image);
+}
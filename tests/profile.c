@@ -0,0 +1,53 @@
+#include "libtest/macros.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <interpreter.h>
+#include <profile.h>
+
+TEST(profiler_folded_stacks) {
+    auto executor = executor_new();
+    auto load_result =
+        executor_load_library(&executor, Str("build/libtest1.so"));
+    assert(EXECUTOR_SUCCESS == load_result.status);
+
+    auto resolved = executor_resolve_function(&executor, Str("spin"));
+    assert(EXECUTOR_SUCCESS == resolved.result.status);
+    auto spin = (unsigned long (*)(unsigned long)) resolved.function;
+
+    auto output = tmpfile();
+    Profiler profiler;
+    assert(profiler_start(&profiler, output, 10000));
+
+    // One sampler per process, the signal handler has no context
+    Profiler other;
+    assert(!profiler_start(&other, output, 10000));
+    assert(EBUSY == errno);
+
+    profiler_begin(&profiler, 7);
+    spin(20000000);
+    profiler_end(&profiler);
+
+    // Not sampled between commands
+    spin(20000000);
+
+    assert(0 == profiler_stop(&profiler));
+
+    char folded[4096];
+    rewind(output);
+    auto len = fread(folded, 1, sizeof(folded) - 1, output);
+    folded[len] = '\0';
+    fclose(output);
+
+    // Interpreter frames are left out, every stack is rooted at the line
+    assert(0 == strncmp(folded, "line 7;", 7));
+    assert(nullptr != strstr(folded, ";spin"));
+    assert(nullptr == strstr(folded, "profiler_folded_stacks"));
+
+    for (auto line = folded; '\0' != *line; line = strchr(line, '\n') + 1) {
+        assert(0 == strncmp(line, "line 7;", 7));
+    }
+
+    executor_free(&executor);
+}
@@ -0,0 +1,142 @@
+#include "libtest/macros.h"
+
+#include <assert.h>
+#include <unistd.h>
+#include <program.h>
+
+static ProgramAddResult program_add_line(
+    Program* program, Executor* executor, char* line
+) {
+    auto command = command_parse(str_from_ptr(line)).value;
+
+    return program_add(program, executor, &command);
+}
+
+TEST(program_add_repeat_block) {
+    auto executor = executor_new();
+    assert(
+        EXECUTOR_SUCCESS ==
+        executor_load_library(&executor, Str("build/libtest1.so")).status
+    );
+
+    auto program = PROGRAM_EMPTY;
+
+    assert(
+        PROGRAM_ADDED ==
+        program_add_line(&program, &executor, "repeat 3 {").status
+    );
+    assert(program_is_open(&program));
+    assert(
+        PROGRAM_ADDED ==
+        program_add_line(&program, &executor, "call foo").status
+    );
+    assert(
+        PROGRAM_ADDED ==
+        program_add_line(&program, &executor, "repeat 2 call bar").status
+    );
+
+    auto added = program_add_line(&program, &executor, "call nope");
+    assert(PROGRAM_NOT_RESOLVED == added.status);
+    assert(EXECUTOR_FIND_SYMBOL_FAILED == added.result.status);
+    assert(str_eq(added.command.content, Str("nope")));
+
+    added = program_add_line(&program, &executor, "use build/libtest2.so");
+    assert(PROGRAM_NOT_ALLOWED == added.status);
+
+    assert(PROGRAM_ADDED == program_add_line(&program, &executor, "}").status);
+    assert(!program_is_open(&program));
+
+    assert(4 == program.len);
+    assert(PROGRAM_OP_REPEAT == program.ptr[0].type);
+    assert(3 == program.ptr[0].count);
+    assert(3 == program.ptr[0].body_len);
+    assert(PROGRAM_OP_CALL == program.ptr[1].type);
+    assert(PROGRAM_OP_REPEAT == program.ptr[2].type);
+    assert(1 == program.ptr[2].body_len);
+
+    // Every call prints one line
+    auto output = tmpfile();
+    fflush(stdout);
+    auto stdout_fd = dup(STDOUT_FILENO);
+    dup2(fileno(output), STDOUT_FILENO);
+
+    program_run(&program);
+
+    fflush(stdout);
+    dup2(stdout_fd, STDOUT_FILENO);
+    close(stdout_fd);
+
+    rewind(output);
+    size_t n_lines = 0;
+
+    for (int symbol = 0; EOF != (symbol = fgetc(output));) {
+        n_lines += '\n' == symbol;
+    }
+
+    fclose(output);
+    assert(3 * (1 + 2) == n_lines);
+
+    // Calls in a mixed loop are only counted, a loop of one function is timed
+    assert(3 == program.ptr[1].stats->n_calls);
+    assert(0 == program.ptr[1].stats->n_timed);
+    assert(6 == program.ptr[3].stats->n_calls);
+    assert(6 == program.ptr[3].stats->n_timed);
+
+    program_clear(&program);
+    assert(0 == program.len);
+
+    assert(
+        PROGRAM_UNEXPECTED_END ==
+        program_add_line(&program, &executor, "}").status
+    );
+
+    program_free(&program);
+    executor_free(&executor);
+}
+
+TEST(program_reuses_thunks) {
+    auto executor = executor_new();
+    assert(
+        EXECUTOR_SUCCESS ==
+        executor_load_library(&executor, Str("build/libtest1.so")).status
+    );
+
+    auto program = PROGRAM_EMPTY;
+
+    assert(
+        PROGRAM_ADDED ==
+        program_add_line(&program, &executor, "repeat 3 call add").status
+    );
+
+    auto jit = program.ptr[0].jit;
+
+    // No thunks on platforms without the JIT
+    if (nullptr == jit.entry) {
+        program_free(&program);
+        executor_free(&executor);
+        return;
+    }
+
+    // The same line once more, as in a script run many times
+    program_clear(&program);
+    assert(
+        PROGRAM_ADDED ==
+        program_add_line(&program, &executor, "repeat 3 call add").status
+    );
+    assert(jit.entry == program.ptr[0].jit.entry);
+    assert(1 == program.thunks.len);
+
+    // Another count is another loop
+    program_clear(&program);
+    assert(
+        PROGRAM_ADDED ==
+        program_add_line(&program, &executor, "repeat 4 call add").status
+    );
+    assert(jit.entry != program.ptr[0].jit.entry);
+    assert(2 == program.thunks.len);
+
+    program_run(&program);
+
+    program_free(&program);
+    executor_free(&executor);
+}
@@ -0,0 +1,86 @@
+#include "libtest/macros.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <report.h>
+
+TEST(report_format_parse) {
+    ReportFormat format = REPORT_FORMAT_TEXT;
+
+    assert(report_format_parse(Str("jsonl"), &format));
+    assert(REPORT_FORMAT_JSONL == format);
+    assert(report_format_parse(Str("text"), &format));
+    assert(REPORT_FORMAT_TEXT == format);
+    assert(!report_format_parse(Str("json"), &format));
+}
+
+TEST(reporter_jsonl) {
+    auto reporter = (Reporter) {
+        .format = REPORT_FORMAT_JSONL,
+        .stream = tmpfile(),
+    };
+
+    auto command = (Command) {
+        .type = COMMAND_TYPE_CALL,
+        .content = Str("foo"),
+    };
+
+    reporter_begin(&reporter);
+    reporter_end(
+        &reporter, 3, &command, (ExecutorResult) {.status = EXECUTOR_SUCCESS}
+    );
+
+    command.type = COMMAND_TYPE_USE;
+    command.content = Str("lib\"1\".so");
+
+    reporter_begin(&reporter);
+    reporter_end(
+        &reporter, 4, &command,
+        (ExecutorResult) {
+            .status = EXECUTOR_LOAD_FAILED,
+            .dl_error = Str("no\tsuch\nfile"),
+        }
+    );
+
+    reporter_parse_error(&reporter, 5, Str("cal foo"));
+
+    char records[512] = {};
+    rewind(reporter.stream);
+    fread(records, 1, sizeof(records) - 1, reporter.stream);
+    reporter_free(&reporter);
+
+    // Durations differ between runs, compare the records up to them
+    auto first = strstr(records, ", \"duration_ns\": ");
+    assert(nullptr != first);
+    *first = '\0';
+    assert(
+        0 == strcmp(
+                 records,
+                 "{\"line\": 3, \"type\": \"call\", \"target\": \"foo\", "
+                 "\"status\": \"EXECUTOR_SUCCESS\", \"dl_error\": null"
+             )
+    );
+
+    auto second = strchr(first + 1, '\n') + 1;
+    auto second_end = strstr(second, ", \"duration_ns\": ");
+    assert(nullptr != second_end);
+    *second_end = '\0';
+    assert(
+        0 == strcmp(
+                 second,
+                 "{\"line\": 4, \"type\": \"use\", \"target\": "
+                 "\"lib\\\"1\\\".so\", \"status\": \"EXECUTOR_LOAD_FAILED\", "
+                 "\"dl_error\": \"no\\tsuch\\nfile\""
+             )
+    );
+
+    auto third = strchr(second_end + 1, '\n') + 1;
+    assert(
+        0 == strcmp(
+                 third,
+                 "{\"line\": 5, \"type\": null, \"target\": \"cal foo\", "
+                 "\"status\": \"PARSE_FAILED\", \"dl_error\": \"failed to "
+                 "parse as `CommandLine`\", \"duration_ns\": 0}\n"
+             )
+    );
+}
@@ -0,0 +1,153 @@
+#include "libtest/macros.h"
+
+#include <assert.h>
+#include <sotest.h>
+#include <string.h>
+
+typedef struct Results {
+    SotestStatus statuses[16];
+    size_t line_numbers[16];
+    size_t len;
+    char output[256];
+    size_t output_len;
+} Results;
+
+static void results_add(void* context, SotestResult const* result) {
+    Results* self = context;
+    assert(self->len < 16);
+
+    self->statuses[self->len] = result->status;
+    self->line_numbers[self->len] = result->line_number;
+    self->len += 1;
+
+    assert((SOTEST_SUCCESS == result->status) == (nullptr == result->error));
+    assert((SOTEST_PARSE_FAILED == result->status) == (nullptr == result->type));
+}
+
+static void results_write(void* context, char const* ptr, size_t len) {
+    Results* self = context;
+    assert(self->output_len + len < sizeof(self->output));
+
+    memcpy(self->output + self->output_len, ptr, len);
+    self->output_len += len;
+}
+
+static Sotest* results_sotest(Results* results) {
+    return sotest_new((SotestOptions) {
+        .callbacks =
+            {
+                .on_result = results_add,
+                .on_output = results_write,
+                .context = results,
+            },
+    });
+}
+
+TEST(sotest_execute_script) {
+    auto results = (Results) {};
+    auto sotest = results_sotest(&results);
+
+    auto source = "use build/libtest1.so\n"
+                  "# comment\n"
+                  "call missing\n"
+                  "cal foo\n"
+                  "call add(i64 2, i64 3) -> i64\n"
+                  "call add(i64 2, i64 3) -> i64 = 5";
+    auto script = sotest_compile(source, strlen(source));
+    assert(6 == sotest_script_len(script));
+
+    assert(sotest_execute(sotest, script));
+    assert(5 == results.len);
+    assert(SOTEST_SUCCESS == results.statuses[0]);
+    assert(SOTEST_FIND_SYMBOL_FAILED == results.statuses[1]);
+    assert(3 == results.line_numbers[1]);
+    assert(SOTEST_PARSE_FAILED == results.statuses[2]);
+    assert(SOTEST_SUCCESS == results.statuses[3]);
+    assert(6 == results.line_numbers[4]);
+    assert(9 == results.output_len);
+    assert(0 == memcmp(results.output, "add -> 5\n", 9));
+
+    // The same script once more, the library stays loaded
+    results.len = 0;
+    assert(sotest_execute(sotest, script));
+    assert(5 == results.len);
+    assert(1 == results.line_numbers[0]);
+
+    sotest_script_free(script);
+    sotest_free(sotest);
+}
+
+TEST(sotest_execute_failed_check) {
+    auto results = (Results) {};
+    auto sotest = results_sotest(&results);
+
+    auto source = "use build/libtest1.so\n"
+                  "call add(i64 2, i64 3) -> i64 = 6\n"
+                  "exit\n"
+                  "call foo\n";
+    auto script = sotest_compile(source, strlen(source));
+
+    assert(!sotest_execute(sotest, script));
+    assert(2 == results.len);
+    assert(SOTEST_ASSERTION_FAILED == results.statuses[1]);
+
+    sotest_script_free(script);
+    sotest_free(sotest);
+}
+
+TEST(sotest_execute_line) {
+    auto results = (Results) {};
+    auto sotest = results_sotest(&results);
+
+    auto line = "use build/libtest1.so";
+    assert(SOTEST_SUCCESS == sotest_execute_line(sotest, line, strlen(line)));
+
+    line = "def twice {";
+    assert(SOTEST_SUCCESS == sotest_execute_line(sotest, line, strlen(line)));
+    line = "call missing";
+    assert(SOTEST_SUCCESS == sotest_execute_line(sotest, line, strlen(line)));
+    line = "}";
+    assert(SOTEST_SUCCESS == sotest_execute_line(sotest, line, strlen(line)));
+
+    line = "run twice";
+    assert(
+        SOTEST_FIND_SYMBOL_FAILED ==
+        sotest_execute_line(sotest, line, strlen(line))
+    );
+
+    line = "repeat 2 {";
+    assert(SOTEST_SUCCESS == sotest_execute_line(sotest, line, strlen(line)));
+
+    // The open block is reported and dropped
+    results.len = 0;
+    sotest_finish(sotest);
+    assert(1 == results.len);
+    assert(SOTEST_PARSE_FAILED == results.statuses[0]);
+
+    line = "exit";
+    assert(SOTEST_EXIT == sotest_execute_line(sotest, line, strlen(line)));
+
+    sotest_free(sotest);
+}
+
+TEST(sotest_independent_instances) {
+    Results results[2] = {};
+    Sotest* instances[2] = {
+        results_sotest(&results[0]),
+        results_sotest(&results[1]),
+    };
+
+    auto line = "use build/libtest2.so";
+    sotest_execute_line(instances[1], line, strlen(line));
+
+    // `qux` is only in the second library, loaded by the second instance
+    line = "call qux";
+    assert(
+        SOTEST_LIBRARY_NOT_LOADED ==
+        sotest_execute_line(instances[0], line, strlen(line))
+    );
+    assert(SOTEST_SUCCESS == sotest_execute_line(instances[1], line, strlen(line)));
+
+    sotest_free(instances[0]);
+    sotest_free(instances[1]);
+}
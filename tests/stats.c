@@ -0,0 +1,58 @@
+#include "libtest/macros.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stats.h>
+
+static bool is_close(double a, double b) { return fabs(a - b) < 1e-3; }
+
+TEST(stats_percentile) {
+    double values[] = {5.0, 1.0, 4.0, 2.0, 3.0};
+    size_t constexpr LEN = sizeof(values) / sizeof(*values);
+
+    stats_sort(values, LEN);
+
+    assert(is_close(stats_percentile(values, LEN, 0.0), 1.0));
+    assert(is_close(stats_percentile(values, LEN, 100.0), 5.0));
+    assert(is_close(stats_percentile(values, LEN, 25.0), 2.0));
+    assert(is_close(stats_percentile(values, LEN, 90.0), 4.6));
+    assert(is_close(stats_median(values, LEN), 3.0));
+    assert(is_close(stats_mean(values, LEN), 3.0));
+    assert(is_close(stats_mad(values, LEN), 1.0));
+    assert(isnan(stats_median(values, 0)));
+}
+
+TEST(stats_mann_whitney) {
+    double first[] = {1.0, 2.0, 3.0};
+    double second[] = {4.0, 5.0, 6.0};
+
+    auto r = stats_mann_whitney(first, 3, second, 3);
+
+    assert(is_close(r.u, 0.0));
+    assert(r.z < 0.0);
+    assert(is_close(r.p_value, 0.0809));
+
+    r = stats_mann_whitney(second, 3, first, 3);
+
+    assert(is_close(r.u, 9.0));
+    assert(r.z > 0.0);
+
+    // All values tied
+    double same[] = {1.0, 1.0, 1.0};
+    r = stats_mann_whitney(same, 3, same, 3);
+
+    assert(is_close(r.p_value, 1.0));
+}
+
+TEST(stats_bootstrap_median_ratio) {
+    double numerator[] = {20.0, 20.0, 20.0, 20.0};
+    double denominator[] = {10.0, 10.0, 10.0, 10.0};
+    auto random = stats_random_new(42);
+
+    auto r = stats_bootstrap_median_ratio(
+        numerator, 4, denominator, 4, 0.95, 100, &random
+    );
+
+    assert(is_close(r.low, 2.0));
+    assert(is_close(r.high, 2.0));
+}
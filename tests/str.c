@@ -0,0 +1,153 @@
+#include "libtest/macros.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <string.h>
+
+TEST(str_compare) {
+    auto a = Str("foo");
+    auto b = Str("foo # comment");
+    auto prefix = str_slice(b, 0, 3);
+
+    assert(0 == str_compare(&a, &prefix));
+    assert(0 > str_compare(&a, &b));
+    assert(0 < str_compare(&b, &a));
+
+    auto c = Str("bar");
+    assert(0 < str_compare(&a, &c));
+
+    auto empty = Str("");
+    assert(0 == str_compare(&empty, &STR_NULL));
+    assert(0 < str_compare(&a, &empty));
+}
+
+TEST(string_push_growth) {
+    auto string = STRING_EMPTY;
+    size_t n_grown = 0;
+
+    for (size_t i = 0; i < 1 << 20; ++i) {
+        auto cap = string.cap;
+        string_push(&string, (char) ('a' + i % 26));
+        n_grown += cap != string.cap;
+    }
+
+    assert(1 << 20 == string.str.len);
+    assert('\0' == string.str.ptr[string.str.len]);
+    // Allocated once and then doubled from 16 bytes to 2 MiB, not squared
+    assert(18 == n_grown);
+    assert(string.cap <= STRING_GROWTH_RATE * (string.str.len + 1));
+
+    string_free(&string);
+}
+
+TEST(string_readline_long_line) {
+    size_t constexpr LEN = 1 << 20;
+    auto script = (char*) malloc(LEN + 16);
+    memset(script, 'x', LEN);
+    memcpy(script + LEN, "\ncall foo", 9);
+
+    auto stream = fmemopen(script, LEN + 9, "r");
+    auto line = STRING_EMPTY;
+
+    assert(READLINE_SUCCESS == string_readline(&line, stream));
+    assert(LEN == line.str.len);
+    assert(line.cap <= STRING_GROWTH_RATE * (LEN + 1));
+    assert('x' == line.str.ptr[LEN - 1]);
+    assert('\0' == line.str.ptr[LEN]);
+
+    string_clear(&line);
+    auto cap = line.cap;
+
+    // The last line has no newline, it is read up to the end
+    assert(READLINE_EOF == string_readline(&line, stream));
+    assert(str_eq(line.str, Str("call foo")));
+    assert(cap == line.cap);
+
+    fclose(stream);
+    string_free(&line);
+    free(script);
+}
+
+TEST(string_clear_reuses_buffer) {
+    auto key = STRING_EMPTY;
+    string_append(&key, Str("function_name"));
+
+    auto ptr = key.str.ptr;
+    auto cap = key.cap;
+
+    // Many short keys in turn fit the first buffer
+    for (size_t i = 0; i < 1000; ++i) {
+        string_clear(&key);
+        assert('\0' == key.str.ptr[0]);
+
+        string_append(&key, 0 == i % 2 ? Str("foo") : Str("bar"));
+        string_push(&key, '_');
+        assert(4 == key.str.len);
+    }
+
+    assert(ptr == key.str.ptr);
+    assert(cap == key.cap);
+
+    string_free(&key);
+}
+
+TEST(string_borrowed) {
+    char buffer[] = "foo";
+    auto borrowed = (String) {
+        .str = {.ptr = buffer, .len = 3},
+        .cap = 0,
+    };
+
+    // Copied on the first change, the borrowed buffer stays as it was
+    string_push(&borrowed, 'd');
+    assert(str_eq(borrowed.str, Str("food")));
+    assert(buffer != borrowed.str.ptr);
+    assert(0 == strcmp(buffer, "foo"));
+
+    assert('d' == string_pop(&borrowed));
+    assert('\0' == borrowed.str.ptr[3]);
+    string_free(&borrowed);
+
+    // Nothing is freed for a borrowed string
+    borrowed = (String) {.str = {.ptr = buffer, .len = 3}, .cap = 0};
+    string_free(&borrowed);
+    assert(nullptr == borrowed.str.ptr);
+
+    auto empty = STRING_EMPTY;
+    string_append(&empty, STR_NULL);
+    assert(nullptr != empty.str.ptr);
+    assert('\0' == empty.str.ptr[0]);
+    string_free(&empty);
+}
+
+BENCH(string_readline_long_line) {
+    size_t constexpr LEN = 1 << 16;
+    char script[LEN + 1];
+    memset(script, 'x', LEN);
+    script[LEN] = '\n';
+
+    auto line = STRING_EMPTY;
+
+    BENCH_LOOP {
+        auto stream = fmemopen(script, sizeof(script), "r");
+        string_clear(&line);
+        black_box(string_readline(&line, stream));
+        fclose(stream);
+    }
+
+    string_free(&line);
+}
+
+BENCH(string_append_short_keys) {
+    Str keys[] = {Str("foo"), Str("bar"), Str("baz"), Str("qux")};
+    size_t i = 0;
+
+    BENCH_LOOP {
+        auto key = STRING_EMPTY;
+        string_append(&key, black_box(keys[i++ % 4]));
+        black_box(key.str.ptr);
+        string_free(&key);
+    }
+}
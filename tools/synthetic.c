@@ -0,0 +1,170 @@
+// Generates sources of synthetic shared libraries and matching scripts for
+// scaling tests and benchmarks, driven by `SOTEST_SYNTHETIC` in CMake
+//
+// Library `i` exports `n_shared` functions named `shared_<j>`, present in
+// every library, and `n_functions - n_shared` functions named `lib<i>_<j>`
+// unique to it.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void print_usage(char const* program) {
+    fprintf(
+        stderr,
+        "Usage:\n"
+        "  %s library <INDEX> <FUNCTIONS> <SHARED> <OUTPUT.c>\n"
+        "  %s script <LIBRARIES> <FUNCTIONS> <SHARED> <LINES> <PREFIX> "
+        "<OUTPUT.sc>\n"
+        "\n"
+        "Libraries are expected at `<PREFIX><INDEX>.so`\n",
+        program, program
+    );
+}
+
+static bool parse_size(char const* source, size_t* value) {
+    char* end = nullptr;
+    auto result = strtoull(source, &end, 10);
+
+    if (end == source || '\0' != *end || '-' == source[0]) {
+        fprintf(stderr, "error: '%s' is not a non-negative integer\n", source);
+        return false;
+    }
+
+    *value = (size_t) result;
+    return true;
+}
+
+static void write_function_name(
+    FILE* output, size_t library, size_t function, size_t n_shared
+) {
+    if (function < n_shared) {
+        fprintf(output, "shared_%zu", function);
+    } else {
+        fprintf(output, "lib%zu_%zu", library, function);
+    }
+}
+
+static int generate_library(
+    size_t index, size_t n_functions, size_t n_shared, FILE* output
+) {
+    // Distinct bodies, so the linker can not fold the functions together
+    fprintf(
+        output,
+        "// Generated by tools/synthetic.c, do not edit\n\n"
+        "int synthetic_counter_%zu;\n\n",
+        index
+    );
+
+    for (size_t i = 0; i < n_functions; ++i) {
+        fputs("void ", output);
+        write_function_name(output, index, i, n_shared);
+        fprintf(output, "() { synthetic_counter_%zu += %zu; }\n", index, i);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static uint64_t xorshift(uint64_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return *state;
+}
+
+static int generate_script(
+    size_t n_libraries, size_t n_functions, size_t n_shared, size_t n_lines,
+    char const* prefix, FILE* output
+) {
+    fputs("# Generated by tools/synthetic.c, do not edit\n\n", output);
+
+    for (size_t i = 0; i < n_libraries; ++i) {
+        fprintf(output, "use %s%zu.so\n", prefix, i);
+    }
+
+    if (0 == n_libraries || 0 == n_functions) {
+        return EXIT_SUCCESS;
+    }
+
+    // Fixed seed, the same configuration always gives the same script
+    uint64_t state = 0x9e3779b97f4a7c15;
+
+    for (size_t i = 0; i < n_lines; ++i) {
+        auto random = xorshift(&state);
+
+        // Mostly calls, some comments and empty lines like hand-written ones
+        switch (random % 16) {
+        case 0:
+            fputs("# comment line\n", output);
+            continue;
+        case 1:
+            fputc('\n', output);
+            continue;
+        }
+
+        auto library = (size_t) (xorshift(&state) % n_libraries);
+        auto function = (size_t) (xorshift(&state) % n_functions);
+
+        fputs("call ", output);
+        write_function_name(output, library, function, n_shared);
+
+        if (2 == random % 16) {
+            fputs(" # trailing comment", output);
+        }
+
+        fputc('\n', output);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto is_library = 0 == strcmp(argv[1], "library") && 6 == argc;
+    auto is_script = 0 == strcmp(argv[1], "script") && 8 == argc;
+
+    if (!is_library && !is_script) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    size_t sizes[4] = {};
+    size_t n_sizes = is_library ? 3 : 4;
+
+    for (size_t i = 0; i < n_sizes; ++i) {
+        if (!parse_size(argv[2 + i], &sizes[i])) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto path = argv[argc - 1];
+    auto output = fopen(path, "w");
+
+    if (nullptr == output) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+
+    auto n_functions = sizes[1];
+    auto n_shared = sizes[2] < n_functions ? sizes[2] : n_functions;
+
+    auto status =
+        is_library
+            ? generate_library(sizes[0], n_functions, n_shared, output)
+            : generate_script(
+                  sizes[0], n_functions, n_shared, sizes[3], argv[6], output
+              );
+
+    if (0 != fclose(output)) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+
+    return status;
+}
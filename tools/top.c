@@ -0,0 +1,308 @@
+// Shows the live counters of a running interpreter started with `--monitor`,
+// refreshed every interval. Attaches read-only, the interpreter is not
+// slowed down by it.
+
+#include "monitor.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/// Busiest functions shown
+size_t constexpr TOP_ROWS = 20;
+
+/// Counters at one refresh, rates are the differences of two snapshots
+typedef struct TopSnapshot {
+    uint64_t time_ns;
+    uint64_t n_lines;
+    uint64_t n_calls;
+    uint64_t n_cache_hits;
+    uint64_t n_cache_misses;
+    uint64_t n_libraries;
+    size_t n_functions;
+    uint64_t function_calls[MONITOR_MAX_FUNCTIONS];
+    uint64_t function_ns[MONITOR_MAX_FUNCTIONS];
+} TopSnapshot;
+
+typedef struct TopRow {
+    size_t slot;
+    double rate;
+} TopRow;
+
+static void print_usage(char const* program) {
+    fprintf(
+        stderr,
+        "Usage: %s [-n <COUNT>] [-i <SECONDS>] [PID]\n"
+        "\n"
+        "Shows the live counters of `sotest --monitor` with the process id,\n"
+        "the latest started one if not given\n"
+        "\n"
+        "Options:\n"
+        "  -n <COUNT>    stop after COUNT refreshes\n"
+        "  -i <SECONDS>  time between refreshes (default 1)\n",
+        program
+    );
+}
+
+static bool parse_size(char const* source, size_t* value) {
+    char* end = nullptr;
+
+    if (nullptr == source) {
+        return false;
+    }
+
+    auto result = strtoull(source, &end, 10);
+
+    if (end == source || '\0' != *end || '-' == source[0]) {
+        return false;
+    }
+
+    *value = (size_t) result;
+    return true;
+}
+
+static bool parse_seconds(char const* source, double* value) {
+    char* end = nullptr;
+
+    if (nullptr == source) {
+        return false;
+    }
+
+    errno = 0;
+    *value = strtod(source, &end);
+
+    return end != source && '\0' == *end && 0 == errno && *value >= 0;
+}
+
+/// Only a missing process counts, one of another user can not be signalled
+static bool top_is_running(pid_t pid) {
+    return 0 == kill(pid, 0) || ESRCH != errno;
+}
+
+/// Attaches to the segment of the latest started interpreter still running
+static bool top_attach_latest(Monitor* monitor) {
+    auto directory = opendir("/dev/shm");
+
+    if (nullptr == directory) {
+        return false;
+    }
+
+    uint64_t latest_start_ns = 0;
+    pid_t latest_pid = 0;
+
+    for (auto entry = readdir(directory); nullptr != entry;
+         entry = readdir(directory))
+    {
+        int pid = 0;
+        int len = 0;
+
+        if (1 != sscanf(entry->d_name, "sotest-%d%n", &pid, &len) ||
+            '\0' != entry->d_name[len] || !top_is_running(pid))
+        {
+            continue;
+        }
+
+        auto candidate = (Monitor) {};
+
+        if (!monitor_attach(&candidate, pid)) {
+            continue;
+        }
+
+        if (candidate.segment->start_ns >= latest_start_ns) {
+            latest_start_ns = candidate.segment->start_ns;
+            latest_pid = pid;
+        }
+
+        monitor_detach(&candidate);
+    }
+
+    closedir(directory);
+
+    if (0 == latest_pid) {
+        errno = ENOENT;
+        return false;
+    }
+
+    return monitor_attach(monitor, latest_pid);
+}
+
+static void top_snapshot(MonitorSegment const* segment, TopSnapshot* out) {
+    out->time_ns = monitor_now_ns();
+    out->n_functions = atomic_load_explicit(
+        &segment->n_functions.value, memory_order_acquire
+    );
+    out->n_lines = monitor_load(&segment->n_lines);
+    out->n_calls = monitor_load(&segment->n_calls);
+    out->n_cache_hits = monitor_load(&segment->n_cache_hits);
+    out->n_cache_misses = monitor_load(&segment->n_cache_misses);
+    out->n_libraries = monitor_load(&segment->n_libraries);
+
+    for (size_t i = 0; i < out->n_functions; ++i) {
+        auto function = &segment->functions[i];
+        out->function_calls[i] =
+            atomic_load_explicit(&function->n_calls, memory_order_relaxed);
+        out->function_ns[i] =
+            atomic_load_explicit(&function->total_ns, memory_order_relaxed);
+    }
+}
+
+static int compare_rows(void const* a, void const* b) {
+    auto x = ((TopRow const*) a)->rate;
+    auto y = ((TopRow const*) b)->rate;
+
+    return (x < y) - (x > y);
+}
+
+static void top_print(
+    MonitorSegment const* segment, TopSnapshot const* previous,
+    TopSnapshot const* current, bool is_finished
+) {
+    auto seconds = (double) (current->time_ns - previous->time_ns) / 1e9;
+    auto per_second = seconds > 0 ? 1 / seconds : 0;
+    auto n_lookups = current->n_cache_hits + current->n_cache_misses;
+
+    printf(
+        "sotest %d  up %.1f s  %s\n\n", (int) segment->pid,
+        (double) (current->time_ns - segment->start_ns) / 1e9,
+        is_finished ? "finished" : "running"
+    );
+    printf(
+        "lines      %12llu  %12.1f/s\n", (unsigned long long) current->n_lines,
+        (double) (current->n_lines - previous->n_lines) * per_second
+    );
+    printf(
+        "calls      %12llu  %12.1f/s\n", (unsigned long long) current->n_calls,
+        (double) (current->n_calls - previous->n_calls) * per_second
+    );
+    printf(
+        "cache hits %11.1f%%  (%llu of %llu lookups)\n",
+        0 == n_lookups ? 0.0
+                       : 100.0 * (double) current->n_cache_hits /
+                             (double) n_lookups,
+        (unsigned long long) current->n_cache_hits,
+        (unsigned long long) n_lookups
+    );
+    printf(
+        "libraries  %12llu\n\n", (unsigned long long) current->n_libraries
+    );
+
+    TopRow rows[MONITOR_MAX_FUNCTIONS];
+
+    for (size_t i = 0; i < current->n_functions; ++i) {
+        auto previous_calls =
+            i < previous->n_functions ? previous->function_calls[i] : 0;
+
+        rows[i] = (TopRow) {
+            .slot = i,
+            .rate = (double) (current->function_calls[i] - previous_calls) *
+                    per_second,
+        };
+    }
+
+    qsort(rows, current->n_functions, sizeof(*rows), compare_rows);
+
+    printf(
+        "%-32s %12s %12s %12s %10s\n", "function", "calls", "calls/s",
+        "total ms", "mean ns"
+    );
+
+    auto n_rows =
+        current->n_functions < TOP_ROWS ? current->n_functions : TOP_ROWS;
+
+    for (size_t i = 0; i < n_rows; ++i) {
+        auto slot = rows[i].slot;
+        auto n_calls = current->function_calls[slot];
+        auto total_ns = current->function_ns[slot];
+
+        printf(
+            "%-32.32s %12llu %12.1f %12.3f %10.1f\n",
+            segment->functions[slot].name, (unsigned long long) n_calls,
+            rows[i].rate, (double) total_ns / 1e6,
+            0 == n_calls ? 0.0 : (double) total_ns / (double) n_calls
+        );
+    }
+
+    fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+    size_t n_refreshes = 0;
+    double interval = 1;
+    size_t pid = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (0 == strcmp(argv[i], "-n") &&
+            parse_size(argv[i + 1], &n_refreshes))
+        {
+            i += 1;
+        } else if (0 == strcmp(argv[i], "-i") &&
+                   parse_seconds(argv[i + 1], &interval))
+        {
+            i += 1;
+        } else if (0 == pid && parse_size(argv[i], &pid) && 0 != pid) {
+            continue;
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto monitor = (Monitor) {};
+    auto is_attached =
+        0 == pid ? top_attach_latest(&monitor)
+                 : monitor_attach(&monitor, (pid_t) pid);
+
+    if (!is_attached) {
+        fprintf(
+            stderr, "error: no interpreter to attach to: %s\n",
+            strerror(errno)
+        );
+        return EXIT_FAILURE;
+    }
+
+    auto segment = monitor.segment;
+    auto is_terminal = isatty(STDOUT_FILENO);
+    auto snapshots = (TopSnapshot*) calloc(2, sizeof(TopSnapshot));
+    auto previous = &snapshots[0];
+    auto current = &snapshots[1];
+
+    top_snapshot(segment, previous);
+    previous->time_ns = segment->start_ns;
+
+    for (size_t i = 0; 0 == n_refreshes || i < n_refreshes; ++i) {
+        usleep((useconds_t) (interval * 1e6));
+
+        auto is_finished =
+            0 != atomic_load_explicit(
+                     &segment->is_finished, memory_order_acquire
+                 ) ||
+            !top_is_running(segment->pid);
+
+        top_snapshot(segment, current);
+
+        if (is_terminal) {
+            fputs("\033[H\033[J", stdout);
+        } else if (0 != i) {
+            putchar('\n');
+        }
+
+        top_print(segment, previous, current, is_finished);
+
+        if (is_finished) {
+            break;
+        }
+
+        auto swap = previous;
+        previous = current;
+        current = swap;
+    }
+
+    free(snapshots);
+    monitor_detach(&monitor);
+
+    return EXIT_SUCCESS;
+}